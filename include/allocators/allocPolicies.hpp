@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+
+#include "allocators/poolAllocator.hpp" // PoolStats
+#include "utils/histogram.hpp"
+
+// Compile-time feature policies for BasicPool / BasicArena. A policy is a small
+// (usually empty) struct that implements only the hooks it needs; the allocator
+// detects each hook with a requires-expression, so a policy list without a hook
+// costs nothing at that call site. Hooks run in the order the policies are listed.
+//
+//   void attach(std::size_t capacity);          // once, from the pool constructor
+//   void onFresh(void *p, std::size_t size);    // pool: block handed out for the first time
+//   void onAlloc(void *p, std::size_t size);    // after every successful allocation
+//   void onAllocFail();
+//   void onFree(void *p, std::size_t size);     // pool: before the block is released
+//   void *deferFree(void *p);                   // pool: block to push now (nullptr = hold it)
+//   void onReset();                             // arena: reset()/release()
+//   void fillStats(PoolStats &s) const;
+namespace alloc_policy
+{
+    // alloc/free/failure counts, in-use and high watermark. Plain integers: the
+    // Basic* allocators are single-threaded.
+    struct Counters
+    {
+        std::uint64_t alloc_calls = 0;
+        std::uint64_t free_calls = 0;
+        std::uint64_t alloc_failures = 0;
+        std::uint64_t in_use = 0;
+        std::uint64_t high_watermark = 0;
+
+        void onAlloc(void *, std::size_t)
+        {
+            ++alloc_calls;
+            high_watermark = std::max(high_watermark, ++in_use);
+        }
+        void onAllocFail()
+        {
+            ++alloc_calls;
+            ++alloc_failures;
+        }
+        void onFree(void *, std::size_t)
+        {
+            ++free_calls;
+            --in_use;
+        }
+        void onReset() { in_use = 0; }
+        void fillStats(PoolStats &s) const
+        {
+            s.alloc_calls = alloc_calls;
+            s.free_calls = free_calls;
+            s.alloc_failures = alloc_failures;
+            s.in_use = in_use;
+            s.high_watermark = high_watermark;
+        }
+    };
+
+    // Fills (sizeof(void*), end) of free and never-used blocks with Byte; the first
+    // word holds the free-list link. Verify checks the pattern again on allocation.
+    template <unsigned char Byte = 0xA5, bool Verify = true>
+    struct Poison
+    {
+        static void fill(void *p, std::size_t size)
+        {
+            if (size > sizeof(void *))
+                std::memset(static_cast<char *>(p) + sizeof(void *), Byte, size - sizeof(void *));
+        }
+        void onFresh(void *p, std::size_t size) { fill(p, size); }
+        void onFree(void *p, std::size_t size) { fill(p, size); }
+        void onAlloc(void *p, std::size_t size)
+        {
+            if constexpr (Verify)
+            {
+                const auto *b = static_cast<const unsigned char *>(p);
+                for (std::size_t i = sizeof(void *); i < size; ++i)
+                {
+                    if (b[i] != Byte)
+                    {
+                        std::cerr << "[POOL] Poison verification failed at byte " << i - sizeof(void *)
+                                  << " ptr=" << p << "\n";
+                        std::abort();
+                    }
+                }
+            }
+        }
+    };
+
+    struct Zero
+    {
+        void onAlloc(void *p, std::size_t size) { std::memset(p, 0, size); }
+    };
+
+    // Holds the last N freed blocks back from reuse (FIFO ring).
+    template <std::size_t N = 64>
+    struct Quarantine
+    {
+        static_assert(N > 0, "use no Quarantine policy instead of N = 0");
+        std::array<void *, N> ring{};
+        std::size_t head = 0;
+        std::size_t count = 0;
+
+        void *deferFree(void *p)
+        {
+            if (count < N)
+            {
+                ring[(head + count++) % N] = p;
+                return nullptr;
+            }
+            void *victim = ring[head];
+            ring[head] = p;
+            head = (head + 1) % N;
+            return victim;
+        }
+    };
+
+    // Callables run on allocation / before release, with (ptr, block size).
+    // Empty std::function members are skipped.
+    template <class OnAlloc, class OnFree = OnAlloc>
+    struct Hooks
+    {
+        OnAlloc on_alloc{};
+        OnFree on_free{};
+
+        void onAlloc(void *p, std::size_t size)
+        {
+            if constexpr (std::is_constructible_v<bool, const OnAlloc &>)
+            {
+                if (!static_cast<bool>(on_alloc))
+                    return;
+            }
+            on_alloc(p, size);
+        }
+        void onFree(void *p, std::size_t size)
+        {
+            if constexpr (std::is_constructible_v<bool, const OnFree &>)
+            {
+                if (!static_cast<bool>(on_free))
+                    return;
+            }
+            on_free(p, size);
+        }
+    };
+    using FunctionHooks = Hooks<std::function<void(void *ptr, std::size_t size)>>;
+
+    // Samples the number of live blocks after every alloc/free into a Histogram.
+    template <std::size_t Buckets = 64>
+    struct OccupancyHistogram
+    {
+        std::unique_ptr<Histogram> hist;
+        std::uint64_t live = 0;
+
+        void attach(std::size_t capacity) { hist = std::make_unique<Histogram>(0, capacity, Buckets); }
+        void onAlloc(void *, std::size_t)
+        {
+            if (hist)
+                hist->record(++live);
+        }
+        void onFree(void *, std::size_t)
+        {
+            if (hist)
+                hist->record(--live);
+        }
+        void onReset() { live = 0; }
+        const Histogram *histogram() const { return hist.get(); }
+    };
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <vector>
@@ -8,21 +10,50 @@
 #include <utility>
 #include <new>
 
+#include "utils/osMemory.hpp"
+
 struct ArenaOptions
 {
     std::size_t initial_chunk_size = 1 << 20; // 1 MiB
     double growth_factor = 2.0;               // next = ceil(prev * growth_factor)
     std::size_t max_chunk_size = 1 << 26;     // 64 MiB cap
 
-    bool guard_pages = false;
-    bool prefer_huge = false;
+    bool guard_pages = false; // PROT_NONE page on each side of every chunk (implies mmap backing)
+    bool prefer_huge = false; // mmap chunks 2 MiB aligned: MAP_HUGETLB, else madvise(MADV_HUGEPAGE)
+    bool populate = false;    // pre-fault chunks at acquisition (MAP_POPULATE); implies mmap backing
+    int numa_node = -1;       // >= 0: bind chunks to this node before first touch; implies mmap
 
     bool use_canaries = false;
     std::size_t canary_size = 0;
     std::uint8_t canary_byte = 0xCA;
+    bool verify_on_reset = false; // reset()/release() run verify() and abort on corruption
 
+    // Record allocations >= journal_threshold_bytes (and reset/release/rewind)
+    // with their call site into the calling thread's alloc_trace ring; read back
+    // with alloc_trace::drain(), events carry this arena as source.
     bool journaling = false;
     std::size_t journal_threshold_bytes = 0;
+
+    // Release mode: no BlockHeader, canaries or journal; allocate() is an inlined
+    // bump of the current chunk and blocks are packed at the requested alignment
+    // (not rounded up to max_align_t). use_canaries, journaling and
+    // verify_on_reset are ignored, and verify() has nothing to walk.
+    bool headerless = false;
+
+    // Round every allocation up to a multiple of pad_to bytes at pad_to alignment
+    // (rounded up to a power of two), e.g. 64: objects handed to different threads
+    // never share a cache line. 0 = pack as requested.
+    std::size_t pad_to = 0;
+
+    // reset() also runs trim(): the arena keeps only its largest chunk, instead of
+    // holding on to its peak footprint until release()
+    bool trim_on_reset = false;
+
+    // alloc_stats registry (utils/allocStats.hpp) under stats_name (copied, may be
+    // null). The sampled used bytes are published on the slow path only: per
+    // allocation in header mode, at chunk boundaries (and reset/rewind) headerless.
+    bool register_stats = true;
+    const char *stats_name = nullptr;
 };
 
 class ArenaGroup;
@@ -37,10 +68,25 @@ public:
         std::size_t offset = 0;
         bool use_mmap = false;
         bool guard_pages = false;
+        PageBacking backing = PageBacking::Heap; // what the OS actually gave us
+        bool populated = false;
+        int node = -1; // NUMA node the chunk is bound to
         std::size_t usableSize() const { return size; }
     };
 
+    // first corrupted block found by verify(); empty when the arena is intact
+    struct Corruption
+    {
+        bool found = false;
+        std::size_t chunk = 0;       // index into the chunk list
+        const void *block = nullptr; // user pointer (header address if the header is bad)
+        std::size_t payload_size = 0;
+        const char *what = "";       // "header" | "pre-canary" | "post-canary"
+        explicit operator bool() const { return found; }
+    };
+
     explicit ArenaAllocator(const ArenaOptions &opts);
+    ArenaAllocator(const ArenaOptions &opts, ArenaGroup *group); // first chunk comes from the group too
     ~ArenaAllocator();
 
     ArenaAllocator(ArenaAllocator &&) noexcept;
@@ -48,7 +94,29 @@ public:
     ArenaAllocator(const ArenaAllocator &) = delete;
     ArenaAllocator &operator=(const ArenaAllocator &) = delete;
 
-    void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+    void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        if (padTo_)
+        {
+            // a size that would round past SIZE_MAX stays as is: it never fits, and fails
+            if (bytes <= SIZE_MAX - padTo_ + 1)
+                bytes = (bytes + padTo_ - 1) & ~(padTo_ - 1);
+            alignment = alignment > padTo_ ? alignment : padTo_;
+        }
+        if (headerless_)
+        {
+            // cur_ += size; if (cur_ > end_) slow (so is alignment 0, clamped there).
+            // Compared against the room left, so a huge size cannot wrap past end_.
+            const std::uintptr_t p = (cur_ + alignment - 1) & ~(alignment - 1);
+            const std::size_t n = bytes + (bytes == 0);
+            if (p <= end_ && n <= end_ - p && alignment != 0 && (alignment & (alignment - 1)) == 0)
+            {
+                cur_ = p + n;
+                return reinterpret_cast<void *>(p);
+            }
+        }
+        return allocateChecked_(bytes, alignment);
+    }
 
     template <typename T, typename... Args>
     T *construct(Args &&...args)
@@ -60,12 +128,41 @@ public:
     void destroy(T * /*ptr*/) {}
     void reset();
     void release();
+    // Hands every chunk with nothing allocated in it, and every spare kept by
+    // rewind(), back to the group (or the OS). Live chunks stay; if none is live
+    // (after reset()) the largest empty one is kept as the current chunk.
+    // Invalidates markers. Returns the bytes dropped.
+    std::size_t trim();
+
+    // Checkpoint of the allocation cursor. rewind(m) frees everything allocated
+    // after mark() in O(1) plus one step per chunk acquired since; those chunks are
+    // kept as spares for the next growth (keepChunks) or handed back to the
+    // group/OS. A marker is invalidated by reset(), release(), trim() and by a
+    // rewind() to a point before it; rewinding to an invalid one aborts. Rewinding
+    // to the same marker twice, or to nested markers innermost first, is fine.
+    struct Marker
+    {
+        std::size_t chunk = 0;  // index of the current chunk at mark()
+        std::size_t offset = 0; // its offset at mark()
+        std::size_t total = 0;
+        std::uint64_t generation = 0; // bumped by reset()/release()/trim()
+        std::uint64_t tick = 0;       // orders marks against rewinds
+    };
+    Marker mark() const;
+    void rewind(const Marker &m, bool keepChunks = true);
+    std::size_t spareChunkCount() const { return spare_.size(); }
+
+    // Walks every BlockHeader in allocation order and checks its magic and (with
+    // use_canaries) both canaries. Cost is one pass over the headers; no abort.
+    Corruption verify() const;
 
     std::size_t chunkCount() const { return chunks_.size(); }
+    const ArenaChunk &chunkAt(std::size_t i) const { return chunks_[i]; }
     std::size_t bytesRemaining() const;
     const ArenaOptions &options() const { return opts_; }
 
-    static ArenaChunk osAllocChunk_(std::size_t usableBytes, bool /*guards*/, bool /*preferHuge*/);
+    static ArenaChunk osAllocChunk_(std::size_t usableBytes, bool guards, bool preferHuge, bool populate = false,
+                                    int node = -1);
     static void osFreeChunk_(ArenaChunk &c);
 
     void attachGroup(ArenaGroup *g) { group_ = g; }
@@ -81,37 +178,85 @@ private:
         std::size_t post_canary = 0;
     };
 
-    struct JournalEntry
-    {
-        std::size_t size;
-        std::size_t alignment;
-        std::uintptr_t retaddr;
-    };
-
     // helpers
-    void *allocateSlow_(std::size_t size, std::size_t alignment);
+    // header mode, or headerless refill; never inlined so its return address is the caller of allocate()
+    [[gnu::noinline]] void *allocateChecked_(std::size_t bytes, std::size_t alignment);
+    void *allocateSlow_(std::size_t size, std::size_t alignment, const void *site = nullptr);
     bool tryAllocFromChunk_(ArenaChunk &c, std::size_t user, std::size_t align, void **out);
     static std::size_t alignUp_(std::size_t n, std::size_t a)
     {
         return (n + a - 1) & ~(a - 1);
     }
     ArenaChunk newChunk_(std::size_t minBytes);
+    void dropChunk_(ArenaChunk &c); // to the group, else the OS
+    void syncBump_(); // headerless: write cur_ back into the current chunk's offset
+    void loadBump_(); // headerless: point cur_/end_ at the current chunk
 
     // canaries
     void writeCanaries_(unsigned char *user, std::size_t size, std::size_t pre, std::size_t post);
-    void maybeJournal_(std::size_t size, std::size_t alignment);
+    Corruption verifyChunk_(const ArenaChunk &c, std::size_t idx) const;
+    void verifyOrDie_() const; // verify_on_reset
+    void maybeJournal_(std::size_t size, void *ptr, const void *site);
+    void journalReset_(std::size_t dropped, const void *site);
+
+    // alloc_stats mirror: relaxed atomics written by the owner, read by the probe.
+    // Heap-allocated so the registration moves with the arena.
+    struct StatMirror;
+    std::unique_ptr<StatMirror> stat_;
+    void registerStats_();
+    void publishStats_(); // chunk list / used bytes changed
+    void noteAlloc_();    // header mode, per allocation
 
     // state
     ArenaOptions opts_{};
     std::vector<ArenaChunk> chunks_;
+    std::vector<ArenaChunk> spare_; // kept by rewind(); back() is reused first
     std::size_t nextChunkBytes_ = 0;
     std::size_t totalBytes_ = 0;
     ArenaGroup *group_ = nullptr;
 
-    // journaling
+    // headerless bump window over chunks_.back(); the chunk's offset lags until syncBump_()
+    bool headerless_ = false;
+    std::uintptr_t cur_ = 0;
+    std::uintptr_t end_ = 0;
+    std::size_t padTo_ = 0; // power of two or 0 (ArenaOptions::pad_to)
+
     bool journalOn_ = false;
-    std::vector<JournalEntry> journal_;
-    std::size_t journalHead_ = 0;
+
+    // marker validation: a marker is stale once its generation is gone, or once a
+    // rewind after it (a later tick) went below its position. cuts_ keeps only the
+    // rewinds that can still do that, so both tick and position increase along it.
+    struct Cut
+    {
+        std::uint64_t tick = 0;
+        std::size_t chunk = 0;
+        std::size_t offset = 0;
+    };
+    std::uint64_t markGen_ = 0;
+    mutable std::uint64_t markTick_ = 0;
+    std::vector<Cut> cuts_;
+    void invalidateMarkers_();
+};
+
+// Marks the arena on construction and rewinds to the mark on destruction, so
+// temporaries allocated inside the scope are discarded while earlier data stays.
+// Destructors of objects built in the scope are not run.
+class ArenaScope
+{
+public:
+    explicit ArenaScope(ArenaAllocator &arena, bool keepChunks = true)
+        : arena_(arena), mark_(arena.mark()), keep_(keepChunks) {}
+    ~ArenaScope() { arena_.rewind(mark_, keep_); }
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+    ArenaAllocator &arena() { return arena_; }
+    const ArenaAllocator::Marker &marker() const { return mark_; }
+
+private:
+    ArenaAllocator &arena_;
+    ArenaAllocator::Marker mark_;
+    bool keep_;
 };
 
 class ThreadLocalArena
@@ -143,21 +288,112 @@ private:
     static thread_local std::unique_ptr<ArenaAllocator> tls_;
 };
 
+struct ArenaGroupOptions
+{
+    // Size classes, ascending. A request maps to the first class >= its size; a
+    // returned chunk goes to the largest class <= its size, so every cached slab
+    // satisfies any request of its class. Chunks above the last class are never
+    // cached (freed on release).
+    std::vector<std::size_t> bin_sizes = {std::size_t{64} << 10, std::size_t{256} << 10, std::size_t{1} << 20,
+                                          std::size_t{4} << 20, std::size_t{16} << 20, std::size_t{64} << 20};
+    std::size_t max_slabs_per_bin = 64; // per shard and class; extra releases go back to the OS (0 = no cap)
+    std::size_t max_cached_bytes = 0;   // all shards and classes; a release past it is freed (0 = no cap)
+    std::size_t shards = 0;             // per-CPU shards; 0 = one per hardware thread (max 64)
+    std::chrono::milliseconds trim_after{0}; // > 0: acquire()/release() free the shard's slabs idle longer than this
+    bool register_stats = true;              // alloc_stats registry entry (utils/allocStats.hpp)
+    const char *stats_name = nullptr;
+};
+
+// Chunk recycler shared by arenas. Cached slabs live in per-CPU shards, each with
+// its own lock and bins: acquire()/release() work on the calling CPU's shard and
+// an empty shard steals from the others (try_lock only), so threads releasing
+// and re-acquiring together do not convoy on one mutex.
 class ArenaGroup
 {
 public:
     using Chunk = ArenaAllocator::ArenaChunk;
 
-    Chunk acquire(std::size_t minBytes, bool guards, bool preferHuge);
+    ArenaGroup() : ArenaGroup(ArenaGroupOptions{}) {}
+    explicit ArenaGroup(int node) : ArenaGroup(ArenaGroupOptions{}, node) {} // fresh slabs bound to a NUMA node
+    explicit ArenaGroup(ArenaGroupOptions opts, int node = -1);
+    ~ArenaGroup(); // returns all cached slabs to the OS
+    ArenaGroup(const ArenaGroup &) = delete;
+    ArenaGroup &operator=(const ArenaGroup &) = delete;
+
+    Chunk acquire(std::size_t minBytes, bool guards, bool preferHuge, bool populate = false);
     void release(Chunk &&chunk);
+    int node() const { return node_; }
+    const ArenaGroupOptions &options() const { return opts_; }
+
+    // Maps `count` slabs of minBytes' size class ahead of demand (outside any lock),
+    // with the guard/huge-page flags the class was last acquired with, spread over
+    // the shards. Returns slabs added.
+    std::size_t prefill(std::size_t minBytes, std::size_t count, bool populate = true);
+    // Returns idle slabs to the OS (oldest first) until at most keepBytes stay cached.
+    // Returns the bytes unmapped / freed.
+    std::size_t trim(std::size_t keepBytes);
+    // Returns slabs idle for longer than `age` to the OS. Returns the bytes freed.
+    std::size_t trimIdle(std::chrono::milliseconds age);
+
+    struct BinStats
+    {
+        std::size_t slab_bytes = 0;  // size class
+        std::size_t cached = 0;      // idle slabs in the bin
+        std::uint64_t acquires = 0;  // acquire() calls that mapped to this class
+    };
+    struct Stats
+    {
+        std::size_t cached_slabs = 0;    // idle slabs parked in the bins
+        std::size_t cached_bytes = 0;
+        std::size_t checked_out_bytes = 0; // slabs handed out by acquire() and not yet returned
+        std::uint64_t reuse_hits = 0;    // acquire() served from a bin (own shard or stolen)
+        std::uint64_t steals = 0;        // ... of which came from another shard
+        std::uint64_t os_allocs = 0;     // acquire() that had to go to the OS
+        std::uint64_t prefilled = 0;     // slabs mapped by prefill()
+        std::uint64_t trimmed_bytes = 0; // bytes handed back by trim()/trimIdle()/trim_after
+        std::uint64_t overflow_frees = 0; // releases freed because the bin was full or oversize
+        std::vector<BinStats> bins;
+    };
+    Stats stats() const;
 
 private:
-    // simple size-class bins (power-of-two-ish)
+    using IdleClock = std::chrono::steady_clock;
+    struct Slab
+    {
+        Chunk chunk;
+        IdleClock::time_point idleSince;
+    };
     struct Bin
     {
-        std::vector<Chunk> slabs;
+        std::vector<Slab> slabs; // oldest first
+        std::uint64_t acquires = 0;
+        bool guards = false; // flags of the last acquire(), reused by prefill()
+        bool huge = false;
     };
+    struct alignas(64) Shard
+    {
+        mutable std::mutex mtx;
+        std::vector<Bin> bins;
+        std::int64_t checkedOut = 0; // acquired here minus released here; summed in stats()
+        std::uint64_t reuseHits = 0;
+        std::uint64_t steals = 0;
+        std::uint64_t osAllocs = 0;
+        std::uint64_t prefilled = 0;
+        std::uint64_t trimmedBytes = 0;
+        std::uint64_t overflowFrees = 0;
+    };
+
+    std::size_t binFor_(std::size_t minBytes) const;   // first class >= minBytes; npos if oversize
+    std::size_t binOf_(std::size_t chunkBytes) const;  // last class <= chunkBytes; npos if none
+    Shard &localShard_();
+    bool takeFrom_(Shard &sh, std::size_t bin, bool guards, bool preferHuge, Chunk &out);
+    std::size_t freeAll_(std::vector<Chunk> &victims); // outside any shard lock
+    void expireIdle_(Shard &sh, IdleClock::time_point now, std::vector<Chunk> &victims); // trim_after; holds sh.mtx
 
-    std::vector<Bin> bins_;
-    std::mutex mtx_;
+    ArenaGroupOptions opts_;
+    int node_ = -1;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<std::size_t> prefillCursor_{0};
+    std::atomic<std::size_t> cachedBytes_{0}; // bytes parked in all bins (max_cached_bytes)
+    std::uint64_t statsId_ = 0;
 };
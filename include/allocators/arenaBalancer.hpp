@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "allocators/arenaAllocator.hpp"
+
+struct ArenaBalancerOptions
+{
+    bool enabled = false; // NumaAllocator only: start one per allocator
+    std::chrono::milliseconds interval{10};
+
+    // Hot group (acquired slabs since the last tick): keep its busiest size class
+    // stocked with reserve_slabs idle slabs plus one interval's worth of demand,
+    // so acquire() is served from the bins instead of mapping new memory.
+    std::size_t reserve_slabs = 2;
+    bool populate = true; // pre-fault prefilled slabs in the background as well
+
+    // Cold group (no acquires for cold_ticks ticks): return idle slabs to the OS
+    // until cold_keep_bytes remain.
+    std::uint32_t cold_ticks = 50;
+    std::size_t cold_keep_bytes = 0;
+
+    // Hard cap on idle bytes per group, hot or cold; bounds steady-state RSS.
+    std::size_t max_idle_bytes = std::size_t{256} << 20;
+};
+
+// Background rebalancer for a set of ArenaGroups (e.g. one per NUMA node).
+// Every interval it samples each group's bin occupancy and acquire counts,
+// prefills the hot groups and trims the cold ones, so mapping and unmapping
+// happen on this thread rather than on the allocation path. The groups must
+// outlive the balancer.
+class ArenaBalancer
+{
+public:
+    struct Stats
+    {
+        std::uint64_t ticks = 0;
+        std::uint64_t prefilled_slabs = 0;
+        std::uint64_t trimmed_bytes = 0;
+    };
+
+    explicit ArenaBalancer(std::vector<ArenaGroup *> groups, ArenaBalancerOptions opts = ArenaBalancerOptions{});
+    ~ArenaBalancer(); // stops the thread
+
+    ArenaBalancer(const ArenaBalancer &) = delete;
+    ArenaBalancer &operator=(const ArenaBalancer &) = delete;
+
+    void start();
+    void stop();
+    bool running() const { return worker_.joinable(); }
+
+    // One balancing pass; what the background thread runs every interval.
+    // Call it directly when driving the balancer by hand (not while started).
+    void tick();
+
+    Stats stats() const;
+    const ArenaBalancerOptions &options() const { return opts_; }
+
+private:
+    struct Watch
+    {
+        ArenaGroup *group = nullptr;
+        std::vector<std::uint64_t> lastAcquires; // per bin, at the previous tick
+        std::uint32_t quietTicks = 0;
+    };
+
+    void run_();
+
+    ArenaBalancerOptions opts_;
+    std::vector<Watch> watched_;
+
+    mutable std::mutex mtx_; // stats_ and the stop flag
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    Stats stats_;
+    std::thread worker_;
+};
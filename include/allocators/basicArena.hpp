@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "allocators/allocPolicies.hpp"
+#include "allocators/arenaAllocator.hpp"
+
+// ArenaAllocator in headerless mode with compile-time policies (allocPolicies.hpp)
+// layered on top: BasicArena<> is the inline bump and nothing else. Policies see
+// onAlloc(ptr, bytes) per allocation and onReset() on reset()/release(); the
+// pool-only hooks (onFree, deferFree) never fire. For header/canary checking
+// use ArenaAllocator with use_canaries instead.
+template <class... Policies>
+class BasicArena : private Policies...
+{
+public:
+    explicit BasicArena(ArenaOptions opts = ArenaOptions{}) : arena_(headerless_(opts)) {}
+    BasicArena(ArenaOptions opts, ArenaGroup *group) : arena_(headerless_(opts), group) {}
+
+    void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        void *p = arena_.allocate(bytes, alignment);
+        (onAlloc_(static_cast<Policies &>(*this), p, bytes), ...);
+        return p;
+    }
+
+    template <typename T, typename... Args>
+    T *construct(Args &&...args)
+    {
+        void *p = allocate(sizeof(T), alignof(T));
+        return new (p) T(std::forward<Args>(args)...);
+    }
+
+    void reset()
+    {
+        arena_.reset();
+        (onReset_(static_cast<Policies &>(*this)), ...);
+    }
+    void release()
+    {
+        arena_.release();
+        (onReset_(static_cast<Policies &>(*this)), ...);
+    }
+
+    template <class P>
+    P &policy() { return static_cast<P &>(*this); }
+    template <class P>
+    const P &policy() const { return static_cast<const P &>(*this); }
+
+    ArenaAllocator &arena() { return arena_; }
+    std::size_t bytesRemaining() const { return arena_.bytesRemaining(); }
+    std::size_t chunkCount() const { return arena_.chunkCount(); }
+
+private:
+    static ArenaOptions headerless_(ArenaOptions o)
+    {
+        o.headerless = true;
+        return o;
+    }
+    template <class P>
+    static void onAlloc_(P &pol, void *p, std::size_t bytes)
+    {
+        if constexpr (requires { pol.onAlloc(p, bytes); })
+            pol.onAlloc(p, bytes);
+    }
+    template <class P>
+    static void onReset_(P &pol)
+    {
+        if constexpr (requires { pol.onReset(); })
+            pol.onReset();
+    }
+
+    ArenaAllocator arena_;
+};
+
+using MinimalArena = BasicArena<>;
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "allocators/allocPolicies.hpp"
+#include "allocators/poolConfig.hpp"
+#include "utils/osMemory.hpp"
+
+// Single-threaded fixed-size pool whose debug features are compile-time policies
+// (see allocPolicies.hpp) instead of PoolOptions branches. Non-virtual and header
+// only: BasicPool<> is an intrusive free-list pop/push plus a bump cursor for
+// never-used blocks, with no atomics and no indirect calls. PoolAllocator and
+// LockFreePoolAllocator remain the runtime-configurable (and thread-safe) pools.
+template <class... Policies>
+class BasicPool : private Policies...
+{
+public:
+    BasicPool(std::size_t objectSize, std::size_t capacity, PoolBacking backing = PoolBacking::Malloc)
+        : capacity_(capacity)
+    {
+        if (objectSize < sizeof(void *))
+            objectSize = sizeof(void *);
+        const std::size_t a = alignof(std::max_align_t);
+        blockSize_ = (objectSize + a - 1) & ~(a - 1);
+        const std::size_t total = blockSize_ * capacity_;
+        if (backing != PoolBacking::Malloc)
+        {
+            slab_ = os_memory::map(total, backing == PoolBacking::HugePages, false);
+            base_ = static_cast<char *>(slab_.base);
+        }
+        else
+        {
+            base_ = static_cast<char *>(std::malloc(total ? total : 1));
+        }
+        if (!base_)
+            throw std::bad_alloc();
+        each_([&](auto &p)
+              { if constexpr (requires { p.attach(capacity_); }) p.attach(capacity_); });
+    }
+
+    ~BasicPool()
+    {
+        if (slab_.base)
+            os_memory::unmap(slab_);
+        else
+            std::free(base_);
+    }
+
+    BasicPool(const BasicPool &) = delete;
+    BasicPool &operator=(const BasicPool &) = delete;
+
+    void *allocate()
+    {
+        void *p = head_;
+        if (p)
+        {
+            std::memcpy(&head_, p, sizeof(void *));
+        }
+        else if (bump_ < capacity_)
+        {
+            p = base_ + bump_++ * blockSize_;
+            onFresh_(p);
+        }
+        else
+        {
+            each_([](auto &pol)
+                  { if constexpr (requires { pol.onAllocFail(); }) pol.onAllocFail(); });
+            return nullptr;
+        }
+        onAlloc_(p);
+        return p;
+    }
+
+    void deallocate(void *ptr)
+    {
+        if (!ptr)
+            return;
+        each_([&](auto &pol)
+              { if constexpr (requires { pol.onFree(ptr, blockSize_); }) pol.onFree(ptr, blockSize_); });
+        each_([&](auto &pol)
+              { if constexpr (requires { pol.deferFree(ptr); }) { if (ptr) ptr = pol.deferFree(ptr); } });
+        if (ptr)
+            push_(ptr);
+    }
+
+    // same contract as PoolAllocator::allocateBulk / deallocateBulk
+    std::size_t allocateBulk(void **out, std::size_t n)
+    {
+        std::size_t got = 0;
+        while (got < n)
+        {
+            void *p = allocate();
+            if (!p)
+                break;
+            out[got++] = p;
+        }
+        return got;
+    }
+    void deallocateBulk(void *const *ptrs, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            deallocate(ptrs[i]);
+    }
+
+    template <typename T, typename... Args>
+    T *construct(Args &&...args)
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned type");
+        void *mem = allocate();
+        return mem ? new (mem) T(std::forward<Args>(args)...) : nullptr;
+    }
+    template <typename T>
+    void destroy(T *ptr)
+    {
+        if (ptr)
+        {
+            ptr->~T();
+            deallocate(static_cast<void *>(ptr));
+        }
+    }
+
+    // the policy object, e.g. pool.policy<alloc_policy::FunctionHooks>().on_alloc = ...
+    template <class P>
+    P &policy() { return static_cast<P &>(*this); }
+    template <class P>
+    const P &policy() const { return static_cast<const P &>(*this); }
+
+    std::size_t capacity() const { return capacity_; }
+    std::size_t objectSize() const { return blockSize_; }
+    void *memory() const { return base_; }
+    bool owns(const void *p) const
+    {
+        auto u = reinterpret_cast<std::uintptr_t>(p);
+        auto b = reinterpret_cast<std::uintptr_t>(base_);
+        return u >= b && u < b + blockSize_ * capacity_;
+    }
+
+    // counts are only filled in by a Counters policy
+    PoolStats getStats() const
+    {
+        PoolStats s;
+        s.capacity = capacity_;
+        s.object_size = blockSize_;
+        s.aligned_object_size = blockSize_;
+        s.backing = slab_.base ? slab_.backing : PageBacking::Heap;
+        s.untouched = capacity_ - bump_;
+        (fillStats_(static_cast<const Policies &>(*this), s), ...);
+        return s;
+    }
+
+private:
+    template <class F>
+    void each_(F &&f) { (f(static_cast<Policies &>(*this)), ...); }
+
+    template <class P>
+    static void fillStats_(const P &pol, PoolStats &s)
+    {
+        if constexpr (requires { pol.fillStats(s); })
+            pol.fillStats(s);
+    }
+
+    void onFresh_(void *p)
+    {
+        each_([&](auto &pol)
+              { if constexpr (requires { pol.onFresh(p, blockSize_); }) pol.onFresh(p, blockSize_); });
+    }
+    void onAlloc_(void *p)
+    {
+        each_([&](auto &pol)
+              { if constexpr (requires { pol.onAlloc(p, blockSize_); }) pol.onAlloc(p, blockSize_); });
+    }
+    void push_(void *p)
+    {
+        std::memcpy(p, &head_, sizeof(void *));
+        head_ = p;
+    }
+
+    char *base_ = nullptr;
+    void *head_ = nullptr;
+    std::size_t bump_ = 0; // blocks [bump_, capacity_) never handed out
+    std::size_t blockSize_ = 0;
+    std::size_t capacity_ = 0;
+    OsMapping slab_;
+};
+
+// PoolOptions::MinimalOverhead / DebugStrong as types
+using MinimalPool = BasicPool<>;
+using CountingPool = BasicPool<alloc_policy::Counters>;
+using DebugStrongPool = BasicPool<alloc_policy::Counters, alloc_policy::Poison<>, alloc_policy::Zero,
+                                  alloc_policy::Quarantine<64>, alloc_policy::OccupancyHistogram<>>;
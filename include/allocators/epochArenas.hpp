@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "allocators/arenaAllocator.hpp"
+
+struct EpochArenasOptions
+{
+    ArenaOptions arena{};               // every arena handed out by acquire()
+    std::size_t max_readers = 64;       // reader slots (concurrent pins); more aborts
+    std::size_t max_cached_arenas = 8;  // reclaimed arenas kept for acquire(); the rest are released to the group
+    bool reclaim_on_retire = true;      // retire() also runs reclaim()
+};
+
+// Epoch-based recycling of arenas that are read by many threads after being
+// built by one, e.g. immutable snapshots published through an atomic pointer:
+//
+//   auto arena = epochs.acquire();                 // writer: bump-allocate the new snapshot
+//   Book *next = arena->construct<Book>(...);
+//   Book *prev = current.exchange(next);           // publish
+//   epochs.retire(std::move(prevArena));           // the arena prev lives in
+//
+//   auto pin = epochs.pin();                       // reader: no lock, no wait
+//   const Book *b = current.load(std::memory_order_acquire);
+//
+// retire() stamps the arena with the current epoch and advances it. An arena
+// is reset and handed out again once every pinned reader's epoch is past its
+// stamp: a reader that pinned later cannot have loaded a pointer into it.
+// Readers never wait for writers; writers never wait for readers (a reader
+// that stays pinned only delays reclamation). Chunks come from, and are
+// returned to, the ArenaGroup, which must outlive the manager.
+class EpochArenas
+{
+    struct alignas(64) Slot
+    {
+        std::atomic<std::uint64_t> epoch{0}; // 0 = free, else the epoch its reader pinned
+    };
+
+public:
+    // Pins the epoch for the guard's lifetime. Movable; nested guards take their own slot.
+    class Guard
+    {
+    public:
+        Guard() = default;
+        Guard(Guard &&o) noexcept : slot_(o.slot_) { o.slot_ = nullptr; }
+        Guard &operator=(Guard &&o) noexcept
+        {
+            if (this != &o)
+            {
+                unpin();
+                slot_ = o.slot_;
+                o.slot_ = nullptr;
+            }
+            return *this;
+        }
+        Guard(const Guard &) = delete;
+        Guard &operator=(const Guard &) = delete;
+        ~Guard() { unpin(); }
+
+        void unpin()
+        {
+            if (slot_)
+                slot_->epoch.store(0, std::memory_order_release);
+            slot_ = nullptr;
+        }
+        std::uint64_t epoch() const { return slot_ ? slot_->epoch.load(std::memory_order_relaxed) : 0; }
+        explicit operator bool() const { return slot_ != nullptr; }
+
+    private:
+        friend class EpochArenas;
+        explicit Guard(Slot *s) : slot_(s) {}
+        Slot *slot_ = nullptr;
+    };
+
+    struct Stats
+    {
+        std::uint64_t epoch = 0;     // current epoch
+        std::uint64_t created = 0;   // arenas built by acquire() because none was cached
+        std::uint64_t reused = 0;    // acquire() served by a reclaimed arena
+        std::uint64_t retired = 0;
+        std::uint64_t reclaimed = 0; // retired arenas reset after every reader moved past them
+        std::uint64_t released = 0;  // ... of which were released because the cache was full
+        std::size_t pending = 0;     // retired, still visible to a pinned reader
+        std::size_t cached = 0;      // reset, waiting for acquire()
+        std::size_t pinned = 0;      // readers pinned right now
+    };
+
+    explicit EpochArenas(ArenaGroup &group, EpochArenasOptions opts = EpochArenasOptions{});
+    ~EpochArenas(); // aborts if a reader is still pinned
+    EpochArenas(const EpochArenas &) = delete;
+    EpochArenas &operator=(const EpochArenas &) = delete;
+
+    // Reader side: one CAS on a slot the thread reuses, plus a re-check of the epoch.
+    Guard pin()
+    {
+        thread_local std::size_t hint = kNoHint;
+        if (hint >= nslots_)
+            hint = nextHint_.fetch_add(1, std::memory_order_relaxed) % nslots_;
+        std::uint64_t e = epoch_.load(std::memory_order_seq_cst);
+        std::uint64_t free = 0;
+        Slot *s = &slots_[hint];
+        if (!s->epoch.compare_exchange_strong(free, e, std::memory_order_seq_cst))
+            s = claimSlot_(e, hint);
+        // a retire() that scanned before our slot was visible has already moved the
+        // epoch; re-pin at the new one until the epoch we published is current
+        for (std::uint64_t now; (now = epoch_.load(std::memory_order_seq_cst)) != e; e = now)
+            s->epoch.store(now, std::memory_order_seq_cst);
+        return Guard(s);
+    }
+
+    // Writer side. acquire() returns a reset arena from the cache, else a new one on the group.
+    std::unique_ptr<ArenaAllocator> acquire();
+    // Retires an arena into the current epoch and advances the epoch. Readers that
+    // pin from now on must not be able to reach anything allocated in it.
+    void retire(std::unique_ptr<ArenaAllocator> arena);
+    // Resets every retired arena whose epoch all pinned readers have passed and
+    // caches it (or releases it past max_cached_arenas). Returns arenas reclaimed.
+    std::size_t reclaim();
+    // reclaim() until nothing is pending (yields while readers stay pinned).
+    void drain();
+
+    std::uint64_t epoch() const { return epoch_.load(std::memory_order_relaxed); }
+    Stats stats() const;
+    ArenaGroup &group() const { return group_; }
+    const EpochArenasOptions &options() const { return opts_; }
+
+private:
+    static constexpr std::size_t kNoHint = ~std::size_t{0};
+
+    struct Retired
+    {
+        std::uint64_t epoch = 0;
+        std::unique_ptr<ArenaAllocator> arena;
+    };
+
+    Slot *claimSlot_(std::uint64_t e, std::size_t &hint); // hint slot taken: scan the others
+    std::uint64_t minPinned_() const;                     // oldest pinned epoch, ~0 when none
+    std::unique_ptr<ArenaAllocator> takeCached_();        // null when the cache is empty
+
+    ArenaGroup &group_;
+    EpochArenasOptions opts_;
+    std::size_t nslots_ = 0;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<std::size_t> nextHint_{0};
+    alignas(64) std::atomic<std::uint64_t> epoch_{1};
+
+    mutable std::mutex mtx_;       // retired_, cached_ and the counters below
+    std::vector<Retired> retired_; // epoch ascending
+    std::vector<std::unique_ptr<ArenaAllocator>> cached_;
+    std::uint64_t created_ = 0;
+    std::uint64_t reused_ = 0;
+    std::uint64_t retiredTotal_ = 0;
+    std::uint64_t reclaimed_ = 0;
+    std::uint64_t released_ = 0;
+};
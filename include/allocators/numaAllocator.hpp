@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "allocators/arenaAllocator.hpp"
+#include "allocators/arenaBalancer.hpp"
+#include "allocators/poolAllocator.hpp"
+#include "allocators/poolConfig.hpp"
+
+// Node/CPU layout read once from /sys/devices/system/node. Machines (or
+// containers) without that tree look like a single node 0 owning every CPU.
+class NumaTopology
+{
+public:
+    static const NumaTopology &instance();
+
+    std::size_t nodeCount() const { return nodes_.size(); }
+    const std::vector<int> &nodes() const { return nodes_; } // online node ids, ascending
+    int maxNode() const { return nodes_.empty() ? 0 : nodes_.back(); }
+    int nodeOfCpu(int cpu) const;                    // 0 if unknown
+    const std::vector<int> &cpusOf(int node) const;  // empty for unknown nodes
+
+    // "0-3,8,10-11" -> {0,1,2,3,8,10,11}
+    static std::vector<int> parseList(const char *s);
+
+private:
+    NumaTopology();
+
+    std::vector<int> nodes_;
+    std::vector<int> cpuToNode_;
+    std::vector<std::vector<int>> cpusByNode_; // indexed by node id
+};
+
+// Thread -> CPU -> node registry. Each thread caches its node and re-reads
+// sched_getcpu() every kRefreshCalls lookups, so a thread the scheduler moved
+// is picked up without a syscall on every allocation.
+class ThreadAffinityRegistry
+{
+public:
+    struct ThreadAffinity
+    {
+        std::thread::id thread;
+        int cpu = -1;
+        int node = 0;
+        std::uint64_t migrations = 0; // node changes observed
+    };
+
+    static constexpr std::uint32_t kRefreshCalls = 64;
+
+    static int currentNode();     // cached, refreshed periodically
+    static int refreshCurrent();  // re-read the CPU now
+    static bool pinCurrentThread(int node); // restrict to node's CPUs, then refresh
+    static std::vector<ThreadAffinity> snapshot(); // live threads that asked
+
+    struct Slot;
+
+private:
+    static Slot &local_();
+};
+
+struct NumaOptions
+{
+    std::size_t object_size = 64;
+    std::size_t objects_per_node = 1 << 16;
+    PoolOptions pool = PoolOptions{};  // per-node pool options; numa_node is set per node
+    ArenaOptions arena = ArenaOptions{}; // template for makeArena(); numa_node is set per node
+    ArenaGroupOptions group = ArenaGroupOptions{}; // per-node chunk recycler (bins, caps, shards)
+    ArenaBalancerOptions balancer = ArenaBalancerOptions{}; // background prefill/trim of the node groups
+
+    // Called on every cross-node event: a block served from (or freed to) a node
+    // other than the calling thread's. Runs on the hot path; keep it cheap.
+    std::function<void(int thread_node, int memory_node, bool is_free)> on_remote = {};
+};
+
+// Per-node locality counters and memory profile.
+struct NumaNodeStats
+{
+    int node = 0;
+    PoolStats pool;               // the node's block pool
+    ArenaGroup::Stats arenas;     // the node's chunk recycler
+    std::uint64_t local_allocs = 0;  // served to a thread running on this node
+    std::uint64_t remote_allocs = 0; // served to a thread on another node (spill / allocateOnNode)
+    std::uint64_t remote_frees = 0;  // returned by a thread on another node
+
+    // memory profile, in bytes
+    std::size_t in_use_bytes = 0;     // live pool blocks + arena chunks checked out
+    std::size_t fragmented_bytes = 0; // pool blocks touched once and now free
+    std::size_t idle_bytes = 0;       // arena chunks parked in the group bins
+    std::size_t untouched_bytes = 0;  // pool slab never handed out (not faulted in)
+};
+
+struct NumaStats
+{
+    std::vector<NumaNodeStats> nodes;
+    std::vector<ThreadAffinityRegistry::ThreadAffinity> threads; // registry snapshot
+    std::uint64_t remote_allocs = 0;
+    std::uint64_t remote_frees = 0;
+    std::uint64_t migrations = 0; // summed over live threads
+};
+
+// Fixed-size blocks and arena chunks placed on the calling thread's NUMA node.
+// Each node gets a LockFreePoolAllocator and an ArenaGroup whose memory is bound
+// to that node before first touch. allocate() routes to the local node and
+// falls back to the other nodes when the local pool is exhausted; deallocate()
+// returns a block to the pool that owns its address, from any thread.
+class NumaAllocator
+{
+public:
+    explicit NumaAllocator(NumaOptions opts = NumaOptions{});
+    ~NumaAllocator();
+
+    NumaAllocator(const NumaAllocator &) = delete;
+    NumaAllocator &operator=(const NumaAllocator &) = delete;
+
+    void *allocate();
+    void *allocateOnNode(int node); // that node only; nullptr when it is exhausted
+    void deallocate(void *ptr);
+
+    // Chunk recycler on `node` (-1 = calling thread's node) and an arena fed by it.
+    // Arenas hand their chunks back to the group, so they must not outlive us.
+    ArenaGroup &arenaGroup(int node = -1);
+    ArenaAllocator makeArena(int node = -1);
+
+    int nodeOf(const void *ptr) const; // owning node by address, -1 if not ours
+    LockFreePoolAllocator &pool(int node);
+    std::size_t nodeCount() const { return nodes_.size(); }
+    const NumaOptions &options() const { return opts_; }
+
+    NumaStats getStats() const;
+    ArenaBalancer *balancer() { return balancer_.get(); } // nullptr unless options().balancer.enabled
+
+private:
+    struct Node
+    {
+        int id = 0;
+        std::unique_ptr<LockFreePoolAllocator> pool;
+        std::unique_ptr<ArenaGroup> arenas;
+        std::uintptr_t begin = 0;
+        std::uintptr_t end = 0;
+
+        struct Counters
+        {
+            alignas(64) std::atomic<std::uint64_t> remote_allocs{0};
+            alignas(64) std::atomic<std::uint64_t> remote_frees{0};
+        };
+        std::unique_ptr<Counters> counters; // only cross-node events are counted
+    };
+
+    Node &nodeFor_(int node); // -1 = local; unknown ids map to the first node
+    const Node *owner_(const void *ptr) const;
+    void noteRemote_(const Node &n, int threadNode, bool isFree);
+
+    NumaOptions opts_;
+    std::vector<Node> nodes_;
+    std::vector<int> slotOfNode_; // node id -> index into nodes_ (-1 if offline)
+    std::unique_ptr<ArenaBalancer> balancer_; // last: stopped before the groups go away
+};
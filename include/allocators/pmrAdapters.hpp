@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+
+#include "allocators/arenaAllocator.hpp"
+#include "allocators/poolAllocator.hpp"
+#include "allocators/sizeClassPool.hpp"
+
+// std::pmr::memory_resource front ends, so pmr containers can sit on FinAlloc:
+//
+//   ArenaAllocator arena(opts);
+//   ArenaResource res(arena);
+//   std::pmr::vector<Order> book(&res);
+//
+// The resources do not own the allocator they wrap; it must outlive every
+// container using them. Requests the wrapped allocator cannot serve (over-aligned,
+// too large, pool exhausted) go to the upstream resource, new_delete_resource()
+// by default, and are routed back there on deallocation.
+
+// Monotonic: deallocate is a no-op, memory comes back on arena reset()/rewind()/release().
+class ArenaResource : public std::pmr::memory_resource
+{
+public:
+    explicit ArenaResource(ArenaAllocator &arena) : arena_(arena) {}
+    ArenaAllocator &arena() const { return arena_; }
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        void *p = arena_.allocate(bytes, alignment);
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        auto *o = dynamic_cast<const ArenaResource *>(&other);
+        return o && &o->arena_ == &arena_;
+    }
+
+private:
+    ArenaAllocator &arena_;
+};
+
+// The calling thread's ThreadLocalArena. Any two instances compare equal: a block
+// is never handed back to an arena, so which thread's arena it came from is moot.
+class ThreadLocalArenaResource : public std::pmr::memory_resource
+{
+public:
+    static ThreadLocalArenaResource *instance()
+    {
+        static ThreadLocalArenaResource res;
+        return &res;
+    }
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        void *p = ThreadLocalArena::instance().allocate(bytes, alignment);
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return dynamic_cast<const ThreadLocalArenaResource *>(&other) != nullptr;
+    }
+};
+
+// Fixed-size pool: requests that fit one block (node-based containers: list,
+// map, unordered_map nodes) come from the pool, everything else from upstream.
+template <typename PoolT = PoolAllocator>
+class PoolResource : public std::pmr::memory_resource
+{
+public:
+    explicit PoolResource(PoolT &pool, std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+        : pool_(pool), upstream_(upstream),
+          blockBytes_(pool.maxCapacity() ? pool.blockSize() / pool.maxCapacity() : 0) {}
+    PoolT &pool() const { return pool_; }
+    std::pmr::memory_resource *upstream() const { return upstream_; }
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (bytes <= blockBytes_ && alignment <= alignof(std::max_align_t))
+        {
+            if (void *p = pool_.allocate())
+                return p;
+        }
+        return upstream_->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        const auto u = reinterpret_cast<std::uintptr_t>(p);
+        const auto base = reinterpret_cast<std::uintptr_t>(pool_.memory());
+        if (u >= base && u < base + pool_.blockSize())
+            pool_.deallocate(p);
+        else
+            upstream_->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        auto *o = dynamic_cast<const PoolResource *>(&other);
+        return o && &o->pool_ == &pool_;
+    }
+
+private:
+    PoolT &pool_;
+    std::pmr::memory_resource *upstream_;
+    std::size_t blockBytes_;
+};
+
+// General purpose: sized deallocation maps straight to the size class, so there
+// is no per-block header and no lookup beyond the class's slab chain.
+template <typename PoolT = PoolAllocator>
+class SizeClassResource : public std::pmr::memory_resource
+{
+public:
+    explicit SizeClassResource(SizeClassPool<PoolT> &pool,
+                               std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+        : pool_(pool), upstream_(upstream) {}
+    SizeClassPool<PoolT> &pool() const { return pool_; }
+    std::pmr::memory_resource *upstream() const { return upstream_; }
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (fits_(bytes, alignment))
+        {
+            if (void *p = pool_.allocate(bytes ? bytes : 1))
+                return p;
+        }
+        return upstream_->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        if (fits_(bytes, alignment))
+            pool_.deallocate(p, bytes ? bytes : 1);
+        else
+            upstream_->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        auto *o = dynamic_cast<const SizeClassResource *>(&other);
+        return o && &o->pool_ == &pool_;
+    }
+
+private:
+    bool fits_(std::size_t bytes, std::size_t alignment) const
+    {
+        return bytes <= pool_.maxSize() && alignment <= alignof(std::max_align_t);
+    }
+
+    SizeClassPool<PoolT> &pool_;
+    std::pmr::memory_resource *upstream_;
+};
@@ -11,13 +11,17 @@
 #include <atomic>
 #include <mutex>
 #include <vector>
+#include <memory>
 
 #include "allocators/poolConfig.hpp"
 #include "utils/histogram.hpp"
+#include "utils/osMemory.hpp"
 
 struct PoolStats
 {
-    std::size_t capacity = 0;
+    std::size_t capacity = 0;     // committed blocks (grows with PoolOptions::max_capacity)
+    std::size_t max_capacity = 0; // reserved blocks
+    std::size_t slabs = 1;        // committed slabs
     std::size_t object_size = 0;
     std::size_t aligned_object_size = 0;
     std::uint64_t alloc_calls = 0;
@@ -26,6 +30,62 @@ struct PoolStats
     std::uint64_t cas_failures = 0; // only meaningful for lock-free
     std::uint64_t high_watermark = 0;
     std::uint64_t in_use = 0;
+
+    PageBacking backing = PageBacking::Heap; // what the slab actually got from the OS
+    std::size_t untouched = 0;               // blocks never handed out (past the bump cursor)
+    std::uint64_t trimmed_bytes = 0;         // slab bytes handed back to the OS by trim(), total
+
+    // per-thread magazine caches (lock-free pool with magazine_size > 0)
+    struct ThreadCacheStats
+    {
+        std::thread::id thread;
+        std::uint64_t refills = 0; // batches pulled from the shared list
+        std::uint64_t spills = 0;  // batches returned to the shared list
+        std::uint64_t cached = 0;  // blocks currently parked in this cache
+    };
+    std::uint64_t magazine_refills = 0;
+    std::uint64_t magazine_spills = 0;
+    std::uint64_t magazine_cached = 0;
+    std::vector<ThreadCacheStats> thread_caches;
+
+    // quarantine rings (all threads' rings on the lock-free pool)
+    std::uint64_t quarantined = 0;      // blocks currently held back
+    std::uint64_t quarantine_early = 0; // evicted before quarantine_min_age_us (ring full)
+
+    // remote-free pools: frees issued by non-owner threads / owner-side drains
+    std::uint64_t remote_frees = 0;
+    std::uint64_t remote_drains = 0;
+};
+
+// Fixed-capacity FIFO of freed blocks for PoolOptions::quarantine_*. push() is
+// O(1): once the ring holds hold + batch blocks the oldest batch is handed back
+// for release, and with a minimum age each block carries its free timestamp.
+class QuarantineRing
+{
+public:
+    void init(std::size_t hold, std::size_t batch, std::uint32_t minAgeUs);
+    bool enabled() const { return !slots_.empty(); }
+
+    // Parks p; returns how many of the oldest blocks were evicted to make room
+    // (0 or batch), readable through evicted() until the next call.
+    std::size_t push(void *p);
+    // Evicts up to min(n, batch) of the oldest blocks regardless of age (flush).
+    std::size_t take(std::size_t n);
+    void *const *evicted() const { return scratch_.data(); }
+
+    std::size_t size() const { return count_; }
+    std::size_t batch() const { return batch_; }
+    std::uint64_t early() const { return early_; }
+
+private:
+    std::vector<void *> slots_;
+    std::vector<void *> scratch_;       // last eviction
+    std::vector<std::uint64_t> stamps_; // steady ns at free; only with a minimum age
+    std::size_t head_ = 0;              // oldest
+    std::size_t count_ = 0;
+    std::size_t batch_ = 1;
+    std::uint64_t minAgeNs_ = 0;
+    std::uint64_t early_ = 0;
 };
 
 class PoolAllocator
@@ -38,13 +98,44 @@ public:
     virtual void *allocate();
     virtual void deallocate(void *ptr);
 
-    std::size_t used() const { return usedCount.load(std::memory_order_relaxed); }
-    std::size_t capacity() const { return poolCapacity; }
+    // Batch variants: move a whole chain in one operation and update metrics once
+    // per call. allocateBulk fills out[0..k) and returns k (k < n when the pool
+    // runs dry); hooks/poisoning still run per object when enabled.
+    virtual std::size_t allocateBulk(void **out, std::size_t n);
+    virtual void deallocateBulk(void *const *ptrs, std::size_t n);
+
+    // allocate() / allocateBulk() for callers that fall back to another pool when
+    // this one is dry (SizeClassPool slab chains): a miss counts neither as a call
+    // nor as an alloc_failure, so the stats only show what the caller saw.
+    virtual void *tryAllocate();
+    virtual std::size_t tryAllocateBulk(void **out, std::size_t n);
+
+    std::size_t used() const; // blocks handed out and not yet returned
+    std::size_t capacity() const { return committed_.load(std::memory_order_relaxed); } // grows
+    std::size_t maxCapacity() const { return poolCapacity; }
     void *memory() const { return memoryBlock; }
     std::size_t blockSize() const { return alignedObjSize * poolCapacity; }
     const PoolOptions &config() const { return options_; }
 
-    PoolStats getStats() const; // snapshot
+    virtual PoolStats getStats() const; // snapshot
+
+    // Returns every slab page that only holds free blocks to the OS (MADV_DONTNEED,
+    // or MADV_FREE with lazy) while keeping the slab mapped; the next allocation of
+    // such a block faults in a fresh page. Blocks that are live, quarantined or
+    // cached in a magazine pin their pages. Runs off the allocation path: the pool
+    // must be quiescent (on the remote-free pool: owner thread, which also drains
+    // pending remote frees first). Returns the bytes advised.
+    virtual std::size_t trim(bool lazy = false);
+
+    // fork() support for pools shared by the whole process (the malloc
+    // interposer's pthread_atfork handlers): lockForFork() takes every lock an
+    // allocation or a free may wait on, unlockAfterFork() releases them in the
+    // parent and, by the forking thread, in the child. The *Shared* pair covers
+    // the process-wide thread slots of PoolMetrics::Sharded; take it after the pools.
+    virtual void lockForFork();
+    virtual void unlockAfterFork();
+    static void lockSharedForFork();
+    static void unlockSharedAfterFork();
 
     template <typename T, typename... Args>
     T *construct(Args &&...args)
@@ -67,9 +158,26 @@ protected:
     // core storage
     void *memoryBlock = nullptr;
     void *nonAtomicFreeListHead = nullptr; // base free-list head for single-thread mode
+    std::size_t bumpNext_ = 0;             // blocks [bumpNext_, bumpEnd_) not handed out yet
+    std::size_t bumpEnd_ = 0;              // poolCapacity until trim() leaves holes (trimmedRuns_)
+    OsMapping slab_;                       // set when memoryBlock came from os_memory::map
     std::size_t alignedObjSize = 0;
-    std::size_t poolCapacity = 0;
-    std::atomic<std::size_t> usedCount{0}; // atomic for MT safety
+    std::size_t poolCapacity = 0; // blocks reserved; == the committed capacity unless growable
+
+    // growth (PoolOptions::max_capacity): blocks [0, committed_) are backed. Only
+    // threads that find the pool empty take growMtx_; the new slab is published
+    // with a release store of committed_, so nobody else waits on it.
+    std::atomic<std::size_t> committed_{0};
+    std::size_t initialCapacity_ = 0;
+    std::size_t slabCount_ = 1; // protected by growMtx_
+    mutable std::mutex growMtx_;
+    bool growSlab_(std::size_t seen); // commits the next slab unless committed_ moved past seen; false at max
+    std::size_t color_ = 0; // memoryBlock - start of the allocation (PoolOptions::color)
+
+    // trim(): block runs [first, second) whose pages went back to the OS, served
+    // like the bump region once it is used up; lowest run at the back
+    std::vector<std::pair<std::size_t, std::size_t>> trimmedRuns_;
+    std::uint64_t trimmedBytes_ = 0;
 
     // config + metrics
     PoolOptions options_;
@@ -81,20 +189,67 @@ protected:
         std::atomic<std::uint64_t> high_watermark{0};
         std::atomic<std::uint64_t> in_use{0};
         std::atomic<std::uint64_t> cas_failures{0}; // for lock-free
-    } metrics_;
+    } metrics_; // PoolMetrics::Shared
+
+    // PoolMetrics::Sharded: kMetricShards padded shards, indexed by thread slot
+    struct MetricShard;
+    std::unique_ptr<MetricShard[]> shards_;
+    std::uint64_t inUse_() const;
+    void countersInto_(PoolStats &s) const; // atomics only: safe from the stats sampling thread
+    std::uint64_t statsId_ = 0;             // alloc_stats registry id (0 = not registered)
+    void noteAllocCalls_(std::size_t n);
+    void noteAllocFailures_(std::size_t n);
+    void noteCasFailure_();
 
     // optional histogram for occupancy
     Histogram *occupancyHist_ = nullptr; // owned
     void sampleOccupancy_();
 
+    // single-thread paths with the caller's return address for PoolOptions::trace;
+    // the public entry points (and subclasses reusing them) capture it
+    void *allocateLocal_(const void *site, bool countMiss = true);
+    void deallocateLocal_(void *ptr, const void *site);
+    std::size_t allocateBulkLocal_(void **out, std::size_t n, const void *site, bool countMiss = true);
+    void deallocateBulkLocal_(void *const *ptrs, std::size_t n, const void *site);
+
+    // bookkeeping shared by every pop/push path
+    void *afterPop_(void *ptr, const void *site); // metrics, poison check, zeroing, hook, trace, histogram
+    void beforePush_(void *ptr, const void *site); // trace, hook, poison
+    void afterPush_();          // metrics, histogram
+    void afterPopBulk_(void **out, std::size_t got, std::size_t requested, const void *site);
+    void beforePushBulk_(void *const *ptrs, std::size_t n, const void *site);
+    void afterPushBulk_(std::size_t n);
+    void addInUse_(std::size_t n); // in_use/high_watermark
+    void subInUse_(std::size_t n); // in_use/free_calls
+    void *freshBlock_(std::size_t idx); // first hand-out of block idx (pre-poisons if enabled)
+    bool refillBump_(); // bump region used up: continue with trimmedRuns_.back(), else grow
+
+    // trim() core: block states in, the pages holding only free/fresh blocks (and
+    // at least one block that was ever handed out) advised away; marks every
+    // block overlapping such a page in `trimmed`. Returns the bytes advised.
+    enum : std::uint8_t
+    {
+        kBlockLive,
+        kBlockFree,
+        kBlockFresh
+    };
+    std::size_t decommitFree_(const std::vector<std::uint8_t> &state, std::vector<bool> &trimmed, bool lazy);
+    void prefetchBlock_(const void *p) const // PoolOptions::prefetch_next target
+    {
+        if (options_.prefetch_write)
+            prefetch::write(p, options_.prefetch_locality);
+        else
+            prefetch::read(p, options_.prefetch_locality);
+    }
+
     // helpers
     std::size_t alignUp(std::size_t n, std::size_t alignment);
     void applyPoison_(void *ptr);  // fill (sizeof(void*), end) with poison
     void verifyPoison_(void *ptr); // verify poison pattern in (sizeof(void*), end)
 
-    // quarantine (single-thread: simple ring)
-    std::vector<void *> quarantine_;
-    void quarantinePush_(void *ptr); // may flush one back to freelist when over capacity
+    // quarantine (single-thread ring)
+    QuarantineRing quarantine_;
+    void quarantinePush_(void *ptr); // may flush a batch back to the freelist
     void freeListPush_(void *ptr);   // push onto nonAtomic free list
 };
 
@@ -108,18 +263,56 @@ public:
     void *allocate() override;
     void deallocate(void *ptr) override;
 
+    // one CAS per batch against the shared list (bypasses thread magazines)
+    std::size_t allocateBulk(void **out, std::size_t n) override;
+    void deallocateBulk(void *const *ptrs, std::size_t n) override;
+    void *tryAllocate() override;
+    std::size_t tryAllocateBulk(void **out, std::size_t n) override;
+
+    PoolStats getStats() const override; // adds per-thread magazine counters
+    std::size_t trim(bool lazy = false) override; // links live in next_[], so the free list is kept as is
+    void lockForFork() override;                  // adds the magazine registry
+    void unlockAfterFork() override;
+
 private:
-    // Lock-free LIFO head
-    std::atomic<void *> freeListHead;
+    // Tagged LIFO head: low 32 bits = block index (kNilIndex when empty),
+    // high 32 bits = generation, bumped on every successful CAS so a head
+    // that was popped and re-pushed in between never compares equal (ABA).
+    std::atomic<std::uint64_t> freeListHead;
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+                  "tagged free-list head requires a lock-free 64-bit atomic");
 
-    // Side-array for next pointers (out-of-line links)
-    std::vector<void *> next_;
+    // Side-array of next indices (out-of-line links, kNilIndex terminated). Lives
+    // in its own zero-fill mapping; an entry is only written when its block is
+    // first freed, so untouched pages stay unbacked.
+    std::uint32_t *next_ = nullptr;
+    OsMapping nextMap_;
+    std::atomic_ref<std::uint32_t> link_(std::uint32_t i) const { return std::atomic_ref<std::uint32_t>(next_[i]); }
 
-    // optional global quarantine for deferred free
-    std::vector<void *> lfQuarantine_; // protected by mutex_
-    std::mutex mutex_;
+    // never-allocated blocks are claimed from here once the free list is empty
+    alignas(64) std::atomic<std::uint32_t> bump_{0};
+
+    // per-thread magazines (magazine_size > 0) and quarantine rings
+    // (quarantine_size > 0). Each thread that touches the pool gets one, shared
+    // between the pool (stats, teardown) and the thread's cache (fast path, flush
+    // on thread exit).
+    struct Magazine;
+    struct ThreadMagazines;
+    static thread_local ThreadMagazines tlsMagazines_;
+    std::uint64_t serial_ = 0; // identifies this pool in thread caches
+    std::vector<std::shared_ptr<Magazine>> magazines_; // protected by magMutex_
+    mutable std::mutex magMutex_;
+
+    static constexpr std::uint32_t kNilIndex = 0xFFFFFFFFu;
 
     // helpers
+    static std::uint64_t packHead_(std::uint32_t idx, std::uint32_t tag)
+    {
+        return (static_cast<std::uint64_t>(tag) << 32) | idx;
+    }
+    static std::uint32_t headIndex_(std::uint64_t h) { return static_cast<std::uint32_t>(h); }
+    static std::uint32_t headTag_(std::uint64_t h) { return static_cast<std::uint32_t>(h >> 32); }
+
     bool inRange_(void *p) const
     {
         auto u = reinterpret_cast<std::uintptr_t>(p);
@@ -128,12 +321,91 @@ private:
         return u >= base && u < end && ((u - base) % alignedObjSize == 0);
     }
 
-    std::size_t indexOf_(void *p) const
+    std::uint32_t indexOf_(void *p) const
     {
         auto u = reinterpret_cast<std::uintptr_t>(p);
         auto base = reinterpret_cast<std::uintptr_t>(memoryBlock);
-        return static_cast<std::size_t>((u - base) / alignedObjSize);
+        return static_cast<std::uint32_t>((u - base) / alignedObjSize);
+    }
+
+    void *blockAt_(std::uint32_t idx) const
+    {
+        return static_cast<char *>(memoryBlock) + static_cast<std::size_t>(idx) * alignedObjSize;
     }
 
-    void lfFreeListPush_(void *ptr); // push with CAS using next_[]
+    void lfFreeListPush_(void *ptr); // tagged CAS push using next_[]
+    void *allocate_(const void *site, bool countMiss);
+    std::size_t allocateBulk_(void **out, std::size_t n, const void *site, bool countMiss);
+
+    // batch moves: one CAS per chain. store(i, idx) receives the i-th popped
+    // index (may be rewritten on CAS retry); at(i) yields the i-th index to push.
+    template <typename Store>
+    std::size_t popChain_(std::size_t n, Store &&store);
+    template <typename At>
+    void pushChain_(std::size_t n, At &&at);
+    template <typename Store>
+    std::size_t bumpChain_(std::size_t n, Store &&store);
+
+    void prefetchHead_() const; // block and link of the shared head
+    Magazine &localMagazine_();
+    void lfQuarantinePush_(Magazine &m, void *ptr); // park, release an evicted batch with one CAS
+    void flushQuarantine_(Magazine &m);       // thread exit: everything back to the shared list
+    Magazine &registerMagazine_(ThreadMagazines &cache);
+    bool refill_(Magazine &m);
+    void spill_(Magazine &m, std::size_t n);
+};
+
+// Per-thread pool whose blocks may be freed from any thread.
+// The owner (constructing thread, or adoptCurrentThread()) allocates and frees
+// through the plain single-thread free list. Frees from other threads go onto an
+// MPSC remote-free stack owned by the pool, which the owner drains in one
+// exchange when its local list runs dry. release(p) finds the owning pool from
+// the pointer alone via a global address-range registry.
+class RemoteFreePoolAllocator : public PoolAllocator
+{
+public:
+    RemoteFreePoolAllocator(std::size_t objectSize, std::size_t capacity,
+                            PoolOptions options = PoolOptions{});
+    ~RemoteFreePoolAllocator() override;
+
+    void *allocate() override;             // owner thread only
+    void deallocate(void *ptr) override;   // any thread
+    std::size_t allocateBulk(void **out, std::size_t n) override; // owner thread only
+    void deallocateBulk(void *const *ptrs, std::size_t n) override; // any thread
+    void *tryAllocate() override;                                   // owner thread only
+    std::size_t tryAllocateBulk(void **out, std::size_t n) override; // owner thread only
+
+    PoolStats getStats() const override;
+    std::size_t trim(bool lazy = false) override; // owner thread only
+
+    // owner-side: move pending remote frees to the local list; returns blocks moved
+    std::size_t drainRemoteFrees();
+    // hand the pool to the calling thread (pool must be quiescent)
+    void adoptCurrentThread() { owner_ = std::this_thread::get_id(); }
+    bool isOwnerThread() const { return std::this_thread::get_id() == owner_; }
+
+    bool owns(const void *p) const
+    {
+        auto u = reinterpret_cast<std::uintptr_t>(p);
+        auto base = reinterpret_cast<std::uintptr_t>(memoryBlock);
+        return u >= base && u < base + alignedObjSize * poolCapacity;
+    }
+
+    // pointer -> owning pool (nullptr if no live RemoteFreePoolAllocator owns it)
+    static RemoteFreePoolAllocator *ownerOf(const void *p);
+    // free p into whichever pool owns it; false if none does
+    static bool release(void *p);
+
+private:
+    std::thread::id owner_;
+    std::size_t registrySlot_ = 0;
+
+    // MPSC Treiber stack linked through the first word of each block. Producers
+    // CAS-push; the single consumer takes the whole chain with exchange(), so the
+    // pop side has no ABA window.
+    alignas(64) std::atomic<void *> remoteHead_{nullptr};
+    std::atomic<std::uint64_t> remoteFrees_{0};
+    std::atomic<std::uint64_t> remoteDrains_{0};
+
+    void remotePushChain_(void *first, void *last);
 };
@@ -3,6 +3,23 @@
 #include <cstdint>
 #include <functional>
 
+#include "utils/prefetch.hpp"
+
+// Where the pool's block storage comes from (see utils/osMemory.hpp)
+enum class PoolBacking : std::uint8_t
+{
+    Malloc,   // std::malloc
+    Mmap,     // anonymous mmap, base pages
+    HugePages // 2 MiB pages: MAP_HUGETLB, else 2 MiB aligned + madvise(MADV_HUGEPAGE)
+};
+
+// How PoolStats counters are kept (see PoolOptions::metrics)
+enum class PoolMetrics : std::uint8_t
+{
+    Shared, // one block of atomics; exact high watermark (CAS loop per allocation)
+    Sharded // per-thread cache-line shards summed by getStats(); approximate high watermark
+};
+
 struct PoolOptions
 {
     bool zero_on_alloc = false;
@@ -10,11 +27,79 @@ struct PoolOptions
     bool verify_poison_on_alloc = false;
     unsigned char poison_byte = 0xA5;
 
+    // Freed blocks are held back from reuse until quarantine_size later frees
+    // (per thread on LockFreePoolAllocator) have happened. Eviction releases the
+    // oldest quarantine_batch blocks at once (one CAS on the lock-free pool), so up
+    // to quarantine_size + quarantine_batch - 1 blocks are parked. With
+    // quarantine_min_age_us a block is also held at least that long unless the
+    // ring is full (counted in PoolStats::quarantine_early).
     std::size_t quarantine_size = 0;
+    std::size_t quarantine_batch = 1;
+    std::uint32_t quarantine_min_age_us = 0;
+
+    // LockFreePoolAllocator only: per-thread magazine cache in front of the shared
+    // free list. Blocks move to/from the shared list in batches of magazine_size
+    // with a single CAS; a thread holds at most 2 * magazine_size cached blocks.
+    // 0 = disabled (every call hits the shared head).
+    std::size_t magazine_size = 0;
+
+    // Layout. alignment (power of two, 0 = alignof(max_align_t)) is both the block
+    // alignment and the stride granularity: 64 or 128 gives every object its own
+    // cache line (pair), so objects handed to different threads never false-share.
+    // color shifts the first block that many bytes past the slab base (rounded to
+    // the block alignment) so same-index objects of different slabs land in
+    // different L1/L2 sets; SizeClassPool rotates it per slab by color_step bytes
+    // within one 4 KiB page.
+    std::size_t alignment = 0;
+    std::size_t color = 0;
+    std::size_t color_step = 0;
+
+    // Growth. max_capacity > capacity makes the pool growable: address space for
+    // max_capacity blocks is reserved up front (nothing backed) and slabs are
+    // committed on demand when the free list and the current slab run dry, the
+    // first growth adding `capacity` blocks and each later one twice the previous
+    // (up to 64x), so memory follows the load instead of the worst case. Block
+    // indices, range checks and memory()/blockSize() cover the whole reservation,
+    // so lookups stay O(1). Empty slab pages go back to the OS with trim().
+    std::size_t max_capacity = 0;
+
+    // Block storage. Blocks are handed out from a bump cursor until first reuse,
+    // so construction is O(1) and pages are only touched when first allocated;
+    // prefault instead touches the whole slab up front (forces an mmap backing).
+    PoolBacking backing = PoolBacking::Malloc;
+    bool prefault = false;
+    int numa_node = -1; // >= 0: bind the slab (and side arrays) to this node; forces mmap
+
+    // Shared: every thread writes the same counters, so on a busy lock-free pool
+    // that line is as contended as the free-list head. Sharded: each thread (up to
+    // 63, the rest share one shard) updates a 64-byte shard of its own with plain
+    // stores; alloc/free/failure/in_use counts stay exact, high_watermark becomes
+    // an upper bound (sum of per-shard peaks, clamped to capacity) that is exact
+    // when threads free what they allocate.
+    PoolMetrics metrics = PoolMetrics::Shared;
+
+    // Hardware prefetch hints on allocate(). prefetch_next pulls in the block the
+    // next allocate() will hand out together with its link (the block itself, or
+    // next_[idx] / the magazine slot on the lock-free pool), so a live set larger
+    // than L2 does not miss on every pop. prefetch_write issues a prefetch-for-write
+    // of the block being returned (and of the next one), so the caller's first
+    // store does not wait for the line in exclusive state.
+    bool prefetch_next = false;
+    bool prefetch_write = false;
+    prefetch::Locality prefetch_locality = prefetch::Locality::High;
 
     bool sample_histograms = false;
     std::size_t histogram_buckets = 64;
 
+    // record every allocate/deallocate with its call site into the calling
+    // thread's alloc_trace ring (utils/allocTrace.hpp); source = the pool
+    bool trace = false;
+
+    // alloc_stats registry (utils/allocStats.hpp): the pool adds itself under
+    // stats_name (copied, may be null) so Sampler / prometheus() see it
+    bool register_stats = true;
+    const char *stats_name = nullptr;
+
     std::function<void(void *ptr, std::size_t size)> on_alloc = {};
     std::function<void(void *ptr, std::size_t size)> on_free = {};
 
@@ -25,13 +110,14 @@ struct PoolOptions
         o.poison_on_free = true;
         o.verify_poison_on_alloc = true;
         o.quarantine_size = quarantine;
+        o.quarantine_batch = quarantine >= 64 ? 16 : 1;
         o.sample_histograms = true;
         return o;
     }
     static PoolOptions MinimalOverhead()
     {
         PoolOptions o;
-        // all defaults already minimal
+        o.metrics = PoolMetrics::Sharded;
         return o;
     }
 };
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "allocators/poolAllocator.hpp"
+
+// Fixed-size block pool living entirely inside a shared mapping, for zero-copy
+// messaging between processes on one host. The header, the lock-free free list
+// and the blocks are all in the region and refer to each other by block index,
+// never by pointer, so every process may map it at a different address:
+//
+//   [Header: layout, tagged free-list head, bump cursor, counters]
+//   [next[capacity]: uint32 link per block]   (as LockFreePoolAllocator::next_)
+//   [blocks, 64-byte aligned stride]
+//
+// Any attached process allocates and frees with the lock-free pool's algorithm
+// (tagged 64-bit head CAS, links in the side array) and passes blocks to the
+// others as Handle values (block indices); at(h) turns one into a local pointer.
+//
+// The region is a POSIX shared-memory object (create/open/unlink), an
+// anonymous MAP_SHARED mapping inherited across fork() (anonymous), or a
+// regular file (openFile). snapshot() copies a quiescent region into a file
+// that openFile() maps back later: the image is position independent.
+//
+// A process that dies holding blocks leaks them until the region is rebuilt;
+// counters are shared, so PoolStats covers all processes.
+class SharedMemoryPool
+{
+public:
+    using Handle = std::uint32_t;
+    static constexpr Handle kNullHandle = 0xFFFFFFFFu;
+
+    // throws std::system_error when the OS refuses, std::invalid_argument when an
+    // opened region is not a pool (or was built by an incompatible version)
+    static SharedMemoryPool create(const std::string &name, std::size_t objectSize, std::size_t capacity);
+    static SharedMemoryPool open(const std::string &name);
+    static bool unlink(const std::string &name);
+    static SharedMemoryPool anonymous(std::size_t objectSize, std::size_t capacity);
+    static SharedMemoryPool openFile(const std::string &path);
+    bool snapshot(const std::string &path) const; // pool must be quiescent
+
+    ~SharedMemoryPool();
+    SharedMemoryPool(SharedMemoryPool &&o) noexcept;
+    SharedMemoryPool &operator=(SharedMemoryPool &&o) noexcept;
+    SharedMemoryPool(const SharedMemoryPool &) = delete;
+    SharedMemoryPool &operator=(const SharedMemoryPool &) = delete;
+
+    void *allocate() { return at(allocateHandle()); }
+    void deallocate(void *ptr);
+    Handle allocateHandle(); // kNullHandle when exhausted
+    void deallocateHandle(Handle h);
+
+    void *at(Handle h) const
+    {
+        return h < capacity_ ? blocks_ + static_cast<std::size_t>(h) * stride_ : nullptr;
+    }
+    Handle handleOf(const void *p) const; // kNullHandle if p is not a block of this pool
+    bool owns(const void *p) const { return handleOf(p) != kNullHandle; }
+
+    std::size_t capacity() const { return capacity_; }
+    std::size_t objectSize() const { return objectSize_; }
+    std::size_t stride() const { return stride_; }
+    std::size_t used() const;
+    void *region() const { return base_; }
+    std::size_t regionBytes() const { return bytes_; }
+
+    PoolStats getStats() const; // counters of every attached process
+
+private:
+    struct Header;
+
+    SharedMemoryPool() = default;
+    static SharedMemoryPool mapFd_(int fd, std::size_t bytes, bool init, std::size_t objectSize,
+                                   std::size_t capacity);
+    void attach_(); // derive next_/blocks_ from the header, validating it
+    void release_();
+
+    char *base_ = nullptr;
+    std::size_t bytes_ = 0;
+    int fd_ = -1;
+    Header *hdr_ = nullptr;
+    std::uint32_t *next_ = nullptr;
+    char *blocks_ = nullptr;
+    std::size_t stride_ = 0;
+    std::size_t objectSize_ = 0;
+    std::uint32_t capacity_ = 0;
+};
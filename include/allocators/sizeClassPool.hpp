@@ -1,40 +1,161 @@
 // sizeClassPool.hpp
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <cstddef>
-#include <map>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
 #include <memory>
-#include <cmath>
+#include <mutex>
 #include "poolAllocator.hpp"
 
+namespace size_class
+{
+    // tcmalloc-style spacing: 16-byte steps up to 128, then four classes per
+    // power of two, so internal fragmentation stays below ~20% instead of 50%.
+    inline constexpr std::array<std::size_t, 33> kSizes = {
+        8, 16, 32, 48, 64, 80, 96, 112, 128,
+        160, 192, 224, 256,
+        320, 384, 448, 512,
+        640, 768, 896, 1024,
+        1280, 1536, 1792, 2048,
+        2560, 3072, 3584, 4096,
+        5120, 6144, 7168, 8192};
+    inline constexpr std::size_t kCount = kSizes.size();
+    inline constexpr std::size_t kMaxSize = kSizes[kCount - 1];
+    inline constexpr std::size_t kSmallMax = 1024; // 8-byte lookup granularity up to here
+
+    // slot i of the table covers sizes up to base + i * step
+    template <std::size_t Base, std::size_t Step, std::size_t N>
+    constexpr std::array<std::uint8_t, N> buildLookup()
+    {
+        std::array<std::uint8_t, N> t{};
+        std::size_t cls = 0;
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            while (kSizes[cls] < Base + i * Step)
+                ++cls;
+            t[i] = static_cast<std::uint8_t>(cls);
+        }
+        return t;
+    }
+    inline constexpr auto kSmallLookup = buildLookup<0, 8, kSmallMax / 8 + 1>();
+    inline constexpr auto kLargeLookup = buildLookup<kSmallMax, 128, (kMaxSize - kSmallMax) / 128 + 1>();
+
+    // O(1): one shift and one table load; size must be <= kMaxSize
+    constexpr std::size_t indexFor(std::size_t size)
+    {
+        return size <= kSmallMax ? kSmallLookup[(size + 7) >> 3]
+                                 : kLargeLookup[(size - kSmallMax + 127) >> 7];
+    }
+    constexpr std::size_t sizeFor(std::size_t size) { return kSizes[indexFor(size)]; }
+
+    static_assert(indexFor(0) == 0 && indexFor(8) == 0 && indexFor(9) == 1);
+    static_assert(sizeFor(33) == 48 && sizeFor(129) == 160 && sizeFor(1025) == 1280);
+    static_assert(sizeFor(kMaxSize) == kMaxSize);
+}
+
+// Sized-allocation front end: one chain of pools per size class.
+// Bucket creation and growth are thread-safe; allocation from a bucket is as
+// thread-safe as AllocatorType (use LockFreePoolAllocator for shared access).
 template <typename AllocatorType = PoolAllocator>
 class SizeClassPool
 {
 public:
-    explicit SizeClassPool(size_t maxSize = 1024, size_t objectsPerClass = 1024)
-        : maxObjectSize(maxSize), objectsPerBucket(objectsPerClass) {}
+    explicit SizeClassPool(size_t maxSize = 1024, size_t objectsPerClass = 1024,
+                           PoolOptions options = PoolOptions{})
+        : maxObjectSize(maxSize < size_class::kMaxSize ? maxSize : size_class::kMaxSize),
+          objectsPerBucket(objectsPerClass ? objectsPerClass : 1),
+          poolOptions(std::move(options)) {}
+
+    ~SizeClassPool()
+    {
+        for (auto &b : buckets)
+        {
+            Slab *s = b.head.load(std::memory_order_relaxed);
+            while (s)
+            {
+                Slab *older = s->older;
+                delete s;
+                s = older;
+            }
+        }
+    }
+
+    SizeClassPool(const SizeClassPool &) = delete;
+    SizeClassPool &operator=(const SizeClassPool &) = delete;
 
     void *allocate(size_t size)
     {
         if (size > maxObjectSize)
             return nullptr;
-        size_t bucketSize = alignToBucket(size);
-        if (buckets.find(bucketSize) == buckets.end())
+        Bucket &b = buckets[size_class::indexFor(size)];
+        Slab *s = b.active.load(std::memory_order_acquire);
+        if (s)
         {
-            buckets[bucketSize] = std::make_unique<AllocatorType>(bucketSize, objectsPerBucket);
+            if (void *p = s->pool->tryAllocate())
+                return p;
         }
-        return buckets[bucketSize]->allocate();
+        return allocateSlow_(b, size_class::indexFor(size));
     }
 
+    // ptr must come from allocate(size') with size' in the same class; anything
+    // else aborts like a foreign free on the underlying pools
     void deallocate(void *ptr, size_t size)
     {
-        if (!ptr || size > maxObjectSize)
+        if (!ptr)
+            return;
+        Slab *s = size > maxObjectSize ? nullptr : owner_(buckets[size_class::indexFor(size)], ptr);
+        if (!s)
+            foreignFree_(ptr, size);
+        s->pool->deallocate(ptr);
+    }
+
+    // Batch variants: n objects of the same size class, one bulk call per slab touched.
+    size_t allocateBulk(size_t size, void **out, size_t n)
+    {
+        if (size > maxObjectSize)
+            return 0;
+        const size_t cls = size_class::indexFor(size);
+        Bucket &b = buckets[cls];
+        size_t got = 0;
+        if (Slab *s = b.active.load(std::memory_order_acquire))
+            got = s->pool->tryAllocateBulk(out, n);
+        while (got < n)
+        {
+            // active slab ran dry: fall back one object at a time, which also
+            // moves the active hint or grows the chain
+            void *p = allocateSlow_(b, cls);
+            if (!p)
+                break;
+            out[got++] = p;
+            if (got < n)
+                got += b.active.load(std::memory_order_acquire)->pool->tryAllocateBulk(out + got, n - got);
+        }
+        return got;
+    }
+
+    void deallocateBulk(void *const *ptrs, size_t n, size_t size)
+    {
+        if (!ptrs || n == 0)
             return;
-        size_t bucketSize = alignToBucket(size);
-        auto it = buckets.find(bucketSize);
-        if (it != buckets.end())
+        if (size > maxObjectSize)
+            foreignFree_(ptrs[0], size);
+        Bucket &b = buckets[size_class::indexFor(size)];
+        // free runs of pointers that share a slab with a single call
+        size_t i = 0;
+        while (i < n)
         {
-            it->second->deallocate(ptr);
+            Slab *s = owner_(b, ptrs[i]);
+            if (!s)
+                foreignFree_(ptrs[i], size);
+            size_t j = i + 1;
+            while (j < n && s->contains(ptrs[j]))
+                ++j;
+            s->pool->deallocateBulk(ptrs + i, j - i);
+            i = j;
         }
     }
 
@@ -55,16 +176,126 @@ public:
         }
     }
 
+    // fork() support (see PoolAllocator::lockForFork): every bucket's growth lock,
+    // then every slab's own locks; nothing can grow a bucket while they are held
+    void lockForFork()
+    {
+        for (Bucket &b : buckets)
+            b.growMtx.lock();
+        for (Bucket &b : buckets)
+            for (Slab *s = b.head.load(std::memory_order_acquire); s; s = s->older)
+                s->pool->lockForFork();
+    }
+    void unlockAfterFork()
+    {
+        for (Bucket &b : buckets)
+            for (Slab *s = b.head.load(std::memory_order_acquire); s; s = s->older)
+                s->pool->unlockAfterFork();
+        for (Bucket &b : buckets)
+            b.growMtx.unlock();
+    }
+
+    // introspection
+    static constexpr size_t classSize(size_t size) { return size_class::sizeFor(size); }
+    size_t slabCount(size_t size) const
+    {
+        return size > maxObjectSize ? 0 : buckets[size_class::indexFor(size)].slabs.load(std::memory_order_relaxed);
+    }
+    size_t maxSize() const { return maxObjectSize; }
+
 private:
-    size_t alignToBucket(size_t size)
+    struct Slab
     {
-        size_t power = 1;
-        while (power < size)
-            power <<= 1;
-        return power;
+        std::unique_ptr<AllocatorType> pool;
+        Slab *older = nullptr; // immutable once published
+        std::uintptr_t begin = 0;
+        std::uintptr_t end = 0;
+
+        bool contains(const void *p) const
+        {
+            auto u = reinterpret_cast<std::uintptr_t>(p);
+            return u >= begin && u < end;
+        }
+    };
+
+    struct Bucket
+    {
+        std::atomic<Slab *> head{nullptr};   // newest slab; chain is append-only
+        std::atomic<Slab *> active{nullptr}; // slab that served the last allocation
+        std::atomic<size_t> slabs{0};
+        std::mutex growMtx;                  // slow path only
+    };
+
+    void *allocateSlow_(Bucket &b, size_t cls)
+    {
+        // retry every published slab (frees land in older slabs too) before growing;
+        // tryAllocate: a dry slab is not a failure the caller sees
+        Slab *head = b.head.load(std::memory_order_acquire);
+        for (Slab *s = head; s; s = s->older)
+        {
+            if (void *p = s->pool->tryAllocate())
+            {
+                b.active.store(s, std::memory_order_release);
+                return p;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(b.growMtx);
+        Slab *cur = b.head.load(std::memory_order_acquire);
+        if (cur != head && cur)
+        {
+            // another thread grew the bucket while we scanned
+            if (void *p = cur->pool->tryAllocate())
+            {
+                b.active.store(cur, std::memory_order_release);
+                return p;
+            }
+        }
+
+        // geometric growth keeps the chain (and the owner_ scan) logarithmic
+        const size_t n = b.slabs.load(std::memory_order_relaxed);
+        const size_t shift = n < kMaxGrowthShift ? n : kMaxGrowthShift;
+        auto s = std::make_unique<Slab>(); // owned here until published: the pool constructor may throw
+        PoolOptions opts = poolOptions;
+        if (opts.color_step)
+            opts.color += (n * opts.color_step) % kColorSpan; // slab coloring: rotate set indices per slab
+        s->pool = std::make_unique<AllocatorType>(size_class::kSizes[cls], objectsPerBucket << shift, opts);
+        s->older = cur;
+        s->begin = reinterpret_cast<std::uintptr_t>(s->pool->memory());
+        s->end = s->begin + s->pool->blockSize();
+        void *p = s->pool->allocate(); // the bucket's last word: a miss here is counted
+        Slab *slab = s.release();
+        b.head.store(slab, std::memory_order_release);
+        b.active.store(slab, std::memory_order_release);
+        b.slabs.store(n + 1, std::memory_order_relaxed);
+        return p;
+    }
+
+    [[noreturn]] static void foreignFree_(const void *ptr, size_t size)
+    {
+        std::cerr << "[ERROR] Invalid pointer passed to SizeClassPool::deallocate(): " << ptr << " (size " << size
+                  << ")\n";
+        std::abort();
     }
 
-    std::map<size_t, std::unique_ptr<AllocatorType>> buckets;
+    static Slab *owner_(Bucket &b, const void *ptr)
+    {
+        Slab *a = b.active.load(std::memory_order_acquire);
+        if (a && a->contains(ptr))
+            return a;
+        for (Slab *s = b.head.load(std::memory_order_acquire); s; s = s->older)
+        {
+            if (s->contains(ptr))
+                return s;
+        }
+        return nullptr;
+    }
+
+    static constexpr size_t kMaxGrowthShift = 6; // slabs stop doubling at 64x objectsPerBucket
+    static constexpr size_t kColorSpan = 4096;   // colors repeat after one page (L1 set-index range)
+
+    std::array<Bucket, size_class::kCount> buckets;
     size_t maxObjectSize;
     size_t objectsPerBucket;
+    PoolOptions poolOptions;
 };
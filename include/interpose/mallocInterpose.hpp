@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Drop-in replacement for malloc/free/calloc/realloc, posix_memalign,
+// aligned_alloc, memalign, valloc, pvalloc, malloc_usable_size and every
+// global operator new/delete (sized, aligned, nothrow), built from
+// src/interpose by `make interpose` as
+//
+//   lib/release/libfinalloc_malloc.so   LD_PRELOAD=lib/release/libfinalloc_malloc.so ./legacy_app
+//   lib/release/libfinalloc_malloc.a    link first (before libc) to replace malloc statically
+//
+// Requests up to size_class::kMaxSize go to a process-wide
+// SizeClassPool<LockFreePoolAllocator> whose pools keep per-thread magazines
+// (the thread cache) and grow on demand inside one 2 MiB aligned reservation
+// per slab; free() finds the size class of a block from a table indexed by its
+// 2 MiB granule, so no block carries a header. Larger requests, and alignments
+// no size class provides, are mmap'd directly behind a 64-byte header, in
+// granules of their own, and realloc()ed with mremap. Memory the pools allocate
+// for themselves while serving a request (slab records, magazines) comes from
+// an internal bump region and is never freed. A pointer in a granule the table
+// does not know was not handed out here; free, realloc and malloc_usable_size
+// pass it to the next allocator in lookup order (dlsym(RTLD_NEXT), link -ldl
+// with the static archive on glibc before 2.34).
+//
+// The pools register with alloc_stats; FINALLOC_STATS=1 in the environment
+// prints alloc_stats::prometheus() to stderr at exit, FINALLOC_STATS=<path>
+// writes it to that file. The library is built without sanitizers (they replace
+// malloc themselves). pthread_atfork handlers hold every allocator lock across
+// fork(), so a child may allocate even if other threads were allocating.
+namespace malloc_interpose
+{
+    inline constexpr std::size_t kGranuleShift = 21; // 2 MiB: pool slabs never share a granule
+    inline constexpr std::size_t kLargeHeader = 64;  // bytes in front of an mmap'd allocation
+    inline constexpr std::size_t kMagazineSize = 32; // blocks per thread-cache batch
+
+    struct Stats
+    {
+        std::uint64_t large_allocs = 0; // mmap'd
+        std::uint64_t large_frees = 0;
+        std::uint64_t large_live_bytes = 0;
+        std::uint64_t internal_bytes = 0; // bump region handed to the pools' own bookkeeping
+    };
+    // pool counters are in alloc_stats (Kind::Pool, name "malloc")
+    Stats stats();
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Process-wide allocator registry and occupancy time series.
+//
+// Every PoolAllocator, ArenaAllocator and ArenaGroup adds a probe on
+// construction (unless its options say register_stats = false) and removes it
+// first thing in its destructor; anything else (a SharedMemoryPool, an
+// application cache) can add() one as Kind::Custom. A probe reads only atomics
+// or state behind the allocator's own locks, so it may run on any thread while
+// the owner keeps allocating; headerless arenas publish their used bytes when
+// they change chunks, not on every bump.
+//
+// Sampler polls all probes every `interval` into a fixed ring of Samples
+// (single writer, per-row sequence numbers, so history() never blocks it) and,
+// with exportFile(), mirrors the latest round into a mmap'd file a monitoring
+// agent reads without a syscall per metric (see StatsFileHeader). prometheus()
+// renders a round in the Prometheus text exposition format.
+namespace alloc_stats
+{
+    enum class Kind : std::uint8_t
+    {
+        Pool,
+        Arena,
+        ArenaGroup,
+        Custom
+    };
+    const char *kindName(Kind k);
+
+    // one allocator at one instant; trivially copyable and a whole number of words
+    struct Sample
+    {
+        std::uint64_t ns = 0;             // steady clock
+        std::uint64_t id = 0;             // registry id, unique for the process lifetime
+        std::uint64_t capacity_bytes = 0; // pool: committed blocks * stride; arena: chunk bytes; group: cached bytes
+        std::uint64_t used_bytes = 0;     // pool: live blocks * stride; arena: bytes handed out; group: checked out
+        std::uint64_t objects = 0;        // pool: live blocks; arena: chunks; group: cached slabs
+        std::uint64_t high_watermark = 0; // pool: peak live blocks; arena: peak used bytes
+        std::uint64_t alloc_calls = 0;
+        std::uint64_t free_calls = 0;
+        std::uint64_t alloc_failures = 0;
+        Kind kind = Kind::Pool;
+        char name[31] = {}; // PoolOptions/ArenaOptions/ArenaGroupOptions::stats_name, truncated
+
+        // share of the held bytes that is idle (0 when nothing is held)
+        double idleRatio() const
+        {
+            return capacity_bytes ? 1.0 - static_cast<double>(used_bytes) / static_cast<double>(capacity_bytes) : 0.0;
+        }
+    };
+    static_assert(sizeof(Sample) % sizeof(std::uint64_t) == 0, "Sample is copied word by word");
+
+    using Probe = std::function<void(Sample &)>; // fills everything but ns, id, kind and name
+
+    // returns the registry id; name may be null
+    std::uint64_t add(Kind kind, const char *name, Probe probe);
+    // after it returns the probe is not running and never runs again (so it must
+    // not be called from a probe); probes themselves may allocate
+    void remove(std::uint64_t id);
+    std::size_t registered();
+
+    // fork() support for the malloc interposer's pthread_atfork handlers:
+    // lockForFork() takes the entry list lock add() needs (a pool built in the
+    // child registers itself); unlockAfterFork() releases it, and in the child
+    // also resets the round lock, since a round another thread was running is gone
+    void lockForFork();
+    void unlockAfterFork(bool inChild);
+
+    // one Sample per registered allocator, taken now
+    std::vector<Sample> sampleAll();
+
+    // Prometheus text format: finalloc_capacity_bytes, finalloc_used_bytes,
+    // finalloc_objects, finalloc_high_watermark, finalloc_idle_ratio (gauges) and
+    // finalloc_alloc_calls_total / free_calls_total / alloc_failures_total
+    // (counters), labelled {id, kind, name}.
+    void prometheus(std::ostream &os, const std::vector<Sample> &samples);
+    std::string prometheus(); // of sampleAll()
+
+    // Layout of the exportFile() mapping: this header followed by `capacity`
+    // Sample rows, of which the first `count` are the latest round. The writer
+    // makes `seq` odd while it updates the rows and even when done; a reader
+    // copies the rows between two equal even reads of `seq`.
+    struct StatsFileHeader
+    {
+        std::uint64_t magic = 0; // kStatsFileMagic
+        std::uint32_t version = 0;
+        std::uint32_t row_bytes = 0; // sizeof(Sample)
+        std::atomic<std::uint64_t> seq{0};
+        std::uint64_t capacity = 0;
+        std::uint64_t count = 0;
+        std::uint64_t rounds = 0;
+        std::uint64_t ns = 0; // time of the last round
+        std::uint64_t reserved = 0;
+    };
+    static_assert(sizeof(StatsFileHeader) == 64, "rows start on the second cache line");
+    inline constexpr std::uint64_t kStatsFileMagic = 0x46696e416c537473ull; // "FinAlSts"
+    inline constexpr std::uint32_t kStatsFileVersion = 1;
+
+    // the latest round of a file written by Sampler::exportFile(); empty if the
+    // file is missing, not a stats file, or kept changing for too long
+    std::vector<Sample> readStatsFile(const std::string &path);
+
+    class Sampler
+    {
+    public:
+        explicit Sampler(std::chrono::milliseconds interval = std::chrono::milliseconds(100),
+                         std::size_t ringRows = 1 << 14);
+        ~Sampler(); // stops the thread, unmaps the export file
+        Sampler(const Sampler &) = delete;
+        Sampler &operator=(const Sampler &) = delete;
+
+        // map `path` (created or truncated) with room for maxAllocators rows; false on failure
+        bool exportFile(const std::string &path, std::size_t maxAllocators = 1024);
+
+        void start(); // no-op if running
+        void stop();
+
+        void sampleOnce(); // one round on the calling thread
+
+        // rows still in the ring, oldest first; sinceNs filters on Sample::ns
+        std::vector<Sample> history(std::uint64_t sinceNs = 0) const;
+        std::uint64_t rounds() const { return rounds_.load(std::memory_order_relaxed); }
+        std::uint64_t overwritten() const; // oldest rows the ring no longer holds
+
+    private:
+        struct Row;
+        void loop_();
+        void push_(const Sample &s);
+        void publishFile_(const std::vector<Sample> &round, std::uint64_t ns);
+
+        std::chrono::milliseconds interval_;
+        std::size_t mask_ = 0;
+        std::unique_ptr<Row[]> rows_;
+        std::atomic<std::uint64_t> head_{0}; // rows ever written
+        std::atomic<std::uint64_t> rounds_{0};
+
+        StatsFileHeader *file_ = nullptr;
+        std::size_t fileBytes_ = 0;
+
+        std::mutex mtx_;    // thread state
+        std::mutex runMtx_; // one round at a time: the ring and the file have a single writer
+        std::condition_variable cv_;
+        std::thread thread_;
+        bool stopping_ = false;
+    };
+}
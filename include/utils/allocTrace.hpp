@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Allocation tracing shared by ArenaAllocator (ArenaOptions::journaling) and
+// PoolAllocator (PoolOptions::trace). Every thread writes into its own ring of
+// kRingEvents events; record() is a handful of relaxed stores plus one release
+// store of the ring head, with no lock and no allocation after the thread's
+// first event. When a ring wraps before drain() the oldest events are dropped
+// (and counted); a running thread's ring yields at most its kRingEvents - 1
+// newest, since the slot after them may be mid-overwrite. drain() collects
+// every thread's ring, oldest first.
+//
+// Call sites are return addresses. symbolize() resolves them in-process with
+// dladdr (exported symbols only, i.e. link with -rdynamic for the executable);
+// dump() also prints module+offset so the log can be symbolized offline:
+//
+//   addr2line -f -C -e ./bin/app 0x1a2b3
+namespace alloc_trace
+{
+    enum class Op : std::uint8_t
+    {
+        Alloc,
+        Free,
+        Reset, // arena reset()/release()/rewind(); size = bytes dropped
+    };
+
+    struct Event
+    {
+        std::uint64_t tsc = 0;         // TscClock::now()
+        const void *source = nullptr;  // the allocator
+        const void *ptr = nullptr;
+        const void *site = nullptr;    // return address into the caller
+        std::uint32_t size = 0;        // saturates at 4 GiB
+        std::uint16_t thread = 0;      // ring id, stable for the thread's lifetime
+        Op op = Op::Alloc;
+    };
+
+    inline constexpr std::size_t kRingEvents = 4096; // per thread, power of two
+
+    void record(Op op, const void *source, const void *ptr, std::size_t size, const void *site) noexcept;
+
+    // Everything recorded since the last drain, from all threads, sorted by tsc.
+    std::vector<Event> drain();
+    std::uint64_t dropped(); // events lost to ring wrap-around, total
+
+    struct Symbol
+    {
+        std::string module;        // shared object / executable path, empty if unknown
+        std::uintptr_t offset = 0; // site - module load base (addr2line input)
+        std::string function;      // demangled, empty if not exported
+    };
+    Symbol symbolize(const void *site);
+
+    // One line per event: tsc op size ptr source site module+0xoffset [function]
+    void dump(std::ostream &os, const std::vector<Event> &events, bool resolve = true);
+
+    const char *opName(Op op);
+}
+
+// Address of the instruction after the call into the allocator.
+#define FINALLOC_CALLSITE() __builtin_extract_return_addr(__builtin_return_address(0))
@@ -65,3 +65,106 @@ private:
     std::uint64_t width_;
     std::vector<std::atomic<std::uint64_t>> counts_;
 };
+
+// HDR-style log-linear histogram for latency distributions. Values below
+// 2^SubBits are exact; above that each power of two is split into 2^(SubBits-1)
+// linear sub-buckets, so the relative error is bounded by 2^-(SubBits-1) (~1.6%
+// for the default) over the full 64-bit range in a fixed 30 KiB table.
+// Not thread-safe: keep one per thread and merge() at the end.
+template <unsigned SubBits = 7>
+class LogLinearHistogram
+{
+    static_assert(SubBits >= 2 && SubBits < 32, "SubBits out of range");
+    static constexpr std::uint64_t kSub = std::uint64_t(1) << SubBits;
+    static constexpr std::uint64_t kHalf = kSub >> 1;
+
+public:
+    static constexpr std::size_t kBuckets = kSub + (64 - SubBits) * kHalf;
+
+    LogLinearHistogram() : counts_(kBuckets, 0) {}
+
+    void record(std::uint64_t v, std::uint64_t n = 1)
+    {
+        counts_[indexFor(v)] += n;
+        total_ += n;
+        sum_ += static_cast<double>(v) * static_cast<double>(n);
+        if (v > max_)
+            max_ = v;
+        if (v < min_)
+            min_ = v;
+    }
+
+    void merge(const LogLinearHistogram &o)
+    {
+        for (std::size_t i = 0; i < kBuckets; ++i)
+            counts_[i] += o.counts_[i];
+        total_ += o.total_;
+        sum_ += o.sum_;
+        max_ = std::max(max_, o.max_);
+        min_ = std::min(min_, o.min_);
+    }
+
+    void clear()
+    {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        total_ = 0;
+        sum_ = 0.0;
+        max_ = 0;
+        min_ = ~std::uint64_t(0);
+    }
+
+    // q in [0, 1]; returns the upper edge of the bucket holding the q-quantile
+    // (clamped to the exact max so p100 == max)
+    std::uint64_t percentile(double q) const
+    {
+        if (total_ == 0)
+            return 0;
+        if (q <= 0.0)
+            return min_;
+        std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(total_) + 0.5);
+        if (rank < 1)
+            rank = 1;
+        if (rank > total_)
+            rank = total_;
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBuckets; ++i)
+        {
+            seen += counts_[i];
+            if (seen >= rank)
+                return std::min(upperEdge(i), max_);
+        }
+        return max_;
+    }
+
+    std::uint64_t count() const { return total_; }
+    std::uint64_t max() const { return max_; }
+    std::uint64_t min() const { return total_ ? min_ : 0; }
+    double mean() const { return total_ ? sum_ / static_cast<double>(total_) : 0.0; }
+
+    static std::size_t indexFor(std::uint64_t v)
+    {
+        if (v < kSub)
+            return static_cast<std::size_t>(v);
+        const unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(v));
+        const unsigned shift = msb - (SubBits - 1);
+        const std::uint64_t sub = v >> shift; // in [kHalf, kSub)
+        return static_cast<std::size_t>(kSub + (shift - 1) * kHalf + (sub - kHalf));
+    }
+
+    static std::uint64_t upperEdge(std::size_t idx)
+    {
+        if (idx < kSub)
+            return idx;
+        const std::size_t k = idx - kSub;
+        const unsigned shift = static_cast<unsigned>(k / kHalf) + 1;
+        const std::uint64_t sub = kHalf + k % kHalf;
+        return ((sub + 1) << shift) - 1;
+    }
+
+private:
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t total_ = 0;
+    double sum_ = 0.0;
+    std::uint64_t max_ = 0;
+    std::uint64_t min_ = ~std::uint64_t(0);
+};
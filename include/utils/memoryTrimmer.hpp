@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Background decay: runs registered trim tasks (ArenaGroup::trimIdle, a pool's
+// trim() at a point where it is quiescent, ...) every `period` on its own thread,
+// so returning memory to the OS never sits on an allocation path. A task returns
+// the bytes it handed back. Tasks run one at a time, in registration order;
+// runOnce() runs them on the calling thread instead.
+class MemoryTrimmer
+{
+public:
+    using Task = std::function<std::size_t()>;
+
+    explicit MemoryTrimmer(std::chrono::milliseconds period = std::chrono::seconds(1));
+    ~MemoryTrimmer(); // stops and joins the thread
+    MemoryTrimmer(const MemoryTrimmer &) = delete;
+    MemoryTrimmer &operator=(const MemoryTrimmer &) = delete;
+
+    void add(std::string name, Task task);
+    void start(); // no-op if running
+    void stop();
+    bool running() const;
+
+    std::size_t runOnce();
+
+    struct TaskStats
+    {
+        std::string name;
+        std::uint64_t runs = 0;
+        std::uint64_t trimmed_bytes = 0;
+    };
+    std::vector<TaskStats> stats() const;
+    std::uint64_t trimmedBytes() const; // all tasks, total
+
+private:
+    struct Entry
+    {
+        TaskStats stats;
+        Task task;
+    };
+
+    void loop_();
+
+    std::chrono::milliseconds period_;
+    mutable std::mutex mtx_; // tasks_ and the run state
+    std::mutex runMtx_;      // one pass at a time (thread vs runOnce)
+    std::condition_variable cv_;
+    std::vector<Entry> tasks_;
+    std::thread thread_;
+    bool stopping_ = false;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Thin wrapper over the OS page allocator (mmap/munmap on Linux), shared by the
+// arena and pool back ends. Reports which kind of pages were actually obtained.
+enum class PageBacking : std::uint8_t
+{
+    Heap,            // std::malloc (not from this layer)
+    Small,           // mmap, base pages (4 KiB)
+    TransparentHuge, // mmap + madvise(MADV_HUGEPAGE), 2 MiB aligned; kernel may collapse to THP
+    HugeTlb          // mmap(MAP_HUGETLB) from the reserved hugetlbfs pool
+};
+
+struct OsMapping
+{
+    void *base = nullptr;
+    std::size_t size = 0;  // usable length (rounded to the page size used)
+    std::size_t guard = 0; // PROT_NONE bytes directly below base and above base + size
+    PageBacking backing = PageBacking::Small;
+    bool populated = false; // pre-faulted at map time
+    int node = -1;          // NUMA node the range is bound to (-1 = default policy)
+};
+
+namespace os_memory
+{
+    inline constexpr std::size_t kHugePageSize = std::size_t{2} << 20; // 2 MiB
+
+    std::size_t pageSize();
+
+    // Maps at least `bytes` of zeroed, read-write anonymous memory.
+    // preferHuge: try MAP_HUGETLB, else a 2 MiB aligned region with MADV_HUGEPAGE.
+    // populate:   pre-fault the whole range (MAP_POPULATE / MADV_POPULATE_WRITE).
+    // guard:      one inaccessible base page on each side (skips MAP_HUGETLB, whose
+    //             pages cannot be split by mprotect).
+    // node >= 0:  bind the range to that NUMA node before anything touches it.
+    // Returns a mapping with base == nullptr on failure.
+    OsMapping map(std::size_t bytes, bool preferHuge, bool populate, bool guard = false, int node = -1);
+    void unmap(OsMapping &m);
+
+    // Address space only: PROT_NONE + MAP_NORESERVE, so nothing is charged until
+    // commit() opens a piece of it. preferHuge aligns the range to 2 MiB and asks
+    // for THP (pages are committed piecewise, so MAP_HUGETLB is not used); node
+    // binds the whole range up front. unmap() releases it.
+    OsMapping reserve(std::size_t bytes, bool preferHuge, int node = -1);
+    // Makes the pages covering [p, p + len) of a reserved range read-write;
+    // populate pre-faults them. false if mprotect refused.
+    bool commit(void *p, std::size_t len, bool populate = false);
+
+    // Hands the whole `granule`-sized pages inside [p, p + len) back to the OS while
+    // keeping the range mapped (granule = pageSize(), or kHugePageSize for hugetlb).
+    // MADV_DONTNEED drops them now and the next touch faults in zero pages;
+    // lazy = MADV_FREE, reclaimed only under memory pressure and the old contents
+    // may survive until then. Returns the bytes advised (0 if the kernel refused).
+    std::size_t decommit(void *p, std::size_t len, bool lazy = false, std::size_t granule = 0);
+
+    // NUMA placement via raw mbind/get_mempolicy (no libnuma dependency).
+    // bindToNode only affects pages faulted after the call; strict = MPOL_BIND,
+    // otherwise MPOL_PREFERRED. false when the kernel refuses (no NUMA, seccomp).
+    bool bindToNode(void *base, std::size_t len, int node, bool strict = true);
+    int nodeOfAddress(const void *p); // node backing the (touched) page at p, -1 if unknown
+
+    const char *backingName(PageBacking b);
+}
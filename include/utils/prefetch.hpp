@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+
+// Software prefetch hints (GCC/Clang __builtin_prefetch; prefetchw / prefetcht*
+// on x86). The locality argument of the builtin must be a constant, so the
+// runtime variants switch over it; with a compile-time Locality the branch folds.
+namespace prefetch
+{
+    enum class Locality : std::uint8_t
+    {
+        None = 0,     // non-temporal: use once, keep out of the outer caches
+        Low = 1,      // L3
+        Moderate = 2, // L2
+        High = 3      // all levels (L1)
+    };
+
+    template <Locality L>
+    inline void read(const void *p)
+    {
+        __builtin_prefetch(p, 0, static_cast<int>(L));
+    }
+    template <Locality L>
+    inline void write(const void *p)
+    {
+        __builtin_prefetch(p, 1, static_cast<int>(L));
+    }
+
+    inline void read(const void *p, Locality l)
+    {
+        switch (l)
+        {
+        case Locality::None:
+            read<Locality::None>(p);
+            break;
+        case Locality::Low:
+            read<Locality::Low>(p);
+            break;
+        case Locality::Moderate:
+            read<Locality::Moderate>(p);
+            break;
+        case Locality::High:
+            read<Locality::High>(p);
+            break;
+        }
+    }
+    inline void write(const void *p, Locality l)
+    {
+        switch (l)
+        {
+        case Locality::None:
+            write<Locality::None>(p);
+            break;
+        case Locality::Low:
+            write<Locality::Low>(p);
+            break;
+        case Locality::Moderate:
+            write<Locality::Moderate>(p);
+            break;
+        case Locality::High:
+            write<Locality::High>(p);
+            break;
+        }
+    }
+}
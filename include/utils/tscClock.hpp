@@ -0,0 +1,74 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define FINALLOC_HAS_TSC 1
+#else
+#define FINALLOC_HAS_TSC 0
+#endif
+
+// Cheap timestamp source for latency measurement. On x86 this is rdtsc (~20
+// cycles, fenced so the read is not hoisted across the measured code); ticks are
+// converted to nanoseconds with a one-off calibration against steady_clock.
+// Elsewhere, or when the TSC is not invariant, it falls back to steady_clock.
+class TscClock
+{
+public:
+    static bool available()
+    {
+#if FINALLOC_HAS_TSC
+        unsigned a = 0, b = 0, c = 0, d = 0;
+        if (__get_cpuid_max(0x80000000u, nullptr) < 0x80000007u)
+            return false;
+        __cpuid(0x80000007u, a, b, c, d);
+        return (d & (1u << 8)) != 0; // invariant TSC: constant rate across P/C-states
+#else
+        return false;
+#endif
+    }
+
+    static std::uint64_t now()
+    {
+#if FINALLOC_HAS_TSC
+        _mm_lfence();
+        std::uint64_t t = __rdtsc();
+        _mm_lfence();
+        return t;
+#else
+        return steadyNs();
+#endif
+    }
+
+    static std::uint64_t steadyNs()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              std::chrono::steady_clock::now().time_since_epoch())
+                                              .count());
+    }
+
+    // ns per tick, measured once (blocks for ~window on first call)
+    static double nsPerTick(std::chrono::milliseconds window = std::chrono::milliseconds(20))
+    {
+        static const double ratio = calibrate(window);
+        return ratio;
+    }
+
+    static double calibrate(std::chrono::milliseconds window)
+    {
+#if FINALLOC_HAS_TSC
+        const std::uint64_t ns0 = steadyNs();
+        const std::uint64_t t0 = now();
+        std::this_thread::sleep_for(window);
+        const std::uint64_t ns1 = steadyNs();
+        const std::uint64_t t1 = now();
+        return (t1 > t0) ? static_cast<double>(ns1 - ns0) / static_cast<double>(t1 - t0) : 1.0;
+#else
+        (void)window;
+        return 1.0;
+#endif
+    }
+};
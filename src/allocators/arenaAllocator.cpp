@@ -4,6 +4,14 @@
 #include <cstring>
 #include <algorithm>
 #include <iostream>
+#include <limits>
+#include <new>
+#include <thread>
+
+#include <sched.h>
+
+#include "utils/allocStats.hpp"
+#include "utils/allocTrace.hpp"
 
 namespace
 {
@@ -27,8 +35,24 @@ namespace
         const std::uintptr_t mask = static_cast<std::uintptr_t>(a - 1);
         return (p + mask) & ~mask;
     }
+    // single writer (the arena's owner): a plain store, no locked RMW
+    inline void bump(std::atomic<std::uint64_t> &a, std::uint64_t n = 1)
+    {
+        a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
 }
 
+struct ArenaAllocator::StatMirror
+{
+    std::uint64_t id = 0;
+    std::atomic<std::uint64_t> used{0};
+    std::atomic<std::uint64_t> held{0}; // chunks and spares
+    std::atomic<std::uint64_t> chunks{0};
+    std::atomic<std::uint64_t> peak{0};
+    std::atomic<std::uint64_t> allocs{0}; // header mode only
+    std::atomic<std::uint64_t> resets{0}; // reset/release/rewind
+};
+
 thread_local std::unique_ptr<ArenaAllocator> ThreadLocalArena::tls_ = nullptr;
 
 ArenaAllocator::ArenaAllocator(const ArenaOptions &opts)
@@ -37,17 +61,36 @@ ArenaAllocator::ArenaAllocator(const ArenaOptions &opts)
       nextChunkBytes_(std::max<std::size_t>(opts_.initial_chunk_size, std::size_t{4096})),
       totalBytes_(0),
       group_(nullptr),
-      journalOn_(opts_.journaling),
-      journal_(),
-      journalHead_(0)
+      headerless_(opts_.headerless),
+      padTo_(opts_.pad_to ? next_pow2(opts_.pad_to) : 0),
+      journalOn_(opts_.journaling && !opts_.headerless)
 {
     // start with one chunk
     ArenaChunk first = newChunk_(0);
     chunks_.push_back(std::move(first));
+    loadBump_();
+    registerStats_();
+}
+
+ArenaAllocator::ArenaAllocator(const ArenaOptions &opts, ArenaGroup *group)
+    : opts_(opts),
+      chunks_(),
+      nextChunkBytes_(std::max<std::size_t>(opts_.initial_chunk_size, std::size_t{4096})),
+      totalBytes_(0),
+      group_(group),
+      headerless_(opts_.headerless),
+      padTo_(opts_.pad_to ? next_pow2(opts_.pad_to) : 0),
+      journalOn_(opts_.journaling && !opts_.headerless)
+{
+    chunks_.push_back(newChunk_(0));
+    loadBump_();
+    registerStats_();
 }
 
 ArenaAllocator::~ArenaAllocator()
 {
+    if (stat_)
+        alloc_stats::remove(stat_->id);
     try
     {
         release();
@@ -60,17 +103,24 @@ ArenaAllocator::~ArenaAllocator()
 ArenaAllocator::ArenaAllocator(ArenaAllocator &&o) noexcept
     : opts_(o.opts_),
       chunks_(std::move(o.chunks_)),
+      spare_(std::move(o.spare_)),
       nextChunkBytes_(o.nextChunkBytes_),
       totalBytes_(o.totalBytes_),
       group_(o.group_),
+      headerless_(o.headerless_),
+      cur_(o.cur_),
+      end_(o.end_),
+      padTo_(o.padTo_),
       journalOn_(o.journalOn_),
-      journal_(std::move(o.journal_)),
-      journalHead_(o.journalHead_)
+      markGen_(o.markGen_),
+      markTick_(o.markTick_),
+      cuts_(std::move(o.cuts_))
 {
+    stat_ = std::move(o.stat_); // the registration moves with the chunks
     o.nextChunkBytes_ = 0;
     o.totalBytes_ = 0;
     o.group_ = nullptr;
-    o.journalHead_ = 0;
+    o.cur_ = o.end_ = 0;
 }
 
 ArenaAllocator &ArenaAllocator::operator=(ArenaAllocator &&o) noexcept
@@ -80,24 +130,52 @@ ArenaAllocator &ArenaAllocator::operator=(ArenaAllocator &&o) noexcept
     release();
     opts_ = o.opts_;
     chunks_ = std::move(o.chunks_);
+    spare_ = std::move(o.spare_);
     nextChunkBytes_ = o.nextChunkBytes_;
     totalBytes_ = o.totalBytes_;
     group_ = o.group_;
+    headerless_ = o.headerless_;
+    padTo_ = o.padTo_;
+    cur_ = o.cur_;
+    end_ = o.end_;
     journalOn_ = o.journalOn_;
-    journal_ = std::move(o.journal_);
-    journalHead_ = o.journalHead_;
+    markGen_ = o.markGen_;
+    markTick_ = o.markTick_;
+    cuts_ = std::move(o.cuts_);
+    if (stat_)
+        alloc_stats::remove(stat_->id);
+    stat_ = std::move(o.stat_);
     o.nextChunkBytes_ = 0;
     o.totalBytes_ = 0;
     o.group_ = nullptr;
-    o.journalHead_ = 0;
+    o.cur_ = o.end_ = 0;
     return *this;
 }
 
-void *ArenaAllocator::allocate(std::size_t bytes, std::size_t alignment)
+void *ArenaAllocator::allocateChecked_(std::size_t bytes, std::size_t alignment)
 {
     if (bytes == 0)
         bytes = 1;
 
+    if (headerless_)
+    {
+        // the inline bump missed: zero or odd alignment, or the chunk is full
+        if (alignment == 0)
+            alignment = alignof(std::max_align_t);
+        else if ((alignment & (alignment - 1)) != 0)
+            alignment = next_pow2(alignment);
+        if (!chunks_.empty())
+        {
+            const std::uintptr_t p = align_up(cur_, alignment);
+            if (p <= end_ && bytes <= end_ - p)
+            {
+                cur_ = p + bytes;
+                return reinterpret_cast<void *>(p);
+            }
+        }
+        return allocateSlow_(bytes, alignment);
+    }
+
     // normalize alignment to power-of-two and >= max_align_t
     const std::size_t kMinAlign = alignof(std::max_align_t);
     if (alignment < kMinAlign)
@@ -110,56 +188,227 @@ void *ArenaAllocator::allocate(std::size_t bytes, std::size_t alignment)
     if (!chunks_.empty() && tryAllocFromChunk_(chunks_.back(), bytes, alignment, &out))
     {
         totalBytes_ += bytes;
-        maybeJournal_(bytes, alignment);
+        if (stat_)
+            noteAlloc_();
+        if (journalOn_)
+            maybeJournal_(bytes, out, FINALLOC_CALLSITE());
         return out;
     }
     // slow path: get a new chunk and retry
-    return allocateSlow_(bytes, alignment);
+    return allocateSlow_(bytes, alignment, FINALLOC_CALLSITE());
 }
 
 void ArenaAllocator::reset()
 {
+    if (opts_.verify_on_reset && !headerless_)
+        verifyOrDie_();
+    if (journalOn_)
+        journalReset_(totalBytes_, FINALLOC_CALLSITE());
     for (auto &c : chunks_)
         c.offset = 0;
     totalBytes_ = 0;
-    // keep chunks; journaling left intact
+    loadBump_();
+    invalidateMarkers_();
+    if (stat_)
+        bump(stat_->resets);
+    // keep chunks
+    if (opts_.trim_on_reset)
+        trim();
+    publishStats_();
 }
 
-void ArenaAllocator::release()
+std::size_t ArenaAllocator::trim()
 {
-    // return slabs to group or OS
-    if (group_)
+    syncBump_();
+    invalidateMarkers_();
+    std::size_t dropped = 0;
+    for (auto &c : spare_)
     {
-        for (auto &c : chunks_)
-            group_->release(std::move(c));
+        dropped += c.size;
+        dropChunk_(c);
     }
-    else
+    spare_.clear();
+    if (chunks_.empty())
+        return dropped;
+
+    // the chunk to keep when nothing is live: the largest, so the next burst of the
+    // same size fits without growing again
+    std::size_t keep = chunks_.size();
+    bool anyLive = false;
+    for (std::size_t i = 0; i < chunks_.size(); ++i)
     {
-        for (auto &c : chunks_)
-            osFreeChunk_(c);
+        if (chunks_[i].offset > 0)
+            anyLive = true;
+        else if (keep == chunks_.size() || chunks_[i].size > chunks_[keep].size)
+            keep = i;
     }
+    if (anyLive)
+        keep = chunks_.back().offset == 0 ? chunks_.size() - 1 : chunks_.size(); // the bump window stays
+
+    std::vector<ArenaChunk> kept;
+    kept.reserve(chunks_.size());
+    for (std::size_t i = 0; i < chunks_.size(); ++i)
+    {
+        if (chunks_[i].offset > 0 || i == keep)
+        {
+            kept.push_back(std::move(chunks_[i]));
+        }
+        else
+        {
+            dropped += chunks_[i].size;
+            dropChunk_(chunks_[i]);
+        }
+    }
+    chunks_ = std::move(kept);
+    nextChunkBytes_ = std::max<std::size_t>(std::max(opts_.initial_chunk_size, chunks_.back().size), std::size_t{4096});
+    loadBump_();
+    publishStats_();
+    return dropped;
+}
+
+void ArenaAllocator::release()
+{
+    if (opts_.verify_on_reset && !headerless_)
+        verifyOrDie_();
+    if (journalOn_ && !chunks_.empty())
+        journalReset_(totalBytes_, FINALLOC_CALLSITE());
+    // return slabs to group or OS
+    for (auto &c : chunks_)
+        dropChunk_(c);
+    for (auto &c : spare_)
+        dropChunk_(c);
     chunks_.clear();
+    spare_.clear();
     totalBytes_ = 0;
+    cur_ = end_ = 0;
     nextChunkBytes_ = std::max<std::size_t>(opts_.initial_chunk_size, std::size_t{4096});
+    invalidateMarkers_();
+    if (stat_)
+        bump(stat_->resets);
+    publishStats_();
+}
+
+void ArenaAllocator::invalidateMarkers_()
+{
+    ++markGen_;
+    cuts_.clear();
+}
+
+ArenaAllocator::Marker ArenaAllocator::mark() const
+{
+    Marker m;
+    m.generation = markGen_;
+    m.tick = ++markTick_;
+    if (chunks_.empty())
+        return m;
+    m.chunk = chunks_.size() - 1;
+    m.offset = headerless_ ? static_cast<std::size_t>(cur_ - reinterpret_cast<std::uintptr_t>(chunks_.back().base))
+                           : chunks_.back().offset;
+    m.total = totalBytes_;
+    return m;
+}
+
+void ArenaAllocator::rewind(const Marker &m, bool keepChunks)
+{
+    // the first rewind after m is the one that matters: the cuts are ordered by
+    // both tick and position, so it is also the lowest since m
+    const auto later = std::upper_bound(cuts_.begin(), cuts_.end(), m.tick,
+                                        [](std::uint64_t t, const Cut &c) { return t < c.tick; });
+    const bool cutBelow = later != cuts_.end() &&
+                          (later->chunk < m.chunk || (later->chunk == m.chunk && later->offset < m.offset));
+    if (m.generation != markGen_ || cutBelow)
+    {
+        std::cerr << "[Arena] rewind to an invalidated marker (chunk " << m.chunk << ", offset " << m.offset << ")\n";
+        std::abort();
+    }
+    if (chunks_.empty() && m.chunk == 0 && m.offset == 0)
+        return; // marked (and rewound) an empty arena
+    const std::size_t curOffset = chunks_.empty() ? 0 : mark().offset;
+    if (m.chunk >= chunks_.size() || (m.chunk == chunks_.size() - 1 && m.offset > curOffset))
+    {
+        std::cerr << "[Arena] rewind to a stale marker (chunk " << m.chunk << ", offset " << m.offset << ")\n";
+        std::abort();
+    }
+    if (journalOn_)
+        journalReset_(totalBytes_ - m.total, FINALLOC_CALLSITE());
+    // chunks acquired after the mark, newest first, so spare_.back() is the oldest
+    while (chunks_.size() > m.chunk + 1)
+    {
+        ArenaChunk &c = chunks_.back();
+        c.offset = 0;
+        if (keepChunks)
+            spare_.push_back(std::move(c));
+        else
+            dropChunk_(c);
+        chunks_.pop_back();
+    }
+    chunks_.back().offset = m.offset;
+    totalBytes_ = m.total;
+    loadBump_();
+    // a cut at or above this one can no longer invalidate anything this one doesn't
+    while (!cuts_.empty() && (cuts_.back().chunk > m.chunk ||
+                              (cuts_.back().chunk == m.chunk && cuts_.back().offset >= m.offset)))
+        cuts_.pop_back();
+    cuts_.push_back(Cut{++markTick_, m.chunk, m.offset});
+    if (stat_)
+        bump(stat_->resets);
+    publishStats_();
+}
+
+void ArenaAllocator::dropChunk_(ArenaChunk &c)
+{
+    if (group_)
+        group_->release(std::move(c));
+    else
+        osFreeChunk_(c);
 }
 
 std::size_t ArenaAllocator::bytesRemaining() const
 {
     if (chunks_.empty())
         return 0;
+    if (headerless_)
+        return static_cast<std::size_t>(end_ - cur_);
     const auto &c = chunks_.back();
     return (c.size > c.offset) ? (c.size - c.offset) : 0;
 }
 
 // ---- private: slow path ----
-void *ArenaAllocator::allocateSlow_(std::size_t size, std::size_t alignment)
+void *ArenaAllocator::allocateSlow_(std::size_t size, std::size_t alignment, const void *site)
 {
     // Worst-case within a fresh chunk:
     // [header aligned to max_align] + pre_canary + alignment slack + user + post_canary
-    const std::size_t header = ArenaAllocator::alignUp_(sizeof(BlockHeader), alignof(std::max_align_t));
-    const std::size_t pre = opts_.use_canaries ? opts_.canary_size : 0;
-    const std::size_t post = opts_.use_canaries ? opts_.canary_size : 0;
-    const std::size_t worst = header + pre + alignment + size + post;
+    const bool checked = !headerless_;
+    const std::size_t header = checked ? ArenaAllocator::alignUp_(sizeof(BlockHeader), alignof(std::max_align_t)) : 0;
+    const std::size_t pre = checked && opts_.use_canaries ? opts_.canary_size : 0;
+    const std::size_t post = checked && opts_.use_canaries ? opts_.canary_size : 0;
+    const std::size_t overhead = header + pre + alignment + post;
+    if (size > std::numeric_limits<std::size_t>::max() - overhead)
+        throw std::bad_alloc(); // no chunk can ever hold it
+    const std::size_t worst = overhead + size;
+    syncBump_();
+
+    // a chunk kept by rewind() first; growth resumes where it was
+    if (!spare_.empty() && spare_.back().size >= worst)
+    {
+        chunks_.push_back(std::move(spare_.back()));
+        spare_.pop_back();
+        void *out = nullptr;
+        tryAllocFromChunk_(chunks_.back(), size, alignment, &out);
+        if (headerless_)
+        {
+            loadBump_();
+            publishStats_();
+            return out;
+        }
+        totalBytes_ += size;
+        if (stat_)
+            noteAlloc_();
+        publishStats_();
+        if (journalOn_)
+            maybeJournal_(size, out, site);
+        return out;
+    }
 
     // choose next chunk size: geometric growth bounded, at least 'worst'
     std::size_t want = std::max(nextChunkBytes_, worst);
@@ -192,8 +441,18 @@ void *ArenaAllocator::allocateSlow_(std::size_t size, std::size_t alignment)
             std::abort();
         }
     }
+    if (headerless_)
+    {
+        loadBump_();
+        publishStats_();
+        return out;
+    }
     totalBytes_ += size;
-    maybeJournal_(size, alignment);
+    if (stat_)
+        noteAlloc_();
+    publishStats_();
+    if (journalOn_)
+        maybeJournal_(size, out, site);
     return out;
 }
 
@@ -203,6 +462,16 @@ bool ArenaAllocator::tryAllocFromChunk_(ArenaChunk &c, std::size_t userSize, std
     const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(c.base);
     const std::uintptr_t cur = base + c.offset;
 
+    if (headerless_)
+    {
+        const std::uintptr_t userAddr = align_up(cur, alignment);
+        if (userAddr > base + c.size || userSize > base + c.size - userAddr)
+            return false;
+        c.offset = static_cast<std::size_t>(userAddr + userSize - base);
+        *out = reinterpret_cast<void *>(userAddr);
+        return true;
+    }
+
     const std::size_t hdrAlign = alignof(std::max_align_t);
     const std::uintptr_t hdrAddr = align_up(cur, hdrAlign);
     const std::uintptr_t hdrEnd = hdrAddr + sizeof(BlockHeader);
@@ -211,10 +480,10 @@ bool ArenaAllocator::tryAllocFromChunk_(ArenaChunk &c, std::size_t userSize, std
     const std::size_t post = opts_.use_canaries ? opts_.canary_size : 0;
 
     const std::uintptr_t userAddr = align_up(hdrEnd + pre, alignment);
-    const std::uintptr_t end = userAddr + userSize + post;
-
-    if (end > base + c.size)
+    const std::uintptr_t limit = base + c.size;
+    if (userAddr > limit || userSize > limit - userAddr || post > limit - userAddr - userSize)
         return false;
+    const std::uintptr_t end = userAddr + userSize + post;
 
     // write header
     auto *hdr = reinterpret_cast<BlockHeader *>(hdrAddr);
@@ -244,10 +513,79 @@ ArenaAllocator::ArenaChunk ArenaAllocator::newChunk_(std::size_t minBytes)
     // group_ may be null (no recycler)
     if (group_)
     {
-        // guard/huge flags are harmless no-ops in this portable osAlloc
-        return group_->acquire(want, opts_.guard_pages, opts_.prefer_huge);
+        return group_->acquire(want, opts_.guard_pages, opts_.prefer_huge, opts_.populate);
+    }
+    return osAllocChunk_(want, opts_.guard_pages, opts_.prefer_huge, opts_.populate, opts_.numa_node);
+}
+
+void ArenaAllocator::syncBump_()
+{
+    if (headerless_ && !chunks_.empty())
+    {
+        ArenaChunk &c = chunks_.back();
+        c.offset = static_cast<std::size_t>(cur_ - reinterpret_cast<std::uintptr_t>(c.base));
     }
-    return osAllocChunk_(want, opts_.guard_pages, opts_.prefer_huge);
+}
+
+void ArenaAllocator::loadBump_()
+{
+    if (!headerless_ || chunks_.empty())
+        return;
+    const ArenaChunk &c = chunks_.back();
+    cur_ = reinterpret_cast<std::uintptr_t>(c.base) + c.offset;
+    end_ = reinterpret_cast<std::uintptr_t>(c.base) + c.size;
+}
+
+// ---- private: alloc_stats mirror ----
+void ArenaAllocator::registerStats_()
+{
+    if (!opts_.register_stats)
+        return;
+    stat_ = std::make_unique<StatMirror>();
+    const StatMirror *m = stat_.get(); // outlives the entry: the arena removes it before freeing the mirror
+    stat_->id = alloc_stats::add(alloc_stats::Kind::Arena, opts_.stats_name, [m](alloc_stats::Sample &out)
+                                 {
+                                     out.capacity_bytes = m->held.load(std::memory_order_relaxed);
+                                     out.used_bytes = m->used.load(std::memory_order_relaxed);
+                                     out.objects = m->chunks.load(std::memory_order_relaxed);
+                                     out.high_watermark = m->peak.load(std::memory_order_relaxed);
+                                     out.alloc_calls = m->allocs.load(std::memory_order_relaxed);
+                                     out.free_calls = m->resets.load(std::memory_order_relaxed); });
+    publishStats_();
+}
+
+void ArenaAllocator::publishStats_()
+{
+    if (!stat_)
+        return;
+    std::size_t held = 0;
+    std::size_t used = totalBytes_;
+    if (headerless_)
+    {
+        // no running total: every chunk's offset, the current one still in cur_
+        used = 0;
+        for (std::size_t i = 0; i + 1 < chunks_.size(); ++i)
+            used += chunks_[i].offset;
+        if (!chunks_.empty())
+            used += static_cast<std::size_t>(cur_ - reinterpret_cast<std::uintptr_t>(chunks_.back().base));
+    }
+    for (const auto &c : chunks_)
+        held += c.size;
+    for (const auto &c : spare_)
+        held += c.size;
+    stat_->held.store(held, std::memory_order_relaxed);
+    stat_->chunks.store(chunks_.size(), std::memory_order_relaxed);
+    stat_->used.store(used, std::memory_order_relaxed);
+    if (used > stat_->peak.load(std::memory_order_relaxed))
+        stat_->peak.store(used, std::memory_order_relaxed);
+}
+
+void ArenaAllocator::noteAlloc_()
+{
+    bump(stat_->allocs);
+    stat_->used.store(totalBytes_, std::memory_order_relaxed);
+    if (totalBytes_ > stat_->peak.load(std::memory_order_relaxed))
+        stat_->peak.store(totalBytes_, std::memory_order_relaxed);
 }
 
 // ---- private: canaries and journaling ----
@@ -259,105 +597,522 @@ void ArenaAllocator::writeCanaries_(unsigned char *user, std::size_t size, std::
         std::memset(user + size, opts_.canary_byte, post);
 }
 
-void ArenaAllocator::maybeJournal_(std::size_t size, std::size_t alignment)
+ArenaAllocator::Corruption ArenaAllocator::verify() const
 {
-    if (!journalOn_)
+    if (headerless_)
+        return {}; // no headers or canaries to check
+    for (std::size_t i = 0; i < chunks_.size(); ++i)
+    {
+        Corruption r = verifyChunk_(chunks_[i], i);
+        if (r)
+            return r;
+    }
+    return {};
+}
+
+// Replays the layout of tryAllocFromChunk_: each block starts at the next
+// max_align boundary after the previous block's post canary.
+ArenaAllocator::Corruption ArenaAllocator::verifyChunk_(const ArenaChunk &c, std::size_t idx) const
+{
+    const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(c.base);
+    const std::uintptr_t limit = base + c.offset;
+    std::uintptr_t cur = base;
+    while (cur < limit)
+    {
+        const std::uintptr_t hdrAddr = align_up(cur, alignof(std::max_align_t));
+        const auto *hdr = reinterpret_cast<const BlockHeader *>(hdrAddr);
+        Corruption r;
+        r.chunk = idx;
+        r.block = hdr;
+        if (hdrAddr + sizeof(BlockHeader) > limit || hdr->magic != 0xABCD1234u ||
+            hdr->alignment == 0 || (hdr->alignment & (hdr->alignment - 1)) != 0)
+        {
+            r.found = true;
+            r.what = "header";
+            return r;
+        }
+        const std::uintptr_t userAddr = align_up(hdrAddr + sizeof(BlockHeader) + hdr->pre_canary, hdr->alignment);
+        const std::uintptr_t end = userAddr + hdr->payload_size + hdr->post_canary;
+        if (end > limit || end <= hdrAddr)
+        {
+            r.found = true;
+            r.what = "header";
+            return r;
+        }
+        const auto *user = reinterpret_cast<const unsigned char *>(userAddr);
+        r.block = user;
+        r.payload_size = hdr->payload_size;
+        for (std::size_t i = 0; i < hdr->pre_canary; ++i)
+        {
+            if (user[-1 - static_cast<std::ptrdiff_t>(i)] != opts_.canary_byte)
+            {
+                r.found = true;
+                r.what = "pre-canary";
+                return r;
+            }
+        }
+        for (std::size_t i = 0; i < hdr->post_canary; ++i)
+        {
+            if (user[hdr->payload_size + i] != opts_.canary_byte)
+            {
+                r.found = true;
+                r.what = "post-canary";
+                return r;
+            }
+        }
+        cur = end;
+    }
+    return {};
+}
+
+void ArenaAllocator::verifyOrDie_() const
+{
+    const Corruption r = verify();
+    if (!r)
         return;
+    std::cerr << "[Arena] corrupted " << r.what << " in chunk " << r.chunk
+              << " block=" << r.block << " payload_size=" << r.payload_size << "\n";
+    std::abort();
+}
+
+void ArenaAllocator::maybeJournal_(std::size_t size, void *ptr, const void *site)
+{
     if (size < opts_.journal_threshold_bytes)
         return;
+    alloc_trace::record(alloc_trace::Op::Alloc, this, ptr, size, site);
+}
 
-    if (journal_.empty())
-    {
-        // lazy init a small ring buffer
-        journal_.resize(1024);
-        journalHead_ = 0;
-    }
-    JournalEntry e;
-    e.size = size;
-    e.alignment = alignment;
-    e.retaddr = 0; // portable fallback (no backtrace in this build)
-    journal_[journalHead_] = e;
-    journalHead_ = (journalHead_ + 1) % journal_.size();
+void ArenaAllocator::journalReset_(std::size_t dropped, const void *site)
+{
+    alloc_trace::record(alloc_trace::Op::Reset, this, nullptr, dropped, site);
 }
 
-// ---- public static: portable OS chunk alloc/free ----
+// ---- public static: OS chunk alloc/free ----
+// Plain chunks stay on malloc; huge/populated/guarded chunks are mmapped directly
+// so the kernel can back them with 2 MiB pages or fence them with PROT_NONE
+// pages. The mapping is rounded up, and the extra bytes are usable.
 ArenaAllocator::ArenaChunk
-ArenaAllocator::osAllocChunk_(std::size_t usableBytes, bool /*guards*/, bool /*preferHuge*/)
+ArenaAllocator::osAllocChunk_(std::size_t usableBytes, bool guards, bool preferHuge, bool populate, int node)
 {
     ArenaChunk c;
     c.size = std::max<std::size_t>(usableBytes, std::size_t{4096});
+    c.offset = 0;
+    c.guard_pages = false;
+    if (preferHuge || populate || guards || node >= 0)
+    {
+        OsMapping m = os_memory::map(c.size, preferHuge, populate, guards, node);
+        if (!m.base)
+            throw std::bad_alloc();
+        c.base = m.base;
+        c.size = m.size;
+        c.use_mmap = true;
+        c.guard_pages = m.guard != 0;
+        c.node = m.node;
+        c.backing = m.backing;
+        c.populated = m.populated;
+        return c;
+    }
     c.base = std::malloc(c.size);
     if (!c.base)
         throw std::bad_alloc();
-    c.offset = 0;
     c.use_mmap = false;
-    c.guard_pages = false;
+    c.backing = PageBacking::Heap;
     return c;
 }
 
 void ArenaAllocator::osFreeChunk_(ArenaAllocator::ArenaChunk &c)
 {
     if (c.base)
-        std::free(c.base);
+    {
+        if (c.use_mmap)
+        {
+            OsMapping m;
+            m.base = c.base;
+            m.size = c.size;
+            m.guard = c.guard_pages ? os_memory::pageSize() : 0;
+            os_memory::unmap(m);
+        }
+        else
+        {
+            std::free(c.base);
+        }
+    }
     c.base = nullptr;
     c.size = 0;
     c.offset = 0;
     c.use_mmap = false;
     c.guard_pages = false;
+    c.backing = PageBacking::Heap;
+    c.populated = false;
+    c.node = -1;
 }
 
 namespace
 {
-    static constexpr std::size_t BIN_COUNT = 6; // 64K, 256K, 1M, 4M, 16M, 64M
-    static inline std::size_t class_bytes(std::size_t idx)
+    constexpr std::size_t kNoBin = static_cast<std::size_t>(-1);
+    constexpr std::size_t kMaxShards = 64;
+
+    std::size_t current_cpu()
     {
-        static const std::size_t sizes[BIN_COUNT] = {
-            64 * 1024,
-            256 * 1024,
-            1 * 1024 * 1024,
-            4 * 1024 * 1024,
-            16 * 1024 * 1024,
-            64 * 1024 * 1024};
-        return sizes[(idx < BIN_COUNT) ? idx : BIN_COUNT - 1];
+        const int cpu = ::sched_getcpu();
+        return cpu < 0 ? 0 : static_cast<std::size_t>(cpu);
     }
-    static inline std::size_t pick_index(std::size_t minBytes)
+}
+
+ArenaGroup::ArenaGroup(ArenaGroupOptions opts, int node)
+    : opts_(std::move(opts)), node_(node)
+{
+    auto &sizes = opts_.bin_sizes;
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+    sizes.erase(std::remove(sizes.begin(), sizes.end(), std::size_t{0}), sizes.end());
+    if (sizes.empty())
+        sizes = ArenaGroupOptions{}.bin_sizes;
+
+    std::size_t n = opts_.shards ? opts_.shards : std::max(1u, std::thread::hardware_concurrency());
+    n = std::min(n, kMaxShards);
+    shards_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        shards_.push_back(std::make_unique<Shard>());
+        shards_.back()->bins.resize(sizes.size());
+    }
+
+    if (opts_.register_stats)
+        statsId_ = alloc_stats::add(alloc_stats::Kind::ArenaGroup, opts_.stats_name, [this](alloc_stats::Sample &out)
+                                    {
+                                        const Stats s = stats();
+                                        out.capacity_bytes = s.cached_bytes + s.checked_out_bytes;
+                                        out.used_bytes = s.checked_out_bytes;
+                                        out.objects = s.cached_slabs;
+                                        out.alloc_calls = s.reuse_hits + s.os_allocs; });
+}
+
+ArenaGroup::~ArenaGroup()
+{
+    if (statsId_)
+        alloc_stats::remove(statsId_);
+    for (auto &sh : shards_)
     {
-        for (std::size_t i = 0; i < BIN_COUNT; ++i)
+        for (auto &bin : sh->bins)
         {
-            if (class_bytes(i) >= minBytes)
-                return i;
+            for (auto &s : bin.slabs)
+                ArenaAllocator::osFreeChunk_(s.chunk);
+            bin.slabs.clear();
         }
-        return BIN_COUNT - 1;
     }
 }
 
-ArenaGroup::Chunk ArenaGroup::acquire(std::size_t minBytes, bool guards, bool preferHuge)
+std::size_t ArenaGroup::binFor_(std::size_t minBytes) const
 {
-    std::lock_guard<std::mutex> lock(mtx_);
-    const std::size_t idx = pick_index(minBytes);
-    if (idx >= bins_.size())
-        bins_.resize(BIN_COUNT);
+    const auto &sizes = opts_.bin_sizes;
+    auto it = std::lower_bound(sizes.begin(), sizes.end(), minBytes);
+    return it == sizes.end() ? kNoBin : static_cast<std::size_t>(it - sizes.begin());
+}
+
+std::size_t ArenaGroup::binOf_(std::size_t chunkBytes) const
+{
+    const auto &sizes = opts_.bin_sizes;
+    if (chunkBytes > sizes.back())
+        return kNoBin; // oversize: would be handed out for requests it is far too big for
+    auto it = std::upper_bound(sizes.begin(), sizes.end(), chunkBytes);
+    return it == sizes.begin() ? kNoBin : static_cast<std::size_t>(it - sizes.begin()) - 1;
+}
 
-    auto &vec = bins_[idx].slabs;
-    if (!vec.empty())
+ArenaGroup::Shard &ArenaGroup::localShard_()
+{
+    return *shards_[current_cpu() % shards_.size()];
+}
+
+// newest usable slab; a guarded request only takes guarded slabs, and a huge-page
+// request takes a huge-backed slab over a newer small one. Caller holds sh.mtx.
+bool ArenaGroup::takeFrom_(Shard &sh, std::size_t bin, bool guards, bool preferHuge, Chunk &out)
+{
+    auto &vec = sh.bins[bin].slabs;
+    std::size_t pick = vec.size();
+    for (std::size_t i = vec.size(); i-- > 0;)
     {
-        Chunk c = std::move(vec.back());
-        vec.pop_back();
-        c.offset = 0;
+        if (guards && !vec[i].chunk.guard_pages)
+            continue;
+        const bool huge = vec[i].chunk.backing == PageBacking::HugeTlb ||
+                          vec[i].chunk.backing == PageBacking::TransparentHuge;
+        if (pick == vec.size())
+            pick = i;
+        if (!preferHuge || huge)
+        {
+            pick = i;
+            break;
+        }
+    }
+    if (pick == vec.size())
+        return false;
+    out = std::move(vec[pick].chunk);
+    vec.erase(vec.begin() + static_cast<std::ptrdiff_t>(pick));
+    out.offset = 0;
+    cachedBytes_.fetch_sub(out.size, std::memory_order_relaxed);
+    return true;
+}
+
+void ArenaGroup::expireIdle_(Shard &sh, IdleClock::time_point now, std::vector<Chunk> &victims)
+{
+    if (opts_.trim_after.count() <= 0)
+        return;
+    for (auto &bin : sh.bins)
+    {
+        // the oldest slabs sit at the front
+        std::size_t n = 0;
+        while (n < bin.slabs.size() && now - bin.slabs[n].idleSince > opts_.trim_after)
+        {
+            sh.trimmedBytes += bin.slabs[n].chunk.size;
+            cachedBytes_.fetch_sub(bin.slabs[n].chunk.size, std::memory_order_relaxed);
+            victims.push_back(std::move(bin.slabs[n++].chunk));
+        }
+        bin.slabs.erase(bin.slabs.begin(), bin.slabs.begin() + static_cast<std::ptrdiff_t>(n));
+    }
+}
+
+ArenaGroup::Chunk ArenaGroup::acquire(std::size_t minBytes, bool guards, bool preferHuge, bool populate)
+{
+    const std::size_t bin = binFor_(minBytes);
+    Shard &own = localShard_();
+    if (bin == kNoBin)
+    {
+        // bigger than every class: straight from the OS, and not cached on release
+        Chunk c = ArenaAllocator::osAllocChunk_(minBytes, guards, preferHuge, populate, node_);
+        std::lock_guard<std::mutex> lock(own.mtx);
+        own.checkedOut += static_cast<std::int64_t>(c.size);
+        ++own.osAllocs;
+        return c;
+    }
+
+    Chunk c;
+    std::vector<Chunk> victims;
+    {
+        std::lock_guard<std::mutex> lock(own.mtx);
+        expireIdle_(own, IdleClock::now(), victims);
+        Bin &b = own.bins[bin];
+        ++b.acquires;
+        b.guards = guards;
+        b.huge = preferHuge;
+        if (takeFrom_(own, bin, guards, preferHuge, c))
+        {
+            own.checkedOut += static_cast<std::int64_t>(c.size);
+            ++own.reuseHits;
+        }
+    }
+    if (!victims.empty())
+        freeAll_(victims);
+    if (c.base)
         return c;
+    // own shard empty: steal from the others without waiting on a busy one
+    for (auto &other : shards_)
+    {
+        if (other.get() == &own)
+            continue;
+        std::unique_lock<std::mutex> lock(other->mtx, std::try_to_lock);
+        if (!lock.owns_lock() || other->bins[bin].slabs.empty())
+            continue;
+        if (takeFrom_(*other, bin, guards, preferHuge, c))
+        {
+            lock.unlock();
+            std::lock_guard<std::mutex> ownLock(own.mtx);
+            own.checkedOut += static_cast<std::int64_t>(c.size);
+            ++own.reuseHits;
+            ++own.steals;
+            return c;
+        }
     }
-    const std::size_t want = std::max(minBytes, class_bytes(idx));
-    return ArenaAllocator::osAllocChunk_(want, guards, preferHuge);
+
+    c = ArenaAllocator::osAllocChunk_(std::max(minBytes, opts_.bin_sizes[bin]), guards, preferHuge, populate, node_);
+    std::lock_guard<std::mutex> lock(own.mtx);
+    own.checkedOut += static_cast<std::int64_t>(c.size);
+    ++own.osAllocs;
+    return c;
 }
 
 void ArenaGroup::release(Chunk &&chunk)
 {
     if (!chunk.base || chunk.size == 0)
         return;
-    std::lock_guard<std::mutex> lock(mtx_);
-    const std::size_t idx = pick_index(chunk.size);
-    if (idx >= bins_.size())
-        bins_.resize(BIN_COUNT);
-    chunk.offset = 0;
-    bins_[idx].slabs.emplace_back(std::move(chunk));
+    const std::size_t bin = binOf_(chunk.size);
+    Shard &own = localShard_();
+    std::vector<Chunk> victims;
+    {
+        std::lock_guard<std::mutex> lock(own.mtx);
+        // chunks an arena got elsewhere (before attachGroup) were never checked out;
+        // the sum over shards is clamped in stats()
+        own.checkedOut -= static_cast<std::int64_t>(chunk.size);
+        if (bin == kNoBin ||
+            (opts_.max_slabs_per_bin && own.bins[bin].slabs.size() >= opts_.max_slabs_per_bin) ||
+            (opts_.max_cached_bytes &&
+             cachedBytes_.load(std::memory_order_relaxed) + chunk.size > opts_.max_cached_bytes))
+        {
+            ++own.overflowFrees;
+            victims.push_back(std::move(chunk));
+        }
+        else
+        {
+            chunk.offset = 0;
+            const auto now = IdleClock::now();
+            cachedBytes_.fetch_add(chunk.size, std::memory_order_relaxed);
+            own.bins[bin].slabs.push_back(Slab{std::move(chunk), now});
+            expireIdle_(own, now, victims);
+        }
+    }
+    freeAll_(victims);
+}
+
+std::size_t ArenaGroup::freeAll_(std::vector<Chunk> &victims)
+{
+    std::size_t freed = 0;
+    for (auto &c : victims)
+    {
+        freed += c.size;
+        ArenaAllocator::osFreeChunk_(c);
+    }
+    victims.clear();
+    return freed;
+}
+
+ArenaGroup::Stats ArenaGroup::stats() const
+{
+    Stats s;
+    const auto &sizes = opts_.bin_sizes;
+    s.bins.resize(sizes.size());
+    for (std::size_t i = 0; i < sizes.size(); ++i)
+        s.bins[i].slab_bytes = sizes[i];
+    std::int64_t checkedOut = 0;
+    for (const auto &sh : shards_)
+    {
+        std::lock_guard<std::mutex> lock(sh->mtx);
+        for (std::size_t i = 0; i < sh->bins.size(); ++i)
+        {
+            const Bin &bin = sh->bins[i];
+            s.bins[i].cached += bin.slabs.size();
+            s.bins[i].acquires += bin.acquires;
+            s.cached_slabs += bin.slabs.size();
+            for (const auto &slab : bin.slabs)
+                s.cached_bytes += slab.chunk.size;
+        }
+        checkedOut += sh->checkedOut;
+        s.reuse_hits += sh->reuseHits;
+        s.steals += sh->steals;
+        s.os_allocs += sh->osAllocs;
+        s.prefilled += sh->prefilled;
+        s.trimmed_bytes += sh->trimmedBytes;
+        s.overflow_frees += sh->overflowFrees;
+    }
+    s.checked_out_bytes = checkedOut > 0 ? static_cast<std::size_t>(checkedOut) : 0;
+    return s;
+}
+
+std::size_t ArenaGroup::prefill(std::size_t minBytes, std::size_t count, bool populate)
+{
+    const std::size_t bin = binFor_(minBytes);
+    if (bin == kNoBin || count == 0)
+        return 0;
+    bool guards = false;
+    bool huge = false;
+    for (const auto &sh : shards_)
+    {
+        std::lock_guard<std::mutex> lock(sh->mtx);
+        const Bin &b = sh->bins[bin];
+        if (b.acquires)
+        {
+            guards = guards || b.guards;
+            huge = huge || b.huge;
+        }
+    }
+    // map (and pre-fault) without holding a lock so acquire() never waits on it
+    std::vector<Chunk> fresh;
+    fresh.reserve(count);
+    try
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            fresh.push_back(ArenaAllocator::osAllocChunk_(std::max(minBytes, opts_.bin_sizes[bin]), guards, huge,
+                                                          populate, node_));
+    }
+    catch (const std::bad_alloc &)
+    {
+        // keep what we got; the next acquire() falls back to the OS as usual
+    }
+    std::size_t added = 0;
+    std::vector<Chunk> victims;
+    const auto now = IdleClock::now();
+    for (auto &c : fresh)
+    {
+        const std::size_t into = binOf_(c.size); // page rounding may lift it a class (or past the last)
+        if (into == kNoBin)
+        {
+            victims.push_back(std::move(c));
+            continue;
+        }
+        Shard &sh = *shards_[prefillCursor_.fetch_add(1, std::memory_order_relaxed) % shards_.size()];
+        std::lock_guard<std::mutex> lock(sh.mtx);
+        cachedBytes_.fetch_add(c.size, std::memory_order_relaxed);
+        sh.bins[into].slabs.push_back(Slab{std::move(c), now});
+        ++sh.prefilled;
+        ++added;
+    }
+    freeAll_(victims);
+    return added;
+}
+
+std::size_t ArenaGroup::trim(std::size_t keepBytes)
+{
+    std::size_t cached = stats().cached_bytes;
+    std::size_t freed = 0;
+    std::vector<Chunk> victims;
+    // largest classes first (fewest munmaps for the bytes returned), oldest first
+    for (std::size_t i = opts_.bin_sizes.size(); i-- > 0 && cached > keepBytes;)
+    {
+        for (auto &sh : shards_)
+        {
+            std::size_t bytes = 0;
+            {
+                std::lock_guard<std::mutex> lock(sh->mtx);
+                auto &vec = sh->bins[i].slabs;
+                std::size_t n = 0;
+                while (n < vec.size() && cached > keepBytes)
+                {
+                    cached -= vec[n].chunk.size;
+                    bytes += vec[n].chunk.size;
+                    cachedBytes_.fetch_sub(vec[n].chunk.size, std::memory_order_relaxed);
+                    victims.push_back(std::move(vec[n++].chunk));
+                }
+                vec.erase(vec.begin(), vec.begin() + static_cast<std::ptrdiff_t>(n));
+                sh->trimmedBytes += bytes;
+            }
+            freed += freeAll_(victims);
+            if (cached <= keepBytes)
+                break;
+        }
+    }
+    return freed;
+}
+
+std::size_t ArenaGroup::trimIdle(std::chrono::milliseconds age)
+{
+    const auto cutoff = IdleClock::now() - age;
+    std::size_t freed = 0;
+    std::vector<Chunk> victims;
+    for (auto &sh : shards_)
+    {
+        {
+            std::lock_guard<std::mutex> lock(sh->mtx);
+            for (auto &bin : sh->bins)
+            {
+                std::size_t n = 0;
+                while (n < bin.slabs.size() && bin.slabs[n].idleSince <= cutoff)
+                {
+                    sh->trimmedBytes += bin.slabs[n].chunk.size;
+                    cachedBytes_.fetch_sub(bin.slabs[n].chunk.size, std::memory_order_relaxed);
+                    victims.push_back(std::move(bin.slabs[n++].chunk));
+                }
+                bin.slabs.erase(bin.slabs.begin(), bin.slabs.begin() + static_cast<std::ptrdiff_t>(n));
+            }
+        }
+        freed += freeAll_(victims);
+    }
+    return freed;
 }
@@ -0,0 +1,116 @@
+#include "allocators/arenaBalancer.hpp"
+
+#include <algorithm>
+
+ArenaBalancer::ArenaBalancer(std::vector<ArenaGroup *> groups, ArenaBalancerOptions opts)
+    : opts_(opts)
+{
+    watched_.reserve(groups.size());
+    for (ArenaGroup *g : groups)
+    {
+        if (!g)
+            continue;
+        Watch w;
+        w.group = g;
+        for (const auto &bin : g->stats().bins)
+            w.lastAcquires.push_back(bin.acquires);
+        watched_.push_back(std::move(w));
+    }
+}
+
+ArenaBalancer::~ArenaBalancer()
+{
+    stop();
+}
+
+void ArenaBalancer::start()
+{
+    if (worker_.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopping_ = false;
+    }
+    worker_ = std::thread([this]
+                          { run_(); });
+}
+
+void ArenaBalancer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+}
+
+void ArenaBalancer::run_()
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!cv_.wait_for(lock, opts_.interval, [this]
+                         { return stopping_; }))
+    {
+        lock.unlock();
+        tick();
+        lock.lock();
+    }
+}
+
+void ArenaBalancer::tick()
+{
+    std::uint64_t prefilled = 0;
+    std::uint64_t trimmed = 0;
+    for (Watch &w : watched_)
+    {
+        const ArenaGroup::Stats s = w.group->stats();
+        w.lastAcquires.resize(s.bins.size(), 0);
+
+        // demand since the last tick, and the class that saw most of it
+        std::uint64_t demand = 0;
+        std::size_t busiest = 0;
+        std::uint64_t busiestDemand = 0;
+        for (std::size_t i = 0; i < s.bins.size(); ++i)
+        {
+            const std::uint64_t d = s.bins[i].acquires - w.lastAcquires[i];
+            w.lastAcquires[i] = s.bins[i].acquires;
+            demand += d;
+            if (d > busiestDemand)
+            {
+                busiestDemand = d;
+                busiest = i;
+            }
+        }
+
+        if (s.cached_bytes > opts_.max_idle_bytes)
+            trimmed += w.group->trim(opts_.max_idle_bytes);
+
+        if (demand > 0)
+        {
+            w.quietTicks = 0;
+            const ArenaGroup::BinStats &bin = s.bins[busiest];
+            const std::size_t want = opts_.reserve_slabs + static_cast<std::size_t>(busiestDemand);
+            const std::size_t room = s.cached_bytes < opts_.max_idle_bytes
+                                         ? (opts_.max_idle_bytes - s.cached_bytes) / bin.slab_bytes
+                                         : 0;
+            if (bin.cached < want)
+                prefilled += w.group->prefill(bin.slab_bytes, std::min(want - bin.cached, room), opts_.populate);
+        }
+        else if (++w.quietTicks >= opts_.cold_ticks && s.cached_bytes > opts_.cold_keep_bytes)
+        {
+            trimmed += w.group->trim(opts_.cold_keep_bytes);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    ++stats_.ticks;
+    stats_.prefilled_slabs += prefilled;
+    stats_.trimmed_bytes += trimmed;
+}
+
+ArenaBalancer::Stats ArenaBalancer::stats() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_;
+}
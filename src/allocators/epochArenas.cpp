@@ -0,0 +1,164 @@
+#include "allocators/epochArenas.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+EpochArenas::EpochArenas(ArenaGroup &group, EpochArenasOptions opts)
+    : group_(group),
+      opts_(std::move(opts)),
+      nslots_(std::max<std::size_t>(opts_.max_readers, 1)),
+      slots_(std::make_unique<Slot[]>(nslots_))
+{
+}
+
+EpochArenas::~EpochArenas()
+{
+    for (std::size_t i = 0; i < nslots_; ++i)
+        if (slots_[i].epoch.load(std::memory_order_acquire) != 0)
+        {
+            std::cerr << "[EpochArenas] destroyed while a reader is pinned\n";
+            std::abort();
+        }
+    // the unique_ptrs hand every chunk back to the group
+}
+
+EpochArenas::Slot *EpochArenas::claimSlot_(std::uint64_t e, std::size_t &hint)
+{
+    for (std::size_t n = 1; n < nslots_; ++n)
+    {
+        const std::size_t i = (hint + n) % nslots_;
+        std::uint64_t free = 0;
+        if (slots_[i].epoch.compare_exchange_strong(free, e, std::memory_order_seq_cst))
+        {
+            hint = i;
+            return &slots_[i];
+        }
+    }
+    std::cerr << "[EpochArenas] more than " << nslots_ << " readers pinned (max_readers)\n";
+    std::abort();
+}
+
+std::uint64_t EpochArenas::minPinned_() const
+{
+    std::uint64_t lo = ~std::uint64_t{0};
+    for (std::size_t i = 0; i < nslots_; ++i)
+    {
+        const std::uint64_t e = slots_[i].epoch.load(std::memory_order_seq_cst);
+        if (e != 0 && e < lo)
+            lo = e;
+    }
+    return lo;
+}
+
+std::unique_ptr<ArenaAllocator> EpochArenas::takeCached_()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (cached_.empty())
+        return nullptr;
+    auto a = std::move(cached_.back());
+    cached_.pop_back();
+    ++reused_;
+    return a;
+}
+
+std::unique_ptr<ArenaAllocator> EpochArenas::acquire()
+{
+    if (auto a = takeCached_())
+        return a;
+    if (reclaim() != 0)
+        if (auto a = takeCached_())
+            return a;
+    auto a = std::make_unique<ArenaAllocator>(opts_.arena, &group_);
+    std::lock_guard<std::mutex> lock(mtx_);
+    ++created_;
+    return a;
+}
+
+void EpochArenas::retire(std::unique_ptr<ArenaAllocator> arena)
+{
+    if (!arena)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        // under the lock, so retired_ stays sorted by epoch
+        const std::uint64_t e = epoch_.fetch_add(1, std::memory_order_seq_cst);
+        retired_.push_back(Retired{e, std::move(arena)});
+        ++retiredTotal_;
+    }
+    if (opts_.reclaim_on_retire)
+        reclaim();
+}
+
+std::size_t EpochArenas::reclaim()
+{
+    std::vector<std::unique_ptr<ArenaAllocator>> done;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (retired_.empty())
+            return 0;
+        // a reader pinned at epoch p may hold pointers into arenas retired at p or later
+        const std::uint64_t lo = minPinned_();
+        std::size_t n = 0;
+        while (n < retired_.size() && retired_[n].epoch < lo)
+            ++n;
+        for (std::size_t i = 0; i < n; ++i)
+            done.push_back(std::move(retired_[i].arena));
+        retired_.erase(retired_.begin(), retired_.begin() + static_cast<std::ptrdiff_t>(n));
+    }
+    if (done.empty())
+        return 0;
+
+    for (auto &a : done)
+        a->reset(); // outside the lock: verify_on_reset / trim_on_reset may walk the chunks
+
+    std::size_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        reclaimed_ += done.size();
+        for (auto &a : done)
+        {
+            if (cached_.size() < opts_.max_cached_arenas)
+                cached_.push_back(std::move(a));
+            else
+                ++dropped;
+        }
+        released_ += dropped;
+    }
+    const std::size_t n = done.size();
+    done.clear(); // the arenas that did not fit hand their chunks back to the group here
+    return n;
+}
+
+void EpochArenas::drain()
+{
+    for (;;)
+    {
+        reclaim();
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (retired_.empty())
+                return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+EpochArenas::Stats EpochArenas::stats() const
+{
+    Stats s;
+    s.epoch = epoch_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < nslots_; ++i)
+        s.pinned += slots_[i].epoch.load(std::memory_order_relaxed) != 0;
+    std::lock_guard<std::mutex> lock(mtx_);
+    s.created = created_;
+    s.reused = reused_;
+    s.retired = retiredTotal_;
+    s.reclaimed = reclaimed_;
+    s.released = released_;
+    s.pending = retired_.size();
+    s.cached = cached_.size();
+    return s;
+}
@@ -0,0 +1,372 @@
+#include "allocators/numaAllocator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <sched.h>
+
+namespace
+{
+    std::string read_file(const std::string &path)
+    {
+        std::FILE *f = std::fopen(path.c_str(), "r");
+        if (!f)
+            return {};
+        std::string out;
+        char buf[256];
+        std::size_t n = 0;
+        while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0)
+            out.append(buf, n);
+        std::fclose(f);
+        return out;
+    }
+
+    int current_cpu()
+    {
+        const int cpu = ::sched_getcpu();
+        return cpu < 0 ? 0 : cpu;
+    }
+}
+
+// ---- topology ----
+std::vector<int> NumaTopology::parseList(const char *s)
+{
+    std::vector<int> out;
+    while (s && *s)
+    {
+        char *end = nullptr;
+        const long lo = std::strtol(s, &end, 10);
+        if (end == s)
+        {
+            ++s; // skip separators / trailing newline
+            continue;
+        }
+        long hi = lo;
+        s = end;
+        if (*s == '-')
+        {
+            hi = std::strtol(s + 1, &end, 10);
+            s = end;
+        }
+        for (long v = lo; v <= hi; ++v)
+            out.push_back(static_cast<int>(v));
+    }
+    return out;
+}
+
+NumaTopology::NumaTopology()
+{
+    const std::string base = "/sys/devices/system/node/";
+    nodes_ = parseList(read_file(base + "online").c_str());
+    for (int node : nodes_)
+    {
+        if (static_cast<std::size_t>(node) >= cpusByNode_.size())
+            cpusByNode_.resize(node + 1);
+        cpusByNode_[node] = parseList(read_file(base + "node" + std::to_string(node) + "/cpulist").c_str());
+        for (int cpu : cpusByNode_[node])
+        {
+            if (static_cast<std::size_t>(cpu) >= cpuToNode_.size())
+                cpuToNode_.resize(cpu + 1, 0);
+            cpuToNode_[cpu] = node;
+        }
+    }
+    if (nodes_.empty())
+    {
+        // no sysfs topology: one node with every CPU we can see
+        nodes_.push_back(0);
+        cpusByNode_.assign(1, {});
+        const unsigned n = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < n; ++cpu)
+            cpusByNode_[0].push_back(static_cast<int>(cpu));
+        cpuToNode_.assign(n, 0);
+    }
+}
+
+const NumaTopology &NumaTopology::instance()
+{
+    static const NumaTopology topo;
+    return topo;
+}
+
+int NumaTopology::nodeOfCpu(int cpu) const
+{
+    if (cpu < 0 || static_cast<std::size_t>(cpu) >= cpuToNode_.size())
+        return nodes_.front();
+    return cpuToNode_[cpu];
+}
+
+const std::vector<int> &NumaTopology::cpusOf(int node) const
+{
+    static const std::vector<int> none;
+    if (node < 0 || static_cast<std::size_t>(node) >= cpusByNode_.size())
+        return none;
+    return cpusByNode_[node];
+}
+
+// ---- thread affinity registry ----
+struct ThreadAffinityRegistry::Slot
+{
+    std::thread::id thread = std::this_thread::get_id();
+    std::atomic<int> cpu{-1};
+    std::atomic<int> node{0};
+    std::atomic<std::uint64_t> migrations{0};
+    std::uint32_t callsUntilRefresh = 0; // owner thread only
+    bool valid = false;                  // owner thread only
+};
+
+namespace
+{
+    std::mutex g_affinityMtx;
+    std::vector<std::shared_ptr<ThreadAffinityRegistry::Slot>> g_affinitySlots; // protected by g_affinityMtx
+
+    struct AffinityHolder
+    {
+        std::shared_ptr<ThreadAffinityRegistry::Slot> slot = std::make_shared<ThreadAffinityRegistry::Slot>();
+        AffinityHolder()
+        {
+            std::lock_guard<std::mutex> lock(g_affinityMtx);
+            g_affinitySlots.push_back(slot);
+        }
+        ~AffinityHolder()
+        {
+            std::lock_guard<std::mutex> lock(g_affinityMtx);
+            g_affinitySlots.erase(std::remove(g_affinitySlots.begin(), g_affinitySlots.end(), slot),
+                                  g_affinitySlots.end());
+        }
+    };
+    thread_local AffinityHolder t_affinity;
+}
+
+ThreadAffinityRegistry::Slot &ThreadAffinityRegistry::local_()
+{
+    return *t_affinity.slot;
+}
+
+int ThreadAffinityRegistry::refreshCurrent()
+{
+    Slot &s = local_();
+    const int cpu = current_cpu();
+    const int node = NumaTopology::instance().nodeOfCpu(cpu);
+    if (s.valid && node != s.node.load(std::memory_order_relaxed))
+        s.migrations.store(s.migrations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    s.cpu.store(cpu, std::memory_order_relaxed);
+    s.node.store(node, std::memory_order_relaxed);
+    s.valid = true;
+    s.callsUntilRefresh = kRefreshCalls;
+    return node;
+}
+
+int ThreadAffinityRegistry::currentNode()
+{
+    Slot &s = local_();
+    if (!s.valid || --s.callsUntilRefresh == 0)
+        return refreshCurrent();
+    return s.node.load(std::memory_order_relaxed);
+}
+
+bool ThreadAffinityRegistry::pinCurrentThread(int node)
+{
+    const auto &cpus = NumaTopology::instance().cpusOf(node);
+    if (cpus.empty())
+        return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    if (::sched_setaffinity(0, sizeof(set), &set) != 0)
+        return false;
+    refreshCurrent();
+    return true;
+}
+
+std::vector<ThreadAffinityRegistry::ThreadAffinity> ThreadAffinityRegistry::snapshot()
+{
+    std::lock_guard<std::mutex> lock(g_affinityMtx);
+    std::vector<ThreadAffinity> out;
+    out.reserve(g_affinitySlots.size());
+    for (const auto &s : g_affinitySlots)
+    {
+        ThreadAffinity t;
+        t.thread = s->thread;
+        t.cpu = s->cpu.load(std::memory_order_relaxed);
+        t.node = s->node.load(std::memory_order_relaxed);
+        t.migrations = s->migrations.load(std::memory_order_relaxed);
+        out.push_back(t);
+    }
+    return out;
+}
+
+// ---- allocator ----
+NumaAllocator::NumaAllocator(NumaOptions opts)
+    : opts_(std::move(opts))
+{
+    const NumaTopology &topo = NumaTopology::instance();
+    slotOfNode_.assign(topo.maxNode() + 1, -1);
+    nodes_.reserve(topo.nodeCount());
+    for (int id : topo.nodes())
+    {
+        Node n;
+        n.id = id;
+        PoolOptions po = opts_.pool;
+        po.numa_node = id;
+        n.pool = std::make_unique<LockFreePoolAllocator>(opts_.object_size, opts_.objects_per_node, po);
+        n.arenas = std::make_unique<ArenaGroup>(opts_.group, id);
+        n.counters = std::make_unique<Node::Counters>();
+        n.begin = reinterpret_cast<std::uintptr_t>(n.pool->memory());
+        n.end = n.begin + n.pool->blockSize();
+        slotOfNode_[id] = static_cast<int>(nodes_.size());
+        nodes_.push_back(std::move(n));
+    }
+    if (opts_.balancer.enabled)
+    {
+        std::vector<ArenaGroup *> groups;
+        for (auto &n : nodes_)
+            groups.push_back(n.arenas.get());
+        balancer_ = std::make_unique<ArenaBalancer>(std::move(groups), opts_.balancer);
+        balancer_->start();
+    }
+}
+
+NumaAllocator::~NumaAllocator() = default;
+
+NumaAllocator::Node &NumaAllocator::nodeFor_(int node)
+{
+    if (node < 0)
+        node = ThreadAffinityRegistry::currentNode();
+    if (static_cast<std::size_t>(node) < slotOfNode_.size() && slotOfNode_[node] >= 0)
+        return nodes_[slotOfNode_[node]];
+    return nodes_.front();
+}
+
+const NumaAllocator::Node *NumaAllocator::owner_(const void *ptr) const
+{
+    const auto u = reinterpret_cast<std::uintptr_t>(ptr);
+    for (const auto &n : nodes_)
+    {
+        if (u >= n.begin && u < n.end)
+            return &n;
+    }
+    return nullptr;
+}
+
+void NumaAllocator::noteRemote_(const Node &n, int threadNode, bool isFree)
+{
+    auto &counter = isFree ? n.counters->remote_frees : n.counters->remote_allocs;
+    counter.fetch_add(1, std::memory_order_relaxed);
+    if (opts_.on_remote)
+        opts_.on_remote(threadNode, n.id, isFree);
+}
+
+void *NumaAllocator::allocate()
+{
+    const int here = ThreadAffinityRegistry::currentNode();
+    Node &local = nodeFor_(here);
+    // tryAllocate: a dry node the spill covers is not a failure
+    if (void *p = local.pool->tryAllocate())
+        return p;
+    // local node exhausted: spill to the others rather than fail
+    for (auto &n : nodes_)
+    {
+        if (&n == &local)
+            continue;
+        if (void *p = n.pool->tryAllocate())
+        {
+            noteRemote_(n, here, false);
+            return p;
+        }
+    }
+    return local.pool->allocate(); // every node dry: the counted miss (or a block freed meanwhile)
+}
+
+void *NumaAllocator::allocateOnNode(int node)
+{
+    Node &n = nodeFor_(node);
+    void *p = n.pool->allocate();
+    if (p)
+    {
+        const int here = ThreadAffinityRegistry::currentNode();
+        if (here != n.id)
+            noteRemote_(n, here, false);
+    }
+    return p;
+}
+
+void NumaAllocator::deallocate(void *ptr)
+{
+    if (!ptr)
+        return;
+    const Node *n = owner_(ptr);
+    if (!n)
+    {
+        std::cerr << "[NUMA] deallocate of foreign pointer " << ptr << "\n";
+        std::abort();
+    }
+    const int here = ThreadAffinityRegistry::currentNode();
+    if (here != n->id)
+        noteRemote_(*n, here, true);
+    n->pool->deallocate(ptr);
+}
+
+ArenaGroup &NumaAllocator::arenaGroup(int node)
+{
+    return *nodeFor_(node).arenas;
+}
+
+ArenaAllocator NumaAllocator::makeArena(int node)
+{
+    Node &n = nodeFor_(node);
+    ArenaOptions ao = opts_.arena;
+    ao.numa_node = n.id;
+    return ArenaAllocator(ao, n.arenas.get()); // every chunk, the first included, goes through the group
+}
+
+int NumaAllocator::nodeOf(const void *ptr) const
+{
+    const Node *n = owner_(ptr);
+    return n ? n->id : -1;
+}
+
+LockFreePoolAllocator &NumaAllocator::pool(int node)
+{
+    return *nodeFor_(node).pool;
+}
+
+NumaStats NumaAllocator::getStats() const
+{
+    NumaStats out;
+    out.nodes.reserve(nodes_.size());
+    for (const auto &n : nodes_)
+    {
+        NumaNodeStats ns;
+        ns.node = n.id;
+        ns.pool = n.pool->getStats();
+        ns.arenas = n.arenas->stats();
+        ns.remote_allocs = n.counters->remote_allocs.load(std::memory_order_relaxed);
+        ns.remote_frees = n.counters->remote_frees.load(std::memory_order_relaxed);
+        ns.local_allocs = ns.pool.alloc_calls -
+                          std::min<std::uint64_t>(ns.pool.alloc_calls, ns.pool.alloc_failures + ns.remote_allocs);
+
+        const std::size_t block = ns.pool.aligned_object_size;
+        const std::size_t touched = ns.pool.capacity - std::min(ns.pool.capacity, ns.pool.untouched);
+        const std::size_t live = std::min<std::size_t>(ns.pool.in_use, touched);
+        ns.in_use_bytes = live * block + ns.arenas.checked_out_bytes;
+        ns.fragmented_bytes = (touched - live) * block;
+        ns.idle_bytes = ns.arenas.cached_bytes;
+        ns.untouched_bytes = ns.pool.untouched * block;
+
+        out.remote_allocs += ns.remote_allocs;
+        out.remote_frees += ns.remote_frees;
+        out.nodes.push_back(std::move(ns));
+    }
+    out.threads = ThreadAffinityRegistry::snapshot();
+    for (const auto &t : out.threads)
+        out.migrations += t.migrations;
+    return out;
+}
@@ -1,49 +1,188 @@
 #include "allocators/poolAllocator.hpp"
+#include "utils/allocStats.hpp"
+#include "utils/allocTrace.hpp"
+#include "utils/tscClock.hpp"
+#include <algorithm>
 #include <iostream>
 
-PoolAllocator::PoolAllocator(std::size_t objectSize, std::size_t capacity,
-                             PoolOptions options)
-    : poolCapacity(capacity), options_(options)
+// ---- quarantine ring ----
+void QuarantineRing::init(std::size_t hold, std::size_t batch, std::uint32_t minAgeUs)
 {
-    if (objectSize < sizeof(void *))
-        objectSize = sizeof(void *);
-    alignedObjSize = alignUp(objectSize, alignof(std::max_align_t));
-    const std::size_t totalSize = alignedObjSize * poolCapacity;
+    if (hold == 0)
+        return;
+    batch_ = std::max<std::size_t>(batch, 1);
+    slots_.assign(hold + batch_ - 1, nullptr);
+    scratch_.assign(batch_, nullptr);
+    minAgeNs_ = static_cast<std::uint64_t>(minAgeUs) * 1000;
+    if (minAgeNs_)
+        stamps_.assign(slots_.size(), 0);
+}
 
-    memoryBlock = std::malloc(totalSize);
-    if (!memoryBlock)
-        throw std::bad_alloc();
+std::size_t QuarantineRing::push(void *p)
+{
+    const std::size_t cap = slots_.size();
+    const std::uint64_t now = stamps_.empty() ? 0 : TscClock::steadyNs();
+    std::size_t n = 0;
+    if (count_ == cap)
+    {
+        for (; n < batch_; ++n)
+        {
+            if (!stamps_.empty() && now - stamps_[head_] < minAgeNs_)
+                ++early_;
+            scratch_[n] = slots_[head_];
+            head_ = head_ + 1 == cap ? 0 : head_ + 1;
+        }
+        count_ -= n;
+    }
+    std::size_t tail = head_ + count_;
+    if (tail >= cap)
+        tail -= cap;
+    slots_[tail] = p;
+    if (!stamps_.empty())
+        stamps_[tail] = now;
+    ++count_;
+    return n;
+}
 
-    // Build single-thread free list (in-block links used only by base class)
-    void *block = memoryBlock;
-    for (std::size_t i = 0; i < poolCapacity - 1; ++i)
+std::size_t QuarantineRing::take(std::size_t n)
+{
+    n = std::min({n, count_, scratch_.size()});
+    for (std::size_t i = 0; i < n; ++i)
     {
-        void *next = static_cast<char *>(block) + alignedObjSize;
-        std::memcpy(block, &next, sizeof(void *));
-        block = next;
+        scratch_[i] = slots_[head_];
+        head_ = head_ + 1 == slots_.size() ? 0 : head_ + 1;
     }
-    void *nullPtr = nullptr;
-    std::memcpy(block, &nullPtr, sizeof(void *));
+    count_ -= n;
+    return n;
+}
 
-    nonAtomicFreeListHead = memoryBlock;
+// ---- sharded metrics ----
+namespace
+{
+    constexpr std::size_t kMetricShards = 64;
+    constexpr std::uint32_t kSharedShard = kMetricShards - 1; // threads past the first 63
 
-    // Pre-poison all blocks if requested
-    if (options_.poison_on_free)
+    // Process-wide thread slots, recycled on thread exit. A slot below
+    // kSharedShard belongs to one live thread, so that thread owns shard[slot] in
+    // every pool and can update it with plain load/store pairs instead of RMWs.
+    // Nothing allocates under g_slotMtx, so fork handlers can take it after the pools.
+    std::mutex g_slotMtx;
+    std::uint32_t g_freeSlots[kSharedShard]; // protected by g_slotMtx
+    std::uint32_t g_freeCount = 0;           // protected by g_slotMtx
+    std::uint32_t g_nextSlot = 0;            // protected by g_slotMtx
+
+    struct MetricSlot
     {
-        char *p = static_cast<char *>(memoryBlock);
-        for (std::size_t i = 0; i < poolCapacity; ++i)
+        std::uint32_t slot = kSharedShard;
+        bool valid = false;
+        void acquire()
+        {
+            std::lock_guard<std::mutex> lock(g_slotMtx);
+            if (g_freeCount > 0)
+                slot = g_freeSlots[--g_freeCount];
+            else if (g_nextSlot < kSharedShard)
+                slot = g_nextSlot++;
+            valid = true;
+        }
+        ~MetricSlot()
         {
-            if (alignedObjSize > sizeof(void *))
+            if (valid && slot != kSharedShard)
             {
-                std::memset(p + sizeof(void *), options_.poison_byte, alignedObjSize - sizeof(void *));
+                std::lock_guard<std::mutex> lock(g_slotMtx);
+                g_freeSlots[g_freeCount++] = slot;
             }
-            p += alignedObjSize;
+            slot = kSharedShard; // later thread-exit frees (magazine flushes) use the shared shard
         }
+    };
+    thread_local MetricSlot t_metricSlot;
+
+    std::uint32_t metricSlot()
+    {
+        if (!t_metricSlot.valid)
+            t_metricSlot.acquire();
+        return t_metricSlot.slot;
+    }
+
+    template <typename T>
+    void bump(std::atomic<T> &c, T n, bool exclusive)
+    {
+        if (exclusive)
+            c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        else
+            c.fetch_add(n, std::memory_order_relaxed);
+    }
+}
+
+struct PoolAllocator::MetricShard
+{
+    alignas(64) std::atomic<std::uint64_t> alloc_calls{0};
+    std::atomic<std::uint64_t> free_calls{0};
+    std::atomic<std::uint64_t> alloc_failures{0};
+    std::atomic<std::uint64_t> cas_failures{0};
+    std::atomic<std::int64_t> live{0}; // allocated minus freed through this shard; may go negative
+    std::atomic<std::int64_t> peak{0}; // max of live
+};
+
+PoolAllocator::PoolAllocator(std::size_t objectSize, std::size_t capacity,
+                             PoolOptions options)
+    : poolCapacity(capacity), options_(options)
+{
+    initialCapacity_ = capacity ? capacity : 1;
+    const bool growable = options_.max_capacity > capacity;
+    if (growable)
+        poolCapacity = options_.max_capacity;
+    if (objectSize < sizeof(void *))
+        objectSize = sizeof(void *);
+    std::size_t align = alignof(std::max_align_t);
+    if (options_.alignment > align)
+    {
+        if ((options_.alignment & (options_.alignment - 1)) != 0)
+            throw std::invalid_argument("PoolAllocator: alignment must be a power of two");
+        align = options_.alignment;
     }
+    alignedObjSize = alignUp(objectSize, align);
+    color_ = alignUp(options_.color, align);
+    const std::size_t totalSize = alignedObjSize * poolCapacity + color_;
+
+    void *base = nullptr;
+    if (growable)
+    {
+        slab_ = os_memory::reserve(totalSize, options_.backing == PoolBacking::HugePages, options_.numa_node);
+        if (slab_.base && !os_memory::commit(slab_.base, alignedObjSize * capacity + color_, options_.prefault))
+            os_memory::unmap(slab_);
+        base = slab_.base;
+    }
+    else if (options_.backing != PoolBacking::Malloc || options_.prefault || options_.numa_node >= 0)
+    {
+        slab_ = os_memory::map(totalSize, options_.backing == PoolBacking::HugePages, options_.prefault,
+                               false, options_.numa_node);
+        base = slab_.base; // page aligned
+    }
+    else if (align > alignof(std::max_align_t))
+    {
+        base = std::aligned_alloc(align, alignUp(totalSize ? totalSize : 1, align));
+    }
+    else
+    {
+        base = std::malloc(totalSize);
+    }
+    if (!base)
+        throw std::bad_alloc();
+    memoryBlock = static_cast<char *>(base) + color_;
+
+    // No free-list build: blocks come off the bump cursor (bumpNext_) until they
+    // are first freed, so nothing is written here and untouched pages stay unbacked.
+    nonAtomicFreeListHead = nullptr;
+    bumpNext_ = 0;
+    bumpEnd_ = growable ? capacity : poolCapacity;
+    committed_.store(bumpEnd_, std::memory_order_relaxed);
 
     // Metrics base
     metrics_.in_use.store(0, std::memory_order_relaxed);
     metrics_.high_watermark.store(0, std::memory_order_relaxed);
+    static_assert(sizeof(MetricShard) == 64, "one cache line per metrics shard");
+    if (options_.metrics == PoolMetrics::Sharded)
+        shards_.reset(new MetricShard[kMetricShards]);
 
     // Optional histogram
     if (options_.sample_histograms)
@@ -51,84 +190,472 @@ PoolAllocator::PoolAllocator(std::size_t objectSize, std::size_t capacity,
         occupancyHist_ = new Histogram(0, poolCapacity, options_.histogram_buckets);
     }
 
-    // Quarantine storage (single-thread) — reserve once
-    if (options_.quarantine_size > 0)
-    {
-        quarantine_.reserve(options_.quarantine_size + 1);
-    }
+    // Quarantine ring (single-thread; the lock-free pool keeps one per thread)
+    quarantine_.init(options_.quarantine_size, options_.quarantine_batch, options_.quarantine_min_age_us);
+
+    if (options_.register_stats)
+        statsId_ = alloc_stats::add(alloc_stats::Kind::Pool, options_.stats_name, [this](alloc_stats::Sample &out)
+                                    {
+                                        PoolStats s;
+                                        countersInto_(s);
+                                        out.capacity_bytes = s.capacity * alignedObjSize;
+                                        out.used_bytes = s.in_use * alignedObjSize;
+                                        out.objects = s.in_use;
+                                        out.high_watermark = s.high_watermark;
+                                        out.alloc_calls = s.alloc_calls;
+                                        out.free_calls = s.free_calls;
+                                        out.alloc_failures = s.alloc_failures; });
 }
 
 PoolAllocator::~PoolAllocator()
 {
+    if (statsId_)
+        alloc_stats::remove(statsId_); // before anything the probe reads goes away
     delete occupancyHist_;
     occupancyHist_ = nullptr;
-    std::free(memoryBlock);
+    if (slab_.base)
+        os_memory::unmap(slab_);
+    else
+        std::free(static_cast<char *>(memoryBlock) - color_);
     memoryBlock = nullptr;
     nonAtomicFreeListHead = nullptr;
-    usedCount.store(0, std::memory_order_relaxed);
 }
 
 void *PoolAllocator::allocate()
 {
-    metrics_.alloc_calls.fetch_add(1, std::memory_order_relaxed);
+    return allocateLocal_(FINALLOC_CALLSITE());
+}
 
-    // Pop non-atomically (single-threaded)
-    if (!nonAtomicFreeListHead)
+void PoolAllocator::deallocate(void *ptr)
+{
+    deallocateLocal_(ptr, FINALLOC_CALLSITE());
+}
+
+std::size_t PoolAllocator::allocateBulk(void **out, std::size_t n)
+{
+    return allocateBulkLocal_(out, n, FINALLOC_CALLSITE());
+}
+
+void *PoolAllocator::tryAllocate()
+{
+    return allocateLocal_(FINALLOC_CALLSITE(), false);
+}
+
+std::size_t PoolAllocator::tryAllocateBulk(void **out, std::size_t n)
+{
+    return allocateBulkLocal_(out, n, FINALLOC_CALLSITE(), false);
+}
+
+void PoolAllocator::deallocateBulk(void *const *ptrs, std::size_t n)
+{
+    deallocateBulkLocal_(ptrs, n, FINALLOC_CALLSITE());
+}
+
+void *PoolAllocator::allocateLocal_(const void *site, bool countMiss)
+{
+    // Pop non-atomically (single-threaded); recycled blocks first, then fresh ones
+    void *allocated = nonAtomicFreeListHead;
+    if (allocated)
     {
-        metrics_.alloc_failures.fetch_add(1, std::memory_order_relaxed);
+        std::memcpy(&nonAtomicFreeListHead, allocated, sizeof(void *));
+    }
+    else if (bumpNext_ < bumpEnd_ || refillBump_())
+    {
+        allocated = freshBlock_(bumpNext_++);
+    }
+    else
+    {
+        if (countMiss)
+        {
+            noteAllocCalls_(1);
+            noteAllocFailures_(1);
+        }
         return nullptr;
     }
-    void *allocated = nonAtomicFreeListHead;
-    std::memcpy(&nonAtomicFreeListHead, nonAtomicFreeListHead, sizeof(void *));
+    noteAllocCalls_(1);
+
+    if (options_.prefetch_next)
+    {
+        if (nonAtomicFreeListHead)
+            prefetchBlock_(nonAtomicFreeListHead);
+        else if (bumpNext_ < bumpEnd_)
+            prefetchBlock_(static_cast<char *>(memoryBlock) + bumpNext_ * alignedObjSize);
+    }
+    return afterPop_(allocated, site);
+}
+
+void PoolAllocator::deallocateLocal_(void *ptr, const void *site)
+{
+    if (!ptr)
+        return;
+
+    beforePush_(ptr, site);
+
+    if (options_.quarantine_size > 0)
+    {
+        quarantinePush_(ptr);
+    }
+    else
+    {
+        freeListPush_(ptr);
+    }
+
+    afterPush_();
+}
+
+std::size_t PoolAllocator::allocateBulkLocal_(void **out, std::size_t n, const void *site, bool countMiss)
+{
+    std::size_t got = 0;
+    while (got < n && nonAtomicFreeListHead)
+    {
+        out[got++] = nonAtomicFreeListHead;
+        std::memcpy(&nonAtomicFreeListHead, nonAtomicFreeListHead, sizeof(void *));
+    }
+    while (got < n && (bumpNext_ < bumpEnd_ || refillBump_()))
+        out[got++] = freshBlock_(bumpNext_++);
+    afterPopBulk_(out, got, countMiss ? n : got, site);
+    return got;
+}
+
+void PoolAllocator::deallocateBulkLocal_(void *const *ptrs, std::size_t n, const void *site)
+{
+    if (n == 0)
+        return;
+    beforePushBulk_(ptrs, n, site);
+
+    if (options_.quarantine_size > 0)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            quarantinePush_(ptrs[i]);
+    }
+    else
+    {
+        // link ptrs[0] -> ptrs[1] -> ... -> old head
+        for (std::size_t i = 0; i + 1 < n; ++i)
+            std::memcpy(ptrs[i], &ptrs[i + 1], sizeof(void *));
+        std::memcpy(ptrs[n - 1], &nonAtomicFreeListHead, sizeof(void *));
+        nonAtomicFreeListHead = ptrs[0];
+    }
+
+    afterPushBulk_(n);
+}
+
+void PoolAllocator::noteAllocCalls_(std::size_t n)
+{
+    if (shards_)
+    {
+        const std::uint32_t slot = metricSlot();
+        bump<std::uint64_t>(shards_[slot].alloc_calls, n, slot != kSharedShard);
+        return;
+    }
+    metrics_.alloc_calls.fetch_add(n, std::memory_order_relaxed);
+}
+
+void PoolAllocator::noteAllocFailures_(std::size_t n)
+{
+    if (shards_)
+    {
+        const std::uint32_t slot = metricSlot();
+        bump<std::uint64_t>(shards_[slot].alloc_failures, n, slot != kSharedShard);
+        return;
+    }
+    metrics_.alloc_failures.fetch_add(n, std::memory_order_relaxed);
+}
 
-    usedCount.fetch_add(1, std::memory_order_relaxed);
+void PoolAllocator::noteCasFailure_()
+{
+    if (shards_)
+    {
+        const std::uint32_t slot = metricSlot();
+        bump<std::uint64_t>(shards_[slot].cas_failures, 1, slot != kSharedShard);
+        return;
+    }
+    metrics_.cas_failures.fetch_add(1, std::memory_order_relaxed);
+}
 
-    auto in_use_now = metrics_.in_use.fetch_add(1, std::memory_order_relaxed) + 1;
+void PoolAllocator::addInUse_(std::size_t n)
+{
+    if (shards_)
+    {
+        const std::uint32_t slot = metricSlot();
+        MetricShard &sh = shards_[slot];
+        if (slot != kSharedShard)
+        {
+            const std::int64_t live = sh.live.load(std::memory_order_relaxed) + static_cast<std::int64_t>(n);
+            sh.live.store(live, std::memory_order_relaxed);
+            if (live > sh.peak.load(std::memory_order_relaxed))
+                sh.peak.store(live, std::memory_order_relaxed);
+            return;
+        }
+        const std::int64_t live = sh.live.fetch_add(static_cast<std::int64_t>(n), std::memory_order_relaxed) +
+                                  static_cast<std::int64_t>(n);
+        std::int64_t peak = sh.peak.load(std::memory_order_relaxed);
+        while (live > peak && !sh.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+        {
+        }
+        return;
+    }
+
+    auto in_use_now = metrics_.in_use.fetch_add(n, std::memory_order_relaxed) + n;
     std::uint64_t old_hwm = metrics_.high_watermark.load(std::memory_order_relaxed);
     while (in_use_now > old_hwm &&
            !metrics_.high_watermark.compare_exchange_weak(old_hwm, in_use_now, std::memory_order_relaxed))
     {
     }
+}
+
+void PoolAllocator::subInUse_(std::size_t n)
+{
+    if (shards_)
+    {
+        const std::uint32_t slot = metricSlot();
+        const bool own = slot != kSharedShard;
+        bump<std::uint64_t>(shards_[slot].free_calls, n, own);
+        bump<std::int64_t>(shards_[slot].live, -static_cast<std::int64_t>(n), own);
+        return;
+    }
+    metrics_.free_calls.fetch_add(n, std::memory_order_relaxed);
+    metrics_.in_use.fetch_sub(n, std::memory_order_relaxed);
+}
+
+std::uint64_t PoolAllocator::inUse_() const
+{
+    if (!shards_)
+        return metrics_.in_use.load(std::memory_order_relaxed);
+    std::int64_t live = 0;
+    for (std::size_t i = 0; i < kMetricShards; ++i)
+        live += shards_[i].live.load(std::memory_order_relaxed);
+    return live > 0 ? static_cast<std::uint64_t>(live) : 0;
+}
+
+std::size_t PoolAllocator::used() const
+{
+    return static_cast<std::size_t>(inUse_());
+}
+
+void *PoolAllocator::freshBlock_(std::size_t idx)
+{
+    void *p = static_cast<char *>(memoryBlock) + idx * alignedObjSize;
+    // same state as a freed block, so verify_poison_on_alloc holds for first use too
+    if (options_.poison_on_free)
+        applyPoison_(p);
+    return p;
+}
+
+bool PoolAllocator::refillBump_()
+{
+    if (!trimmedRuns_.empty())
+    {
+        bumpNext_ = trimmedRuns_.back().first;
+        bumpEnd_ = trimmedRuns_.back().second;
+        trimmedRuns_.pop_back();
+        return true;
+    }
+    const std::size_t cur = committed_.load(std::memory_order_relaxed);
+    if (!growSlab_(cur))
+        return false;
+    bumpNext_ = cur;
+    bumpEnd_ = committed_.load(std::memory_order_relaxed);
+    return true;
+}
+
+bool PoolAllocator::growSlab_(std::size_t seen)
+{
+    if (seen >= poolCapacity)
+        return false; // fixed capacity, or fully grown
+    std::lock_guard<std::mutex> lock(growMtx_);
+    const std::size_t cur = committed_.load(std::memory_order_relaxed);
+    if (cur != seen)
+        return true; // another thread published a slab meanwhile
+    constexpr std::size_t kMaxGrowthShift = 6;
+    const std::size_t shift = slabCount_ - 1 < kMaxGrowthShift ? slabCount_ - 1 : kMaxGrowthShift;
+    const std::size_t add = std::min(initialCapacity_ << shift, poolCapacity - cur);
+    if (!os_memory::commit(static_cast<char *>(memoryBlock) + cur * alignedObjSize, add * alignedObjSize,
+                           options_.prefault))
+        return false;
+    ++slabCount_;
+    committed_.store(cur + add, std::memory_order_release);
+    return true;
+}
+
+std::size_t PoolAllocator::decommitFree_(const std::vector<std::uint8_t> &state, std::vector<bool> &trimmed, bool lazy)
+{
+    trimmed.assign(poolCapacity, false);
+    if (poolCapacity == 0 || (options_.verify_poison_on_alloc && options_.poison_on_free))
+        return 0; // a zero page would fail the poison check on its next hand-out
+    const std::size_t page = slab_.base && slab_.backing == PageBacking::HugeTlb ? os_memory::kHugePageSize
+                                                                                 : os_memory::pageSize();
+    const auto base = reinterpret_cast<std::uintptr_t>(memoryBlock);
+    const auto end = base + alignedObjSize * poolCapacity;
+    const bool prefaulted = slab_.populated || options_.prefault;
+
+    std::size_t advised = 0;
+    std::uintptr_t runStart = 0, runEnd = 0; // pending run of reclaimable pages
+    auto flush = [&]
+    {
+        if (runEnd > runStart)
+            advised += os_memory::decommit(reinterpret_cast<void *>(runStart), runEnd - runStart, lazy, page);
+        runStart = runEnd = 0;
+    };
+    for (std::uintptr_t p = (base + page - 1) & ~(std::uintptr_t{page} - 1); p + page <= end; p += page)
+    {
+        const std::size_t first = (p - base) / alignedObjSize;
+        const std::size_t last = (p + page - 1 - base) / alignedObjSize;
+        bool reclaim = true;
+        bool touched = prefaulted;
+        for (std::size_t i = first; i <= last && reclaim; ++i)
+        {
+            reclaim = state[i] != kBlockLive;
+            touched = touched || state[i] == kBlockFree;
+        }
+        if (!reclaim || !touched)
+        {
+            flush();
+            continue;
+        }
+        for (std::size_t i = first; i <= last; ++i)
+            trimmed[i] = true;
+        if (runEnd != p)
+        {
+            flush();
+            runStart = p;
+        }
+        runEnd = p + page;
+    }
+    flush();
+    trimmedBytes_ += advised;
+    return advised;
+}
+
+std::size_t PoolAllocator::trim(bool lazy)
+{
+    std::vector<std::uint8_t> state(poolCapacity, kBlockLive);
+    auto indexOf = [this](void *p)
+    { return static_cast<std::size_t>(static_cast<char *>(p) - static_cast<char *>(memoryBlock)) / alignedObjSize; };
+    for (void *p = nonAtomicFreeListHead; p;)
+    {
+        state[indexOf(p)] = kBlockFree;
+        std::memcpy(&p, p, sizeof(void *));
+    }
+    for (std::size_t i = bumpNext_; i < bumpEnd_; ++i)
+        state[i] = kBlockFresh;
+    for (const auto &r : trimmedRuns_)
+        for (std::size_t i = r.first; i < r.second; ++i)
+            state[i] = kBlockFresh;
+
+    std::vector<bool> trimmed;
+    const std::size_t advised = decommitFree_(state, trimmed, lazy);
+    if (advised == 0)
+        return 0;
+
+    // The free list links live in the blocks, and a trimmed page now reads as
+    // zero: relink only the free blocks on resident pages (lowest address first)
+    // and serve everything else like fresh blocks, run by run.
+    nonAtomicFreeListHead = nullptr;
+    trimmedRuns_.clear();
+    bumpNext_ = bumpEnd_ = 0;
+    for (std::size_t i = poolCapacity; i-- > 0;)
+    {
+        if (state[i] == kBlockLive)
+            continue;
+        if (state[i] == kBlockFree && !trimmed[i])
+        {
+            void *p = static_cast<char *>(memoryBlock) + i * alignedObjSize;
+            std::memcpy(p, &nonAtomicFreeListHead, sizeof(void *));
+            nonAtomicFreeListHead = p;
+        }
+        else if (!trimmedRuns_.empty() && trimmedRuns_.back().first == i + 1)
+        {
+            trimmedRuns_.back().first = i;
+        }
+        else
+        {
+            trimmedRuns_.emplace_back(i, i + 1);
+        }
+    }
+    return advised;
+}
+
+void *PoolAllocator::afterPop_(void *ptr, const void *site)
+{
+    if (options_.prefetch_write)
+        prefetch::write(ptr, options_.prefetch_locality); // overlaps the bookkeeping below
+    addInUse_(1);
 
     if (options_.verify_poison_on_alloc && options_.poison_on_free)
     {
-        verifyPoison_(allocated);
+        verifyPoison_(ptr);
     }
     if (options_.zero_on_alloc)
     {
-        std::memset(allocated, 0, alignedObjSize);
+        std::memset(ptr, 0, alignedObjSize);
     }
     if (options_.on_alloc)
-        options_.on_alloc(allocated, alignedObjSize);
+        options_.on_alloc(ptr, alignedObjSize);
+    if (options_.trace)
+        alloc_trace::record(alloc_trace::Op::Alloc, this, ptr, alignedObjSize, site);
 
     if (occupancyHist_)
         sampleOccupancy_();
-    return allocated;
+    return ptr;
 }
 
-void PoolAllocator::deallocate(void *ptr)
+void PoolAllocator::afterPopBulk_(void **out, std::size_t got, std::size_t requested, const void *site)
 {
-    if (!ptr)
+    noteAllocCalls_(requested);
+    if (got < requested)
+        noteAllocFailures_(requested - got);
+    if (got == 0)
+        return;
+    addInUse_(got);
+
+    const bool verify = options_.verify_poison_on_alloc && options_.poison_on_free;
+    if (verify || options_.zero_on_alloc || options_.on_alloc || options_.trace)
+    {
+        for (std::size_t i = 0; i < got; ++i)
+        {
+            if (verify)
+                verifyPoison_(out[i]);
+            if (options_.zero_on_alloc)
+                std::memset(out[i], 0, alignedObjSize);
+            if (options_.on_alloc)
+                options_.on_alloc(out[i], alignedObjSize);
+            if (options_.trace)
+                alloc_trace::record(alloc_trace::Op::Alloc, this, out[i], alignedObjSize, site);
+        }
+    }
+    if (occupancyHist_)
+        sampleOccupancy_();
+}
+
+void PoolAllocator::beforePushBulk_(void *const *ptrs, std::size_t n, const void *site)
+{
+    if (!options_.on_free && !options_.poison_on_free && !options_.trace)
         return;
+    for (std::size_t i = 0; i < n; ++i)
+        beforePush_(ptrs[i], site);
+}
+
+void PoolAllocator::afterPushBulk_(std::size_t n)
+{
+    subInUse_(n);
+    if (occupancyHist_)
+        sampleOccupancy_();
+}
 
+void PoolAllocator::beforePush_(void *ptr, const void *site)
+{
+    if (options_.trace)
+        alloc_trace::record(alloc_trace::Op::Free, this, ptr, alignedObjSize, site);
     if (options_.on_free)
         options_.on_free(ptr, alignedObjSize);
     if (options_.poison_on_free)
         applyPoison_(ptr);
+}
 
-    if (options_.quarantine_size > 0)
-    {
-        quarantinePush_(ptr);
-    }
-    else
-    {
-        freeListPush_(ptr);
-    }
-
-    usedCount.fetch_sub(1, std::memory_order_relaxed);
-
-    metrics_.free_calls.fetch_add(1, std::memory_order_relaxed);
-    metrics_.in_use.fetch_sub(1, std::memory_order_relaxed);
+void PoolAllocator::afterPush_()
+{
+    subInUse_(1);
     if (occupancyHist_)
         sampleOccupancy_();
 }
@@ -167,7 +694,7 @@ void PoolAllocator::sampleOccupancy_()
 {
     if (!occupancyHist_)
         return;
-    auto in_use = metrics_.in_use.load(std::memory_order_relaxed);
+    auto in_use = inUse_();
     if (in_use > poolCapacity)
         in_use = poolCapacity;
     occupancyHist_->record(in_use);
@@ -175,13 +702,10 @@ void PoolAllocator::sampleOccupancy_()
 
 void PoolAllocator::quarantinePush_(void *ptr)
 {
-    quarantine_.push_back(ptr);
-    if (quarantine_.size() > options_.quarantine_size)
-    {
-        void *victim = quarantine_.front();
-        quarantine_.erase(quarantine_.begin());
-        freeListPush_(victim);
-    }
+    const std::size_t n = quarantine_.push(ptr);
+    void *const *victims = quarantine_.evicted();
+    for (std::size_t i = 0; i < n; ++i)
+        freeListPush_(victims[i]);
 }
 
 void PoolAllocator::freeListPush_(void *ptr)
@@ -190,111 +714,427 @@ void PoolAllocator::freeListPush_(void *ptr)
     nonAtomicFreeListHead = ptr;
 }
 
-PoolStats PoolAllocator::getStats() const
+void PoolAllocator::countersInto_(PoolStats &s) const
 {
-    PoolStats s;
-    s.capacity = poolCapacity;
+    s.capacity = capacity();
+    s.max_capacity = poolCapacity;
     s.object_size = alignedObjSize;
     s.aligned_object_size = alignedObjSize;
-    s.alloc_calls = metrics_.alloc_calls.load(std::memory_order_relaxed);
-    s.free_calls = metrics_.free_calls.load(std::memory_order_relaxed);
-    s.alloc_failures = metrics_.alloc_failures.load(std::memory_order_relaxed);
-    s.cas_failures = metrics_.cas_failures.load(std::memory_order_relaxed);
-    s.high_watermark = metrics_.high_watermark.load(std::memory_order_relaxed);
-    s.in_use = metrics_.in_use.load(std::memory_order_relaxed);
+    if (shards_)
+    {
+        std::int64_t live = 0;
+        std::uint64_t peaks = 0;
+        for (std::size_t i = 0; i < kMetricShards; ++i)
+        {
+            const MetricShard &sh = shards_[i];
+            s.alloc_calls += sh.alloc_calls.load(std::memory_order_relaxed);
+            s.free_calls += sh.free_calls.load(std::memory_order_relaxed);
+            s.alloc_failures += sh.alloc_failures.load(std::memory_order_relaxed);
+            s.cas_failures += sh.cas_failures.load(std::memory_order_relaxed);
+            live += sh.live.load(std::memory_order_relaxed);
+            peaks += static_cast<std::uint64_t>(std::max<std::int64_t>(sh.peak.load(std::memory_order_relaxed), 0));
+        }
+        s.in_use = live > 0 ? static_cast<std::uint64_t>(live) : 0;
+        s.high_watermark = std::max<std::uint64_t>(s.in_use, std::min<std::uint64_t>(peaks, poolCapacity));
+    }
+    else
+    {
+        s.alloc_calls = metrics_.alloc_calls.load(std::memory_order_relaxed);
+        s.free_calls = metrics_.free_calls.load(std::memory_order_relaxed);
+        s.alloc_failures = metrics_.alloc_failures.load(std::memory_order_relaxed);
+        s.cas_failures = metrics_.cas_failures.load(std::memory_order_relaxed);
+        s.high_watermark = metrics_.high_watermark.load(std::memory_order_relaxed);
+        s.in_use = metrics_.in_use.load(std::memory_order_relaxed);
+    }
+}
+
+void PoolAllocator::lockForFork()
+{
+    growMtx_.lock();
+}
+
+void PoolAllocator::unlockAfterFork()
+{
+    growMtx_.unlock();
+}
+
+void PoolAllocator::lockSharedForFork()
+{
+    g_slotMtx.lock();
+}
+
+void PoolAllocator::unlockSharedAfterFork()
+{
+    g_slotMtx.unlock();
+}
+
+PoolStats PoolAllocator::getStats() const
+{
+    PoolStats s;
+    countersInto_(s);
+    {
+        std::lock_guard<std::mutex> lock(growMtx_);
+        s.slabs = slabCount_;
+    }
+    s.backing = slab_.base ? slab_.backing : PageBacking::Heap;
+    s.untouched = bumpEnd_ - bumpNext_;
+    for (const auto &r : trimmedRuns_)
+        s.untouched += r.second - r.first;
+    s.trimmed_bytes = trimmedBytes_;
+    s.quarantined = quarantine_.size();
+    s.quarantine_early = quarantine_.early();
     return s;
 }
 
+// ---- lock-free pool: per-thread magazines ----
+struct LockFreePoolAllocator::Magazine
+{
+    std::mutex ownerMtx;                      // serializes thread-exit flush vs pool teardown
+    LockFreePoolAllocator *owner = nullptr;   // null once the pool is gone
+    std::thread::id thread;
+    std::vector<std::uint32_t> slots;         // LIFO stack of cached block indices, cap 2*N
+    std::size_t count = 0;                    // owner thread only
+    std::atomic<std::uint64_t> cached{0};     // mirror of count for getStats()
+    std::atomic<std::uint64_t> refills{0};
+    std::atomic<std::uint64_t> spills{0};
+
+    QuarantineRing quarantine;              // owner thread only (flushed under ownerMtx)
+    std::atomic<std::uint64_t> quarantined{0}; // mirrors for getStats()
+    std::atomic<std::uint64_t> early{0};
+};
+
+struct LockFreePoolAllocator::ThreadMagazines
+{
+    struct Entry
+    {
+        std::uint64_t serial;
+        std::shared_ptr<Magazine> mag;
+    };
+    std::vector<Entry> entries;
+    std::uint64_t lastSerial = 0; // one-entry lookup cache
+    Magazine *last = nullptr;
+
+    ~ThreadMagazines()
+    {
+        // give cached blocks back to pools that are still alive
+        for (auto &e : entries)
+        {
+            std::lock_guard<std::mutex> lock(e.mag->ownerMtx);
+            if (e.mag->owner && e.mag->count > 0)
+                e.mag->owner->spill_(*e.mag, e.mag->count);
+            if (e.mag->owner)
+                e.mag->owner->flushQuarantine_(*e.mag);
+            e.mag->owner = nullptr;
+        }
+    }
+};
+
+thread_local LockFreePoolAllocator::ThreadMagazines LockFreePoolAllocator::tlsMagazines_;
+
+namespace
+{
+    std::atomic<std::uint64_t> g_poolSerial{1};
+}
+
 LockFreePoolAllocator::LockFreePoolAllocator(std::size_t objectSize, std::size_t capacity,
                                              PoolOptions options)
     : PoolAllocator(objectSize, capacity, options),
-      freeListHead(nonAtomicFreeListHead)
+      freeListHead(packHead_(kNilIndex, 0u)),
+      serial_(g_poolSerial.fetch_add(1, std::memory_order_relaxed))
 {
-    // Build side-array links
-    next_.resize(poolCapacity, nullptr);
-    char *base = static_cast<char *>(memoryBlock);
-    for (std::size_t i = 0; i + 1 < poolCapacity; ++i)
-    {
-        next_[i] = base + (i + 1) * alignedObjSize;
-    }
-    next_[poolCapacity - 1] = nullptr;
+    // 32-bit links: the last index value is reserved as the list terminator
+    if (poolCapacity >= kNilIndex)
+        throw std::length_error("LockFreePoolAllocator: capacity exceeds 32-bit index space");
 
-    if (options_.quarantine_size > 0)
+    // links are written on first free; the free list starts empty and the bump
+    // cursor hands out never-used blocks
+    if (poolCapacity > 0)
     {
-        lfQuarantine_.reserve(options_.quarantine_size + 1);
+        nextMap_ = os_memory::map(poolCapacity * sizeof(std::uint32_t), false, options_.prefault,
+                                  false, options_.numa_node);
+        if (!nextMap_.base)
+            throw std::bad_alloc();
+        next_ = static_cast<std::uint32_t *>(nextMap_.base);
     }
 }
 
 LockFreePoolAllocator::~LockFreePoolAllocator()
 {
-    freeListHead.store(nullptr, std::memory_order_relaxed);
+    // detach magazines first so exiting threads stop flushing into us
+    {
+        std::lock_guard<std::mutex> lock(magMutex_);
+        for (auto &m : magazines_)
+        {
+            std::lock_guard<std::mutex> mlock(m->ownerMtx);
+            m->owner = nullptr;
+        }
+        magazines_.clear();
+    }
+    freeListHead.store(packHead_(kNilIndex, 0u), std::memory_order_relaxed);
+    os_memory::unmap(nextMap_);
+    next_ = nullptr;
 }
 
 void *LockFreePoolAllocator::allocate()
 {
-    metrics_.alloc_calls.fetch_add(1, std::memory_order_relaxed);
-    void *head = freeListHead.load(std::memory_order_acquire);
+    return allocate_(FINALLOC_CALLSITE(), true);
+}
 
-    while (true)
+void *LockFreePoolAllocator::tryAllocate()
+{
+    return allocate_(FINALLOC_CALLSITE(), false);
+}
+
+void *LockFreePoolAllocator::allocate_(const void *site, bool countMiss)
+{
+    if (options_.magazine_size > 0)
     {
-        if (!head)
+        Magazine &m = localMagazine_();
+        if (m.count == 0 && !refill_(m))
         {
-            metrics_.alloc_failures.fetch_add(1, std::memory_order_relaxed);
+            if (countMiss)
+            {
+                noteAllocCalls_(1);
+                noteAllocFailures_(1);
+            }
             return nullptr;
         }
-        if (!inRange_(head))
+        noteAllocCalls_(1);
+        const std::uint32_t idx = m.slots[--m.count];
+        m.cached.store(m.count, std::memory_order_relaxed);
+        if (options_.prefetch_next && m.count > 0)
+            prefetchBlock_(blockAt_(m.slots[m.count - 1]));
+        return afterPop_(blockAt_(idx), site);
+    }
+
+    std::uint32_t idx = kNilIndex;
+    if (popChain_(1, [&idx](std::size_t, std::uint32_t i)
+                  { idx = i; }) == 0)
+    {
+        if (countMiss)
+        {
+            noteAllocCalls_(1);
+            noteAllocFailures_(1);
+        }
+        return nullptr;
+    }
+    noteAllocCalls_(1);
+    if (options_.prefetch_next)
+        prefetchHead_();
+    return afterPop_(blockAt_(idx), site);
+}
+
+void LockFreePoolAllocator::prefetchHead_() const
+{
+    // a racy peek is fine: a stale index only prefetches a line nobody needs
+    const std::uint32_t idx = headIndex_(freeListHead.load(std::memory_order_relaxed));
+    if (idx < poolCapacity)
+    {
+        prefetch::read(&next_[idx], options_.prefetch_locality);
+        prefetchBlock_(blockAt_(idx));
+    }
+    else if (const std::uint32_t b = bump_.load(std::memory_order_relaxed); b < committed_.load(std::memory_order_relaxed))
+    {
+        prefetchBlock_(blockAt_(b));
+    }
+}
+
+template <typename Store>
+std::size_t LockFreePoolAllocator::popChain_(std::size_t n, Store &&store)
+{
+    std::uint64_t head = freeListHead.load(std::memory_order_acquire);
+
+    while (true)
+    {
+        std::uint32_t idx = headIndex_(head);
+        if (idx == kNilIndex)
+            return bumpChain_(n, store);
+        if (idx >= poolCapacity)
         {
-            std::cerr << "[ERROR] Invalid head pointer in allocate(): " << head << "\n";
+            std::cerr << "[ERROR] Invalid head index in allocate(): " << idx << "\n";
             std::abort();
         }
 
-        // Read next from side array (not from user memory)
-        void *next = next_[indexOf_(head)];
+        // Walk up to n links from the side array (not from user memory). Links may
+        // be stale if another thread popped meanwhile; the tag makes that CAS fail,
+        // so a stale walk only has to stay in bounds.
+        std::size_t got = 0;
+        std::uint32_t next = kNilIndex;
+        while (true)
+        {
+            store(got++, idx);
+            next = link_(idx).load(std::memory_order_relaxed);
+            if (got == n || next == kNilIndex || next >= poolCapacity)
+                break;
+            idx = next;
+        }
 
-        if (freeListHead.compare_exchange_weak(head, next,
+        if (freeListHead.compare_exchange_weak(head, packHead_(next, headTag_(head) + 1),
                                                std::memory_order_acq_rel,
                                                std::memory_order_acquire))
         {
-            usedCount.fetch_add(1, std::memory_order_relaxed);
+            return got;
+        }
+        noteCasFailure_();
+    }
+}
 
-            auto in_use_now = metrics_.in_use.fetch_add(1, std::memory_order_relaxed) + 1;
-            std::uint64_t old_hwm = metrics_.high_watermark.load(std::memory_order_relaxed);
-            while (in_use_now > old_hwm &&
-                   !metrics_.high_watermark.compare_exchange_weak(old_hwm, in_use_now, std::memory_order_relaxed))
-            {
-            }
+template <typename At>
+void LockFreePoolAllocator::pushChain_(std::size_t n, At &&at)
+{
+    if (n == 0)
+        return;
+    // pre-link the chain privately, then splice it in with one CAS
+    const std::uint32_t first = at(0);
+    std::uint32_t last = first;
+    for (std::size_t i = 1; i < n; ++i)
+    {
+        const std::uint32_t cur = at(i);
+        link_(last).store(cur, std::memory_order_relaxed);
+        last = cur;
+    }
 
-            if (options_.verify_poison_on_alloc && options_.poison_on_free)
-            {
-                verifyPoison_(head);
-            }
-            if (options_.zero_on_alloc)
-            {
-                std::memset(head, 0, alignedObjSize);
-            }
-            if (options_.on_alloc)
-                options_.on_alloc(head, alignedObjSize);
-            if (occupancyHist_)
-                sampleOccupancy_();
-            return head;
-        }
-        else
+    std::uint64_t head = freeListHead.load(std::memory_order_relaxed);
+    while (true)
+    {
+        link_(last).store(headIndex_(head), std::memory_order_relaxed); // published by release CAS
+        if (freeListHead.compare_exchange_weak(head, packHead_(first, headTag_(head) + 1),
+                                               std::memory_order_release, std::memory_order_relaxed))
+            return;
+        noteCasFailure_();
+    }
+}
+
+template <typename Store>
+std::size_t LockFreePoolAllocator::bumpChain_(std::size_t n, Store &&store)
+{
+    // claim [b, b + k) of the never-used tail; the blocks are private once claimed
+    std::uint32_t b = bump_.load(std::memory_order_relaxed);
+    std::size_t k = 0;
+    while (true)
+    {
+        const std::size_t limit = committed_.load(std::memory_order_acquire); // pairs with growSlab_()
+        if (b >= limit)
         {
-            metrics_.cas_failures.fetch_add(1, std::memory_order_relaxed);
+            if (!growSlab_(limit))
+                return 0;
+            b = bump_.load(std::memory_order_relaxed);
+            continue;
         }
+        k = std::min<std::size_t>(n, limit - b);
+        if (bump_.compare_exchange_weak(b, static_cast<std::uint32_t>(b + k), std::memory_order_relaxed))
+            break;
+    }
+
+    for (std::size_t i = 0; i < k; ++i)
+    {
+        freshBlock_(b + i);
+        store(i, static_cast<std::uint32_t>(b + i));
     }
+    return k;
 }
 
 void LockFreePoolAllocator::lfFreeListPush_(void *ptr)
 {
-    // CAS-based push using side-array link
-    const std::size_t idx = indexOf_(ptr);
-    void *head = freeListHead.load(std::memory_order_relaxed);
-    do
+    const std::uint32_t idx = indexOf_(ptr);
+    pushChain_(1, [idx](std::size_t)
+               { return idx; });
+}
+
+LockFreePoolAllocator::Magazine &LockFreePoolAllocator::localMagazine_()
+{
+    ThreadMagazines &cache = tlsMagazines_;
+    if (cache.lastSerial == serial_)
+        return *cache.last;
+    for (auto &e : cache.entries)
+    {
+        if (e.serial == serial_)
+        {
+            cache.lastSerial = serial_;
+            cache.last = e.mag.get();
+            return *cache.last;
+        }
+    }
+    return registerMagazine_(cache);
+}
+
+LockFreePoolAllocator::Magazine &LockFreePoolAllocator::registerMagazine_(ThreadMagazines &cache)
+{
+    // slow path, once per (thread, pool): drop entries whose pool has died
+    cache.entries.erase(std::remove_if(cache.entries.begin(), cache.entries.end(),
+                                       [](const ThreadMagazines::Entry &e)
+                                       {
+                                           std::lock_guard<std::mutex> lock(e.mag->ownerMtx);
+                                           return e.mag->owner == nullptr;
+                                       }),
+                        cache.entries.end());
+
+    auto mag = std::make_shared<Magazine>();
+    mag->owner = this;
+    mag->thread = std::this_thread::get_id();
+    mag->slots.resize(2 * options_.magazine_size);
+    mag->quarantine.init(options_.quarantine_size, options_.quarantine_batch, options_.quarantine_min_age_us);
+    {
+        std::lock_guard<std::mutex> lock(magMutex_);
+        magazines_.push_back(mag);
+    }
+    cache.entries.push_back({serial_, mag});
+    cache.lastSerial = serial_;
+    cache.last = mag.get();
+    return *cache.last;
+}
+
+bool LockFreePoolAllocator::refill_(Magazine &m)
+{
+    std::uint32_t *slots = m.slots.data();
+    const std::size_t got = popChain_(options_.magazine_size, [slots](std::size_t i, std::uint32_t idx)
+                                      { slots[i] = idx; });
+    if (got == 0)
+        return false;
+    // chain comes out head-first; keep the hottest block on top of the stack
+    std::reverse(m.slots.begin(), m.slots.begin() + static_cast<std::ptrdiff_t>(got));
+    m.count = got;
+    m.cached.store(m.count, std::memory_order_relaxed);
+    m.refills.store(m.refills.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return true;
+}
+
+void LockFreePoolAllocator::spill_(Magazine &m, std::size_t n)
+{
+    // return the coldest n (bottom of the stack), keep the recently freed ones
+    n = std::min(n, m.count);
+    const std::uint32_t *slots = m.slots.data();
+    pushChain_(n, [slots](std::size_t i)
+               { return slots[i]; });
+    std::copy(m.slots.begin() + static_cast<std::ptrdiff_t>(n),
+              m.slots.begin() + static_cast<std::ptrdiff_t>(m.count), m.slots.begin());
+    m.count -= n;
+    m.cached.store(m.count, std::memory_order_relaxed);
+    m.spills.store(m.spills.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void LockFreePoolAllocator::lfQuarantinePush_(Magazine &m, void *ptr)
+{
+    const std::size_t n = m.quarantine.push(ptr);
+    if (n)
     {
-        next_[idx] = head; // publish link before releasing CAS
-    } while (!freeListHead.compare_exchange_weak(head, ptr,
-                                                 std::memory_order_release, std::memory_order_relaxed));
+        void *const *victims = m.quarantine.evicted();
+        pushChain_(n, [this, victims](std::size_t i)
+                   { return indexOf_(victims[i]); });
+        m.early.store(m.quarantine.early(), std::memory_order_relaxed);
+    }
+    m.quarantined.store(m.quarantine.size(), std::memory_order_relaxed);
+}
+
+void LockFreePoolAllocator::flushQuarantine_(Magazine &m)
+{
+    while (std::size_t n = m.quarantine.take(m.quarantine.batch()))
+    {
+        void *const *victims = m.quarantine.evicted();
+        pushChain_(n, [this, victims](std::size_t i)
+                   { return indexOf_(victims[i]); });
+    }
+    m.quarantined.store(0, std::memory_order_relaxed);
 }
 
 void LockFreePoolAllocator::deallocate(void *ptr)
@@ -307,31 +1147,310 @@ void LockFreePoolAllocator::deallocate(void *ptr)
         std::abort();
     }
 
-    if (options_.on_free)
-        options_.on_free(ptr, alignedObjSize);
-    if (options_.poison_on_free)
-        applyPoison_(ptr);
+    beforePush_(ptr, FINALLOC_CALLSITE());
 
     if (options_.quarantine_size > 0)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        lfQuarantine_.push_back(ptr);
-        if (lfQuarantine_.size() > options_.quarantine_size)
+        lfQuarantinePush_(localMagazine_(), ptr);
+    }
+    else if (options_.magazine_size > 0)
+    {
+        Magazine &m = localMagazine_();
+        m.slots[m.count++] = indexOf_(ptr);
+        if (m.count == m.slots.size())
+            spill_(m, options_.magazine_size);
+        else
+            m.cached.store(m.count, std::memory_order_relaxed);
+    }
+    else
+    {
+        lfFreeListPush_(ptr);
+    }
+
+    afterPush_();
+}
+
+std::size_t LockFreePoolAllocator::allocateBulk(void **out, std::size_t n)
+{
+    return allocateBulk_(out, n, FINALLOC_CALLSITE(), true);
+}
+
+std::size_t LockFreePoolAllocator::tryAllocateBulk(void **out, std::size_t n)
+{
+    return allocateBulk_(out, n, FINALLOC_CALLSITE(), false);
+}
+
+std::size_t LockFreePoolAllocator::allocateBulk_(void **out, std::size_t n, const void *site, bool countMiss)
+{
+    if (n == 0)
+        return 0;
+    // indices are parked in out[] during the walk, converted once the CAS wins;
+    // a short recycled chain is topped up from the never-used tail
+    std::size_t got = 0;
+    while (got < n)
+    {
+        void **dst = out + got;
+        const std::size_t k = popChain_(n - got, [dst](std::size_t i, std::uint32_t idx)
+                                        { dst[i] = reinterpret_cast<void *>(static_cast<std::uintptr_t>(idx)); });
+        if (k == 0)
+            break;
+        got += k;
+    }
+    for (std::size_t i = 0; i < got; ++i)
+        out[i] = blockAt_(static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(out[i])));
+    afterPopBulk_(out, got, countMiss ? n : got, site);
+    return got;
+}
+
+void LockFreePoolAllocator::deallocateBulk(void *const *ptrs, std::size_t n)
+{
+    if (n == 0)
+        return;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (!inRange_(ptrs[i]))
         {
-            void *victim = lfQuarantine_.front();
-            lfQuarantine_.erase(lfQuarantine_.begin());
-            lfFreeListPush_(victim);
+            std::cerr << "[ERROR] Invalid pointer passed to deallocateBulk(): " << ptrs[i] << "\n";
+            std::abort();
         }
     }
+    beforePushBulk_(ptrs, n, FINALLOC_CALLSITE());
+
+    if (options_.quarantine_size > 0)
+    {
+        Magazine &m = localMagazine_();
+        for (std::size_t i = 0; i < n; ++i)
+            lfQuarantinePush_(m, ptrs[i]);
+    }
     else
     {
-        lfFreeListPush_(ptr);
+        pushChain_(n, [this, ptrs](std::size_t i)
+                   { return indexOf_(ptrs[i]); });
     }
 
-    usedCount.fetch_sub(1, std::memory_order_relaxed);
+    afterPushBulk_(n);
+}
 
-    metrics_.free_calls.fetch_add(1, std::memory_order_relaxed);
-    metrics_.in_use.fetch_sub(1, std::memory_order_relaxed);
-    if (occupancyHist_)
-        sampleOccupancy_();
+std::size_t LockFreePoolAllocator::trim(bool lazy)
+{
+    std::vector<std::uint8_t> state(poolCapacity, kBlockLive);
+    for (std::uint32_t i = headIndex_(freeListHead.load(std::memory_order_acquire)); i != kNilIndex;
+         i = link_(i).load(std::memory_order_relaxed))
+        state[i] = kBlockFree;
+    const std::size_t committed = capacity();
+    for (std::size_t i = std::min<std::size_t>(bump_.load(std::memory_order_relaxed), committed); i < committed; ++i)
+        state[i] = kBlockFresh;
+    std::vector<bool> trimmed;
+    return decommitFree_(state, trimmed, lazy);
+}
+
+void LockFreePoolAllocator::lockForFork()
+{
+    magMutex_.lock(); // a thread's first use of the pool registers its magazine
+    PoolAllocator::lockForFork();
+}
+
+void LockFreePoolAllocator::unlockAfterFork()
+{
+    PoolAllocator::unlockAfterFork();
+    magMutex_.unlock();
+}
+
+PoolStats LockFreePoolAllocator::getStats() const
+{
+    PoolStats s = PoolAllocator::getStats();
+    s.untouched = s.capacity - std::min<std::size_t>(bump_.load(std::memory_order_relaxed), s.capacity);
+    std::lock_guard<std::mutex> lock(magMutex_);
+    s.thread_caches.reserve(magazines_.size());
+    for (const auto &m : magazines_)
+    {
+        PoolStats::ThreadCacheStats t;
+        t.thread = m->thread;
+        t.refills = m->refills.load(std::memory_order_relaxed);
+        t.spills = m->spills.load(std::memory_order_relaxed);
+        t.cached = m->cached.load(std::memory_order_relaxed);
+        s.magazine_refills += t.refills;
+        s.magazine_spills += t.spills;
+        s.magazine_cached += t.cached;
+        s.quarantined += m->quarantined.load(std::memory_order_relaxed);
+        s.quarantine_early += m->early.load(std::memory_order_relaxed);
+        s.thread_caches.push_back(t);
+    }
+    return s;
+}
+
+// ---- remote-free pool ----
+namespace
+{
+    // Address-range registry for RemoteFreePoolAllocator::ownerOf(). Writers
+    // (pool ctor/dtor) serialize on a mutex; readers scan without locking.
+    struct RemoteRegistryEntry
+    {
+        std::atomic<std::uintptr_t> begin{0}; // 0 = free slot; published last
+        std::atomic<std::uintptr_t> end{0};
+        std::atomic<RemoteFreePoolAllocator *> pool{nullptr};
+    };
+    constexpr std::size_t kRemoteRegistrySlots = 1024;
+    RemoteRegistryEntry g_remoteRegistry[kRemoteRegistrySlots];
+    std::atomic<std::size_t> g_remoteRegistryHigh{0}; // scan bound
+    std::mutex g_remoteRegistryMtx;
+}
+
+RemoteFreePoolAllocator::RemoteFreePoolAllocator(std::size_t objectSize, std::size_t capacity,
+                                                 PoolOptions options)
+    : PoolAllocator(objectSize, capacity, options),
+      owner_(std::this_thread::get_id())
+{
+    std::lock_guard<std::mutex> lock(g_remoteRegistryMtx);
+    std::size_t slot = 0;
+    while (slot < kRemoteRegistrySlots && g_remoteRegistry[slot].begin.load(std::memory_order_relaxed) != 0)
+        ++slot;
+    if (slot == kRemoteRegistrySlots)
+        throw std::length_error("RemoteFreePoolAllocator: too many live pools in the registry");
+
+    const auto base = reinterpret_cast<std::uintptr_t>(memoryBlock);
+    auto &e = g_remoteRegistry[slot];
+    e.pool.store(this, std::memory_order_relaxed);
+    e.end.store(base + alignedObjSize * poolCapacity, std::memory_order_relaxed);
+    e.begin.store(base, std::memory_order_release);
+    if (slot + 1 > g_remoteRegistryHigh.load(std::memory_order_relaxed))
+        g_remoteRegistryHigh.store(slot + 1, std::memory_order_release);
+    registrySlot_ = slot;
+}
+
+RemoteFreePoolAllocator::~RemoteFreePoolAllocator()
+{
+    std::lock_guard<std::mutex> lock(g_remoteRegistryMtx);
+    auto &e = g_remoteRegistry[registrySlot_];
+    e.begin.store(0, std::memory_order_release);
+    e.pool.store(nullptr, std::memory_order_relaxed);
+}
+
+void *RemoteFreePoolAllocator::allocate()
+{
+    // lazy drain: only look at the shared remote head when the local list is empty
+    if (!nonAtomicFreeListHead)
+        drainRemoteFrees();
+    return allocateLocal_(FINALLOC_CALLSITE());
+}
+
+std::size_t RemoteFreePoolAllocator::allocateBulk(void **out, std::size_t n)
+{
+    // batches are rare enough to check the remote head up front
+    drainRemoteFrees();
+    return allocateBulkLocal_(out, n, FINALLOC_CALLSITE());
+}
+
+void *RemoteFreePoolAllocator::tryAllocate()
+{
+    if (!nonAtomicFreeListHead)
+        drainRemoteFrees();
+    return allocateLocal_(FINALLOC_CALLSITE(), false);
+}
+
+std::size_t RemoteFreePoolAllocator::tryAllocateBulk(void **out, std::size_t n)
+{
+    drainRemoteFrees();
+    return allocateBulkLocal_(out, n, FINALLOC_CALLSITE(), false);
+}
+
+void RemoteFreePoolAllocator::deallocate(void *ptr)
+{
+    if (!ptr)
+        return;
+    if (isOwnerThread())
+    {
+        deallocateLocal_(ptr, FINALLOC_CALLSITE());
+        return;
+    }
+    beforePush_(ptr, FINALLOC_CALLSITE());
+    remotePushChain_(ptr, ptr);
+    remoteFrees_.fetch_add(1, std::memory_order_relaxed);
+    afterPush_();
+}
+
+void RemoteFreePoolAllocator::deallocateBulk(void *const *ptrs, std::size_t n)
+{
+    if (n == 0)
+        return;
+    if (isOwnerThread())
+    {
+        deallocateBulkLocal_(ptrs, n, FINALLOC_CALLSITE());
+        return;
+    }
+    beforePushBulk_(ptrs, n, FINALLOC_CALLSITE());
+    for (std::size_t i = 0; i + 1 < n; ++i)
+        std::memcpy(ptrs[i], &ptrs[i + 1], sizeof(void *));
+    remotePushChain_(ptrs[0], ptrs[n - 1]);
+    remoteFrees_.fetch_add(n, std::memory_order_relaxed);
+    afterPushBulk_(n);
+}
+
+void RemoteFreePoolAllocator::remotePushChain_(void *first, void *last)
+{
+    void *head = remoteHead_.load(std::memory_order_relaxed);
+    do
+    {
+        std::memcpy(last, &head, sizeof(void *)); // published by release CAS
+    } while (!remoteHead_.compare_exchange_weak(head, first,
+                                                std::memory_order_release, std::memory_order_relaxed));
+}
+
+std::size_t RemoteFreePoolAllocator::drainRemoteFrees()
+{
+    if (!remoteHead_.load(std::memory_order_relaxed))
+        return 0;
+    void *chain = remoteHead_.exchange(nullptr, std::memory_order_acquire);
+    std::size_t moved = 0;
+    while (chain)
+    {
+        void *next = nullptr;
+        std::memcpy(&next, chain, sizeof(void *));
+        if (options_.quarantine_size > 0)
+            quarantinePush_(chain);
+        else
+            freeListPush_(chain);
+        chain = next;
+        ++moved;
+    }
+    if (moved)
+        remoteDrains_.fetch_add(1, std::memory_order_relaxed);
+    return moved;
+}
+
+std::size_t RemoteFreePoolAllocator::trim(bool lazy)
+{
+    drainRemoteFrees();
+    return PoolAllocator::trim(lazy);
+}
+
+PoolStats RemoteFreePoolAllocator::getStats() const
+{
+    PoolStats s = PoolAllocator::getStats();
+    s.remote_frees = remoteFrees_.load(std::memory_order_relaxed);
+    s.remote_drains = remoteDrains_.load(std::memory_order_relaxed);
+    return s;
+}
+
+RemoteFreePoolAllocator *RemoteFreePoolAllocator::ownerOf(const void *p)
+{
+    const auto u = reinterpret_cast<std::uintptr_t>(p);
+    const std::size_t high = g_remoteRegistryHigh.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < high; ++i)
+    {
+        const auto &e = g_remoteRegistry[i];
+        const std::uintptr_t b = e.begin.load(std::memory_order_acquire);
+        if (b != 0 && u >= b && u < e.end.load(std::memory_order_relaxed))
+            return e.pool.load(std::memory_order_relaxed);
+    }
+    return nullptr;
+}
+
+bool RemoteFreePoolAllocator::release(void *p)
+{
+    RemoteFreePoolAllocator *pool = ownerOf(p);
+    if (!pool)
+        return false;
+    pool->deallocate(p);
+    return true;
 }
@@ -0,0 +1,385 @@
+#include "allocators/sharedMemoryPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct SharedMemoryPool::Header
+{
+    std::atomic<std::uint64_t> magic{0}; // stored last by the creator (release)
+    std::uint32_t version = 0;
+    std::uint32_t capacity = 0;
+    std::uint64_t objectSize = 0;
+    std::uint64_t stride = 0;
+    std::uint64_t nextOffset = 0;   // from the region base
+    std::uint64_t blocksOffset = 0;
+    std::uint64_t regionBytes = 0;
+
+    // hot words on their own lines: the head is what every process CASes
+    alignas(64) std::atomic<std::uint64_t> head{0}; // tagged: generation << 32 | index
+    alignas(64) std::atomic<std::uint32_t> bump{0}; // blocks [bump, capacity) never handed out
+    alignas(64) std::atomic<std::uint64_t> allocCalls{0};
+    std::atomic<std::uint64_t> freeCalls{0};
+    std::atomic<std::uint64_t> allocFailures{0};
+    std::atomic<std::uint64_t> casFailures{0};
+    std::atomic<std::int64_t> inUse{0};
+    std::atomic<std::int64_t> peak{0};
+};
+
+namespace
+{
+    constexpr std::uint64_t kMagic = 0x46696e416c6c5348ull; // "FinAllSH"
+    constexpr std::uint32_t kVersion = 1;
+    constexpr std::size_t kLine = 64;
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+                  "shared-memory pool needs address-free lock-free atomics");
+
+    std::size_t alignUp(std::size_t n, std::size_t a)
+    {
+        return (n + a - 1) & ~(a - 1);
+    }
+
+    std::string shmName(const std::string &name)
+    {
+        return name.empty() || name[0] != '/' ? "/" + name : name;
+    }
+
+    [[noreturn]] void throwErrno(const char *what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    std::uint64_t packHead(std::uint32_t idx, std::uint32_t tag)
+    {
+        return (static_cast<std::uint64_t>(tag) << 32) | idx;
+    }
+
+    // the size of a region being created by another process shows up after its
+    // ftruncate; wait (briefly) instead of failing the attach
+    std::size_t waitForSize(int fd, std::size_t atLeast)
+    {
+        struct stat st{};
+        for (int i = 0; i < 1000; ++i)
+        {
+            if (::fstat(fd, &st) != 0)
+                throwErrno("SharedMemoryPool: fstat");
+            if (static_cast<std::size_t>(st.st_size) >= atLeast)
+                return static_cast<std::size_t>(st.st_size);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return static_cast<std::size_t>(st.st_size);
+    }
+}
+
+SharedMemoryPool SharedMemoryPool::create(const std::string &name, std::size_t objectSize, std::size_t capacity)
+{
+    const std::string n = shmName(name);
+    const int fd = ::shm_open(n.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        throwErrno("SharedMemoryPool: shm_open");
+    try
+    {
+        return mapFd_(fd, 0, true, objectSize, capacity);
+    }
+    catch (...)
+    {
+        ::shm_unlink(n.c_str());
+        throw;
+    }
+}
+
+SharedMemoryPool SharedMemoryPool::open(const std::string &name)
+{
+    const int fd = ::shm_open(shmName(name).c_str(), O_RDWR, 0600);
+    if (fd < 0)
+        throwErrno("SharedMemoryPool: shm_open");
+    return mapFd_(fd, waitForSize(fd, sizeof(Header)), false, 0, 0);
+}
+
+bool SharedMemoryPool::unlink(const std::string &name)
+{
+    return ::shm_unlink(shmName(name).c_str()) == 0;
+}
+
+SharedMemoryPool SharedMemoryPool::anonymous(std::size_t objectSize, std::size_t capacity)
+{
+    return mapFd_(-1, 0, true, objectSize, capacity);
+}
+
+SharedMemoryPool SharedMemoryPool::openFile(const std::string &path)
+{
+    const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+        throwErrno("SharedMemoryPool: open");
+    return mapFd_(fd, waitForSize(fd, sizeof(Header)), false, 0, 0);
+}
+
+SharedMemoryPool SharedMemoryPool::mapFd_(int fd, std::size_t bytes, bool init, std::size_t objectSize,
+                                          std::size_t capacity)
+{
+    SharedMemoryPool pool;
+    pool.fd_ = fd; // closed by the destructor, also when a check below throws
+
+    std::size_t nextOffset = 0, blocksOffset = 0, stride = 0;
+    if (init)
+    {
+        if (capacity >= kNullHandle)
+            throw std::length_error("SharedMemoryPool: capacity exceeds 32-bit handle space");
+        // 64-byte stride: a block written by one process never shares a line with
+        // the neighbour another process is reading
+        stride = alignUp(objectSize ? objectSize : 1, kLine);
+        nextOffset = alignUp(sizeof(Header), kLine);
+        blocksOffset = alignUp(nextOffset + capacity * sizeof(std::uint32_t), os_memory::pageSize());
+        bytes = blocksOffset + stride * capacity;
+        if (fd >= 0 && ::ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+            throwErrno("SharedMemoryPool: ftruncate");
+    }
+    if (bytes < sizeof(Header))
+        throw std::invalid_argument("SharedMemoryPool: region too small to hold a pool");
+
+    const int flags = fd >= 0 ? MAP_SHARED : MAP_SHARED | MAP_ANONYMOUS;
+    void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (p == MAP_FAILED)
+        throwErrno("SharedMemoryPool: mmap");
+    pool.base_ = static_cast<char *>(p);
+    pool.bytes_ = bytes;
+
+    if (init)
+    {
+        // the new region is zero-filled: the free list starts empty and blocks come
+        // off the bump cursor, so no link is written until a block is first freed
+        auto *h = new (pool.base_) Header();
+        h->version = kVersion;
+        h->capacity = static_cast<std::uint32_t>(capacity);
+        h->objectSize = objectSize;
+        h->stride = stride;
+        h->nextOffset = nextOffset;
+        h->blocksOffset = blocksOffset;
+        h->regionBytes = bytes;
+        h->head.store(packHead(kNullHandle, 0), std::memory_order_relaxed);
+        h->magic.store(kMagic, std::memory_order_release);
+    }
+    else
+    {
+        // attaching while the creator is still initializing: wait for the magic
+        auto *h = reinterpret_cast<Header *>(pool.base_);
+        for (int i = 0; i < 1000 && h->magic.load(std::memory_order_acquire) != kMagic; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pool.attach_();
+    return pool;
+}
+
+void SharedMemoryPool::attach_()
+{
+    auto *h = reinterpret_cast<Header *>(base_);
+    if (h->magic.load(std::memory_order_acquire) != kMagic)
+        throw std::invalid_argument("SharedMemoryPool: region is not an initialized pool");
+    if (h->version != kVersion)
+        throw std::invalid_argument("SharedMemoryPool: pool layout version mismatch");
+    if (h->regionBytes > bytes_ || h->blocksOffset + h->stride * h->capacity > h->regionBytes ||
+        h->nextOffset + std::uint64_t{h->capacity} * sizeof(std::uint32_t) > h->blocksOffset)
+        throw std::invalid_argument("SharedMemoryPool: corrupt pool header");
+    hdr_ = h;
+    next_ = reinterpret_cast<std::uint32_t *>(base_ + h->nextOffset);
+    blocks_ = base_ + h->blocksOffset;
+    stride_ = h->stride;
+    objectSize_ = h->objectSize;
+    capacity_ = h->capacity;
+}
+
+SharedMemoryPool::~SharedMemoryPool()
+{
+    release_();
+}
+
+SharedMemoryPool::SharedMemoryPool(SharedMemoryPool &&o) noexcept
+{
+    *this = std::move(o);
+}
+
+SharedMemoryPool &SharedMemoryPool::operator=(SharedMemoryPool &&o) noexcept
+{
+    if (this == &o)
+        return *this;
+    release_();
+    base_ = o.base_;
+    bytes_ = o.bytes_;
+    fd_ = o.fd_;
+    hdr_ = o.hdr_;
+    next_ = o.next_;
+    blocks_ = o.blocks_;
+    stride_ = o.stride_;
+    objectSize_ = o.objectSize_;
+    capacity_ = o.capacity_;
+    o.base_ = nullptr;
+    o.bytes_ = 0;
+    o.fd_ = -1;
+    o.hdr_ = nullptr;
+    o.next_ = nullptr;
+    o.blocks_ = nullptr;
+    o.capacity_ = 0;
+    return *this;
+}
+
+void SharedMemoryPool::release_()
+{
+    if (base_)
+        ::munmap(base_, bytes_);
+    if (fd_ >= 0)
+        ::close(fd_);
+    base_ = nullptr;
+    fd_ = -1;
+    hdr_ = nullptr;
+}
+
+SharedMemoryPool::Handle SharedMemoryPool::allocateHandle()
+{
+    hdr_->allocCalls.fetch_add(1, std::memory_order_relaxed);
+    Handle got = kNullHandle;
+    std::uint64_t head = hdr_->head.load(std::memory_order_acquire);
+    while (true)
+    {
+        const std::uint32_t idx = static_cast<std::uint32_t>(head);
+        if (idx == kNullHandle)
+        {
+            // free list empty: claim a never-used block
+            std::uint32_t b = hdr_->bump.load(std::memory_order_relaxed);
+            while (b < capacity_ &&
+                   !hdr_->bump.compare_exchange_weak(b, b + 1, std::memory_order_relaxed))
+            {
+            }
+            if (b >= capacity_)
+            {
+                hdr_->allocFailures.fetch_add(1, std::memory_order_relaxed);
+                return kNullHandle;
+            }
+            got = b;
+            break;
+        }
+        if (idx >= capacity_)
+        {
+            std::cerr << "[ERROR] SharedMemoryPool: invalid head index " << idx << "\n";
+            std::abort();
+        }
+        // a stale link only makes the tagged CAS fail
+        const std::uint32_t next = std::atomic_ref<std::uint32_t>(next_[idx]).load(std::memory_order_relaxed);
+        if (hdr_->head.compare_exchange_weak(head, packHead(next, static_cast<std::uint32_t>(head >> 32) + 1),
+                                             std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            got = idx;
+            break;
+        }
+        hdr_->casFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const std::int64_t live = hdr_->inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+    std::int64_t peak = hdr_->peak.load(std::memory_order_relaxed);
+    while (live > peak && !hdr_->peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+    return got;
+}
+
+void SharedMemoryPool::deallocateHandle(Handle h)
+{
+    if (h == kNullHandle)
+        return;
+    if (h >= capacity_)
+    {
+        std::cerr << "[ERROR] SharedMemoryPool: deallocate of foreign handle " << h << "\n";
+        std::abort();
+    }
+    std::uint64_t head = hdr_->head.load(std::memory_order_relaxed);
+    while (true)
+    {
+        std::atomic_ref<std::uint32_t>(next_[h]).store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+        if (hdr_->head.compare_exchange_weak(head, packHead(h, static_cast<std::uint32_t>(head >> 32) + 1),
+                                             std::memory_order_release, std::memory_order_relaxed))
+            break;
+        hdr_->casFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+    hdr_->freeCalls.fetch_add(1, std::memory_order_relaxed);
+    hdr_->inUse.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void SharedMemoryPool::deallocate(void *ptr)
+{
+    if (!ptr)
+        return;
+    const Handle h = handleOf(ptr);
+    if (h == kNullHandle)
+    {
+        std::cerr << "[ERROR] SharedMemoryPool: deallocate of foreign pointer " << ptr << "\n";
+        std::abort();
+    }
+    deallocateHandle(h);
+}
+
+SharedMemoryPool::Handle SharedMemoryPool::handleOf(const void *p) const
+{
+    const auto u = reinterpret_cast<std::uintptr_t>(p);
+    const auto b = reinterpret_cast<std::uintptr_t>(blocks_);
+    if (!blocks_ || u < b || u >= b + stride_ * capacity_ || (u - b) % stride_ != 0)
+        return kNullHandle;
+    return static_cast<Handle>((u - b) / stride_);
+}
+
+std::size_t SharedMemoryPool::used() const
+{
+    const std::int64_t v = hdr_ ? hdr_->inUse.load(std::memory_order_relaxed) : 0;
+    return v > 0 ? static_cast<std::size_t>(v) : 0;
+}
+
+PoolStats SharedMemoryPool::getStats() const
+{
+    PoolStats s;
+    if (!hdr_)
+        return s;
+    s.capacity = capacity_;
+    s.max_capacity = capacity_;
+    s.object_size = objectSize_;
+    s.aligned_object_size = stride_;
+    s.alloc_calls = hdr_->allocCalls.load(std::memory_order_relaxed);
+    s.free_calls = hdr_->freeCalls.load(std::memory_order_relaxed);
+    s.alloc_failures = hdr_->allocFailures.load(std::memory_order_relaxed);
+    s.cas_failures = hdr_->casFailures.load(std::memory_order_relaxed);
+    s.in_use = used();
+    const std::int64_t peak = hdr_->peak.load(std::memory_order_relaxed);
+    s.high_watermark = peak > 0 ? static_cast<std::uint64_t>(peak) : 0;
+    s.backing = PageBacking::Small;
+    s.untouched = capacity_ - std::min<std::size_t>(hdr_->bump.load(std::memory_order_relaxed), capacity_);
+    return s;
+}
+
+bool SharedMemoryPool::snapshot(const std::string &path) const
+{
+    if (!base_)
+        return false;
+    const int fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0600);
+    if (fd < 0)
+        return false;
+    std::size_t done = 0;
+    while (done < bytes_)
+    {
+        const ssize_t n = ::write(fd, base_ + done, bytes_ - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        done += static_cast<std::size_t>(n);
+    }
+    return ::close(fd) == 0 && done == bytes_;
+}
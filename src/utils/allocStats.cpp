@@ -0,0 +1,463 @@
+#include "utils/allocStats.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <ostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    using alloc_stats::Kind;
+    using alloc_stats::Probe;
+    using alloc_stats::Sample;
+
+    constexpr std::size_t kWords = sizeof(Sample) / sizeof(std::uint64_t);
+
+    struct Entry
+    {
+        std::uint64_t id = 0;
+        Kind kind = Kind::Custom;
+        char name[sizeof(Sample::name)] = {};
+        Probe probe;
+    };
+
+    // listMtx guards the entry list only and nothing allocates under it (add()
+    // grows the list outside), so a probe or a round may allocate (and, behind the
+    // malloc interposer, build and register a new pool) without deadlocking, and
+    // the interposer's fork handler can take it after the pools' own locks.
+    // roundMtx is held while probes run; remove() takes it after unlinking, so it
+    // returns only once no round can still be inside the probe of a dying allocator.
+    struct Registry
+    {
+        std::mutex listMtx;
+        std::vector<std::unique_ptr<Entry>> entries; // protected by listMtx
+        std::uint64_t nextId = 1;                    // protected by listMtx
+        std::mutex roundMtx;
+    };
+
+    Registry &registry()
+    {
+        static Registry *r = new Registry; // never destroyed: allocators in statics unregister after main
+        return *r;
+    }
+
+    std::uint64_t nowNs()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              std::chrono::steady_clock::now().time_since_epoch())
+                                              .count());
+    }
+
+    std::size_t ceil_pow2(std::size_t x)
+    {
+        std::size_t p = 1;
+        while (p < x)
+            p <<= 1;
+        return p;
+    }
+
+    // Sample <-> words, every word through atomic_ref so seqlock readers race on
+    // atomics only; torn copies are discarded by the sequence check
+    void storeWords(std::uint64_t *dst, const Sample &s)
+    {
+        std::uint64_t w[kWords];
+        std::memcpy(w, &s, sizeof(w));
+        for (std::size_t i = 0; i < kWords; ++i)
+            std::atomic_ref<std::uint64_t>(dst[i]).store(w[i], std::memory_order_relaxed);
+    }
+    Sample loadWords(const std::uint64_t *src)
+    {
+        std::uint64_t w[kWords];
+        for (std::size_t i = 0; i < kWords; ++i)
+            w[i] = std::atomic_ref<std::uint64_t>(const_cast<std::uint64_t &>(src[i])).load(std::memory_order_relaxed);
+        Sample s;
+        std::memcpy(&s, w, sizeof(w));
+        return s;
+    }
+
+    void putLabelValue(std::ostream &os, const char *v)
+    {
+        for (; *v; ++v)
+        {
+            if (*v == '\\' || *v == '"')
+                os << '\\' << *v;
+            else if (*v == '\n')
+                os << "\\n";
+            else
+                os << *v;
+        }
+    }
+
+    template <typename F>
+    void family(std::ostream &os, const std::vector<Sample> &samples, const char *metric, const char *type,
+                const char *help, F value)
+    {
+        os << "# HELP finalloc_" << metric << ' ' << help << '\n';
+        os << "# TYPE finalloc_" << metric << ' ' << type << '\n';
+        for (const auto &s : samples)
+        {
+            os << "finalloc_" << metric << "{id=\"" << s.id << "\",kind=\"" << alloc_stats::kindName(s.kind)
+               << "\",name=\"";
+            putLabelValue(os, s.name);
+            os << "\"} " << value(s) << '\n';
+        }
+    }
+}
+
+namespace alloc_stats
+{
+    const char *kindName(Kind k)
+    {
+        switch (k)
+        {
+        case Kind::Pool:
+            return "pool";
+        case Kind::Arena:
+            return "arena";
+        case Kind::ArenaGroup:
+            return "arena_group";
+        case Kind::Custom:
+            return "custom";
+        }
+        return "?";
+    }
+
+    std::uint64_t add(Kind kind, const char *name, Probe probe)
+    {
+        auto e = std::make_unique<Entry>();
+        e->kind = kind;
+        if (name)
+            std::strncpy(e->name, name, sizeof(e->name) - 1);
+        e->probe = std::move(probe);
+        Registry &r = registry();
+        for (;;)
+        {
+            std::size_t want = 0;
+            {
+                std::lock_guard<std::mutex> lock(r.listMtx);
+                if (r.entries.size() < r.entries.capacity())
+                {
+                    e->id = r.nextId++;
+                    r.entries.push_back(std::move(e));
+                    return r.entries.back()->id;
+                }
+                want = r.entries.capacity() * 2 + 16;
+            }
+            std::vector<std::unique_ptr<Entry>> grown;
+            grown.reserve(want);
+            std::lock_guard<std::mutex> lock(r.listMtx);
+            if (r.entries.size() <= want && r.entries.capacity() < want)
+            {
+                std::move(r.entries.begin(), r.entries.end(), std::back_inserter(grown));
+                r.entries.swap(grown); // the old buffer is freed with `grown`, after the unlock
+            }
+        }
+    }
+
+    void remove(std::uint64_t id)
+    {
+        Registry &r = registry();
+        std::unique_ptr<Entry> dead;
+        {
+            std::lock_guard<std::mutex> lock(r.listMtx);
+            auto it = std::find_if(r.entries.begin(), r.entries.end(), [id](const std::unique_ptr<Entry> &e)
+                                   { return e->id == id; });
+            if (it == r.entries.end())
+                return;
+            dead = std::move(*it);
+            r.entries.erase(it);
+        }
+        std::lock_guard<std::mutex> pass(r.roundMtx); // wait out a round that may still probe it
+    }
+
+    std::size_t registered()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.listMtx);
+        return r.entries.size();
+    }
+
+    void lockForFork()
+    {
+        registry().listMtx.lock();
+    }
+
+    void unlockAfterFork(bool inChild)
+    {
+        Registry &r = registry();
+        r.listMtx.unlock();
+        if (inChild)
+            new (&r.roundMtx) std::mutex; // the child has one thread: nobody is inside a round
+    }
+
+    std::vector<Sample> sampleAll()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> pass(r.roundMtx);
+        // copy the entry pointers with the list locked, growing the copy outside it
+        std::vector<const Entry *> snap;
+        for (;;)
+        {
+            std::size_t n = 0;
+            {
+                std::lock_guard<std::mutex> lock(r.listMtx);
+                n = r.entries.size();
+                if (snap.capacity() >= n)
+                {
+                    for (const auto &e : r.entries)
+                        snap.push_back(e.get());
+                    break;
+                }
+            }
+            snap.reserve(n + 16);
+        }
+        std::vector<Sample> out(snap.size());
+        const std::uint64_t ns = nowNs();
+        for (std::size_t i = 0; i < snap.size(); ++i)
+        {
+            const Entry &e = *snap[i];
+            Sample &s = out[i];
+            if (e.probe)
+                e.probe(s);
+            s.ns = ns;
+            s.id = e.id;
+            s.kind = e.kind;
+            std::memcpy(s.name, e.name, sizeof(s.name));
+        }
+        return out;
+    }
+
+    void prometheus(std::ostream &os, const std::vector<Sample> &samples)
+    {
+        family(os, samples, "capacity_bytes", "gauge", "Bytes the allocator holds.", [](const Sample &s)
+               { return s.capacity_bytes; });
+        family(os, samples, "used_bytes", "gauge", "Bytes handed out to callers.", [](const Sample &s)
+               { return s.used_bytes; });
+        family(os, samples, "objects", "gauge", "Live blocks (pool), chunks (arena) or cached slabs (group).",
+               [](const Sample &s)
+               { return s.objects; });
+        family(os, samples, "high_watermark", "gauge", "Peak live blocks (pool) or used bytes (arena).",
+               [](const Sample &s)
+               { return s.high_watermark; });
+        family(os, samples, "idle_ratio", "gauge", "Share of the held bytes not handed out.", [](const Sample &s)
+               { return s.idleRatio(); });
+        family(os, samples, "alloc_calls_total", "counter", "Allocation calls.", [](const Sample &s)
+               { return s.alloc_calls; });
+        family(os, samples, "free_calls_total", "counter", "Deallocation calls (arena: resets and rewinds).",
+               [](const Sample &s)
+               { return s.free_calls; });
+        family(os, samples, "alloc_failures_total", "counter", "Allocation calls that returned null.",
+               [](const Sample &s)
+               { return s.alloc_failures; });
+    }
+
+    std::string prometheus()
+    {
+        std::ostringstream os;
+        prometheus(os, sampleAll());
+        return os.str();
+    }
+
+    std::vector<Sample> readStatsFile(const std::string &path)
+    {
+        std::vector<Sample> out;
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return out;
+        struct stat st{};
+        void *p = MAP_FAILED;
+        if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(StatsFileHeader))
+            p = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            return out;
+        const std::size_t bytes = static_cast<std::size_t>(st.st_size);
+        const auto *h = static_cast<const StatsFileHeader *>(p);
+        const auto *rows = reinterpret_cast<const std::uint64_t *>(h + 1);
+        if (h->magic == kStatsFileMagic && h->version == kStatsFileVersion && h->row_bytes == sizeof(Sample))
+        {
+            for (int attempt = 0; attempt < 1000; ++attempt)
+            {
+                const std::uint64_t s1 = h->seq.load(std::memory_order_acquire);
+                if (s1 & 1)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                std::uint64_t count = std::atomic_ref<std::uint64_t>(const_cast<std::uint64_t &>(h->count)).load(std::memory_order_relaxed);
+                count = std::min<std::uint64_t>(count, (bytes - sizeof(StatsFileHeader)) / sizeof(Sample));
+                out.resize(count);
+                for (std::size_t i = 0; i < count; ++i)
+                    out[i] = loadWords(rows + i * kWords);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (h->seq.load(std::memory_order_relaxed) == s1)
+                    break;
+                out.clear();
+            }
+        }
+        ::munmap(p, bytes);
+        return out;
+    }
+
+    // ---- Sampler ----
+
+    // seq is 2n+1 while the n-th row ever written is stored here, 2n+2 once done
+    struct Sampler::Row
+    {
+        std::atomic<std::uint64_t> seq{0};
+        std::uint64_t words[kWords] = {};
+    };
+
+    Sampler::Sampler(std::chrono::milliseconds interval, std::size_t ringRows)
+        : interval_(interval)
+    {
+        const std::size_t n = ceil_pow2(std::max<std::size_t>(ringRows, 2));
+        mask_ = n - 1;
+        rows_.reset(new Row[n]);
+    }
+
+    Sampler::~Sampler()
+    {
+        stop();
+        if (file_)
+            ::munmap(file_, fileBytes_);
+    }
+
+    bool Sampler::exportFile(const std::string &path, std::size_t maxAllocators)
+    {
+        std::lock_guard<std::mutex> pass(runMtx_);
+        if (file_)
+        {
+            ::munmap(file_, fileBytes_);
+            file_ = nullptr;
+        }
+        const std::size_t bytes = sizeof(StatsFileHeader) + std::max<std::size_t>(maxAllocators, 1) * sizeof(Sample);
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+            return false;
+        void *p = MAP_FAILED;
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) == 0)
+            p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            return false;
+        auto *h = new (p) StatsFileHeader;
+        h->version = kStatsFileVersion;
+        h->row_bytes = sizeof(Sample);
+        h->capacity = std::max<std::size_t>(maxAllocators, 1);
+        std::atomic_ref<std::uint64_t>(h->magic).store(kStatsFileMagic, std::memory_order_release); // valid from here
+        file_ = h;
+        fileBytes_ = bytes;
+        return true;
+    }
+
+    void Sampler::start()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (thread_.joinable())
+            return;
+        stopping_ = false;
+        thread_ = std::thread([this]
+                              { loop_(); });
+    }
+
+    void Sampler::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (!thread_.joinable())
+                return;
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+        std::lock_guard<std::mutex> lock(mtx_);
+        thread_ = std::thread();
+    }
+
+    void Sampler::loop_()
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        while (!stopping_)
+        {
+            lock.unlock();
+            sampleOnce();
+            lock.lock();
+            if (cv_.wait_for(lock, interval_, [this]
+                             { return stopping_; }))
+                break;
+        }
+    }
+
+    void Sampler::sampleOnce()
+    {
+        std::lock_guard<std::mutex> pass(runMtx_);
+        const std::vector<Sample> round = sampleAll();
+        for (const auto &s : round)
+            push_(s);
+        publishFile_(round, round.empty() ? nowNs() : round.front().ns);
+        rounds_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Sampler::push_(const Sample &s)
+    {
+        const std::uint64_t n = head_.load(std::memory_order_relaxed);
+        Row &r = rows_[n & mask_];
+        r.seq.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        storeWords(r.words, s);
+        r.seq.store(2 * n + 2, std::memory_order_release);
+        head_.store(n + 1, std::memory_order_release);
+    }
+
+    void Sampler::publishFile_(const std::vector<Sample> &round, std::uint64_t ns)
+    {
+        if (!file_)
+            return;
+        auto *rows = reinterpret_cast<std::uint64_t *>(file_ + 1);
+        const std::size_t count = std::min<std::size_t>(round.size(), file_->capacity);
+        const std::uint64_t seq = file_->seq.load(std::memory_order_relaxed);
+        file_->seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < count; ++i)
+            storeWords(rows + i * kWords, round[i]);
+        std::atomic_ref<std::uint64_t>(file_->count).store(count, std::memory_order_relaxed);
+        std::atomic_ref<std::uint64_t>(file_->rounds).store(file_->rounds + 1, std::memory_order_relaxed);
+        std::atomic_ref<std::uint64_t>(file_->ns).store(ns, std::memory_order_relaxed);
+        file_->seq.store(seq + 2, std::memory_order_release);
+    }
+
+    std::vector<Sample> Sampler::history(std::uint64_t sinceNs) const
+    {
+        std::vector<Sample> out;
+        const std::uint64_t head = head_.load(std::memory_order_acquire);
+        const std::uint64_t ring = mask_ + 1;
+        const std::uint64_t first = head > ring ? head - ring : 0;
+        out.reserve(static_cast<std::size_t>(head - first));
+        for (std::uint64_t n = first; n < head; ++n)
+        {
+            const Row &r = rows_[n & mask_];
+            if (r.seq.load(std::memory_order_acquire) != 2 * n + 2)
+                continue; // already being overwritten
+            const Sample s = loadWords(r.words);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (r.seq.load(std::memory_order_relaxed) != 2 * n + 2 || s.ns < sinceNs)
+                continue;
+            out.push_back(s);
+        }
+        return out;
+    }
+
+    std::uint64_t Sampler::overwritten() const
+    {
+        const std::uint64_t head = head_.load(std::memory_order_relaxed);
+        return head > mask_ + 1 ? head - (mask_ + 1) : 0;
+    }
+}
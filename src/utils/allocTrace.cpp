@@ -0,0 +1,207 @@
+#include "utils/allocTrace.hpp"
+#include "utils/tscClock.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <ostream>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+
+namespace
+{
+    static_assert((alloc_trace::kRingEvents & (alloc_trace::kRingEvents - 1)) == 0, "ring size must be a power of two");
+
+    // An event is five words written with relaxed atomic stores, so a drain that
+    // races the owner's wrap-around reads stale or new words, never a torn one;
+    // the head re-check after the copy discards the slots that were overwritten.
+    constexpr std::size_t kWords = 5;
+
+    struct Ring
+    {
+        alignas(64) std::atomic<std::uint64_t> head{0}; // events ever written (owner thread)
+        std::uint64_t readPos = 0;                      // drained up to here (g_traceMtx)
+        std::uint16_t id = 0;
+        std::atomic<bool> live{true};
+        std::uint64_t slots[alloc_trace::kRingEvents][kWords];
+    };
+
+    std::mutex g_traceMtx;
+    std::vector<std::shared_ptr<Ring>> g_traceRings; // protected by g_traceMtx
+    std::uint16_t g_nextRingId = 0;                  // protected by g_traceMtx
+    std::uint64_t g_dropped = 0;                     // protected by g_traceMtx
+
+    struct RingHolder
+    {
+        std::shared_ptr<Ring> ring;
+        ~RingHolder()
+        {
+            if (ring)
+                ring->live.store(false, std::memory_order_release); // drain() frees it once empty
+        }
+    };
+    thread_local RingHolder t_ring;
+
+    Ring &localRing()
+    {
+        if (!t_ring.ring)
+        {
+            auto r = std::make_shared<Ring>();
+            std::lock_guard<std::mutex> lock(g_traceMtx);
+            r->id = g_nextRingId++;
+            g_traceRings.push_back(r);
+            t_ring.ring = std::move(r);
+        }
+        return *t_ring.ring;
+    }
+
+    void store(std::uint64_t &w, std::uint64_t v)
+    {
+        std::atomic_ref<std::uint64_t>(w).store(v, std::memory_order_relaxed);
+    }
+    std::uint64_t load(std::uint64_t &w)
+    {
+        return std::atomic_ref<std::uint64_t>(w).load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t word(const void *p)
+    {
+        return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(p));
+    }
+    const void *pointer(std::uint64_t w)
+    {
+        return reinterpret_cast<const void *>(static_cast<std::uintptr_t>(w));
+    }
+}
+
+namespace alloc_trace
+{
+    void record(Op op, const void *source, const void *ptr, std::size_t size, const void *site) noexcept
+    {
+        Ring &r = localRing();
+        const std::uint64_t h = r.head.load(std::memory_order_relaxed);
+        std::uint64_t *s = r.slots[h & (kRingEvents - 1)];
+        // pairs with drain()'s fence: a reader that sees any of these words then sees head >= h
+        std::atomic_thread_fence(std::memory_order_release);
+        const std::uint64_t sz = std::min<std::size_t>(size, UINT32_MAX);
+        store(s[0], TscClock::now());
+        store(s[1], word(source));
+        store(s[2], word(ptr));
+        store(s[3], word(site));
+        store(s[4], sz | (std::uint64_t{r.id} << 32) | (std::uint64_t{static_cast<std::uint8_t>(op)} << 48));
+        r.head.store(h + 1, std::memory_order_release);
+    }
+
+    std::vector<Event> drain()
+    {
+        std::vector<Event> out;
+        std::lock_guard<std::mutex> lock(g_traceMtx);
+        for (auto it = g_traceRings.begin(); it != g_traceRings.end();)
+        {
+            Ring &r = **it;
+            const bool live = r.live.load(std::memory_order_acquire);
+            const std::uint64_t h = r.head.load(std::memory_order_acquire);
+            // while the owner writes event h head still reads h, but the slot of
+            // h - kRingEvents is already going: only an exited thread's is intact
+            const std::uint64_t window = live ? kRingEvents - 1 : kRingEvents;
+            std::uint64_t from = std::max(r.readPos, h > window ? h - window : 0);
+            const std::size_t first = out.size();
+            for (std::uint64_t i = from; i < h; ++i)
+            {
+                std::uint64_t *s = r.slots[i & (kRingEvents - 1)];
+                Event e;
+                e.tsc = load(s[0]);
+                e.source = pointer(load(s[1]));
+                e.ptr = pointer(load(s[2]));
+                e.site = pointer(load(s[3]));
+                const std::uint64_t w4 = load(s[4]);
+                e.size = static_cast<std::uint32_t>(w4);
+                e.thread = static_cast<std::uint16_t>(w4 >> 32);
+                e.op = static_cast<Op>(static_cast<std::uint8_t>(w4 >> 48));
+                out.push_back(e);
+            }
+            // the owner may have lapped us while copying: drop what it overwrote, with
+            // h2 + 1 - kRingEvents the first surviving index (same reasoning as above)
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const std::uint64_t h2 = r.head.load(std::memory_order_relaxed);
+            const std::uint64_t valid = h2 > window ? h2 - window : 0;
+            if (valid > from)
+            {
+                const std::uint64_t lost = std::min(valid, h) - from;
+                out.erase(out.begin() + static_cast<std::ptrdiff_t>(first),
+                          out.begin() + static_cast<std::ptrdiff_t>(first + lost));
+                from += lost;
+            }
+            g_dropped += from - r.readPos;
+            r.readPos = h;
+
+            if (!live)
+                it = g_traceRings.erase(it);
+            else
+                ++it;
+        }
+        std::stable_sort(out.begin(), out.end(), [](const Event &a, const Event &b)
+                         { return a.tsc < b.tsc; });
+        return out;
+    }
+
+    std::uint64_t dropped()
+    {
+        std::lock_guard<std::mutex> lock(g_traceMtx);
+        return g_dropped;
+    }
+
+    Symbol symbolize(const void *site)
+    {
+        Symbol s;
+        Dl_info info{};
+        if (!site || ::dladdr(site, &info) == 0)
+            return s;
+        if (info.dli_fname)
+            s.module = info.dli_fname;
+        s.offset = reinterpret_cast<std::uintptr_t>(site) - reinterpret_cast<std::uintptr_t>(info.dli_fbase);
+        if (info.dli_sname)
+        {
+            int status = 0;
+            char *name = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            s.function = (status == 0 && name) ? name : info.dli_sname;
+            std::free(name);
+        }
+        return s;
+    }
+
+    const char *opName(Op op)
+    {
+        switch (op)
+        {
+        case Op::Alloc:
+            return "alloc";
+        case Op::Free:
+            return "free";
+        case Op::Reset:
+            return "reset";
+        }
+        return "?";
+    }
+
+    void dump(std::ostream &os, const std::vector<Event> &events, bool resolve)
+    {
+        for (const Event &e : events)
+        {
+            os << e.tsc << ' ' << opName(e.op) << ' ' << e.size << ' ' << e.ptr << " src=" << e.source << " t="
+               << e.thread << " site=" << e.site;
+            if (resolve)
+            {
+                const Symbol s = symbolize(e.site);
+                if (!s.module.empty())
+                    os << ' ' << s.module << "+0x" << std::hex << s.offset << std::dec;
+                if (!s.function.empty())
+                    os << ' ' << s.function;
+            }
+            os << '\n';
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#include "utils/memoryTrimmer.hpp"
+
+MemoryTrimmer::MemoryTrimmer(std::chrono::milliseconds period) : period_(period) {}
+
+MemoryTrimmer::~MemoryTrimmer()
+{
+    stop();
+}
+
+void MemoryTrimmer::add(std::string name, Task task)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    Entry e;
+    e.stats.name = std::move(name);
+    e.task = std::move(task);
+    tasks_.push_back(std::move(e));
+}
+
+void MemoryTrimmer::start()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (thread_.joinable())
+        return;
+    stopping_ = false;
+    thread_ = std::thread([this]
+                          { loop_(); });
+}
+
+void MemoryTrimmer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!thread_.joinable())
+            return;
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    std::lock_guard<std::mutex> lock(mtx_);
+    thread_ = std::thread();
+}
+
+bool MemoryTrimmer::running() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return thread_.joinable() && !stopping_;
+}
+
+std::size_t MemoryTrimmer::runOnce()
+{
+    std::lock_guard<std::mutex> pass(runMtx_);
+    std::size_t n = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        n = tasks_.size();
+    }
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            task = tasks_[i].task; // run outside mtx_ so add()/stats() never wait on a trim
+        }
+        const std::size_t bytes = task ? task() : 0;
+        total += bytes;
+        std::lock_guard<std::mutex> lock(mtx_);
+        ++tasks_[i].stats.runs;
+        tasks_[i].stats.trimmed_bytes += bytes;
+    }
+    return total;
+}
+
+std::vector<MemoryTrimmer::TaskStats> MemoryTrimmer::stats() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<TaskStats> out;
+    out.reserve(tasks_.size());
+    for (const auto &e : tasks_)
+        out.push_back(e.stats);
+    return out;
+}
+
+std::uint64_t MemoryTrimmer::trimmedBytes() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::uint64_t total = 0;
+    for (const auto &e : tasks_)
+        total += e.stats.trimmed_bytes;
+    return total;
+}
+
+void MemoryTrimmer::loop_()
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!stopping_)
+    {
+        if (cv_.wait_for(lock, period_, [this]
+                         { return stopping_; }))
+            break;
+        lock.unlock();
+        runOnce();
+        lock.lock();
+    }
+}
@@ -0,0 +1,292 @@
+#include "utils/osMemory.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23 // Linux 5.14+; older kernels return EINVAL
+#endif
+
+namespace
+{
+    // <numaif.h> values, spelled out to avoid a libnuma build dependency
+    constexpr int kMpolPreferred = 1;
+    constexpr int kMpolBind = 2;
+    constexpr int kMpolFNode = 1 << 0;
+    constexpr int kMpolFAddr = 1 << 1;
+    constexpr int kMaxNumaNodes = 1024;
+
+    inline std::size_t round_up(std::size_t n, std::size_t a)
+    {
+        return (n + a - 1) & ~(a - 1);
+    }
+
+    void *raw_map(std::size_t len, int extraFlags)
+    {
+        void *p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    // "[never]" in the sysfs knob means madvise(MADV_HUGEPAGE) is accepted but has no effect
+    bool thp_enabled()
+    {
+        static const bool enabled = []
+        {
+            std::FILE *f = std::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+            if (!f)
+                return false;
+            char buf[128] = {};
+            const std::size_t n = std::fread(buf, 1, sizeof(buf) - 1, f);
+            std::fclose(f);
+            buf[n] = '\0';
+            return std::strstr(buf, "[never]") == nullptr;
+        }();
+        return enabled;
+    }
+
+    void prefault(void *base, std::size_t len)
+    {
+        if (::madvise(base, len, MADV_POPULATE_WRITE) == 0)
+            return;
+        // pre-5.14 kernel: touch one byte per base page
+        const std::size_t page = os_memory::pageSize();
+        auto *p = static_cast<volatile unsigned char *>(base);
+        for (std::size_t off = 0; off < len; off += page)
+            p[off] = 0;
+    }
+}
+
+namespace os_memory
+{
+    std::size_t pageSize()
+    {
+        static const std::size_t page = []
+        {
+            const long v = ::sysconf(_SC_PAGESIZE);
+            return v > 0 ? static_cast<std::size_t>(v) : std::size_t{4096};
+        }();
+        return page;
+    }
+
+    OsMapping map(std::size_t bytes, bool preferHuge, bool populate, bool guard, int node)
+    {
+        OsMapping m;
+        if (bytes == 0)
+            bytes = 1;
+        const std::size_t guardLen = guard ? pageSize() : 0;
+        // a bound range must not be faulted before mbind, so MAP_POPULATE is only
+        // used for unbound mappings; bound ones are pre-faulted after binding
+        const bool populateAtMap = populate && node < 0;
+
+        // binds (if asked) and pre-faults (if not done by MAP_POPULATE)
+        auto finish = [&]() -> OsMapping &
+        {
+            if (node >= 0 && bindToNode(m.base, m.size, node))
+                m.node = node;
+            if (populate && !m.populated)
+            {
+                prefault(m.base, m.size);
+                m.populated = true;
+            }
+            return m;
+        };
+
+        if (!preferHuge)
+        {
+            m.size = round_up(bytes, pageSize());
+            m.backing = PageBacking::Small;
+            if (guardLen)
+            {
+                auto *raw = static_cast<char *>(raw_map(m.size + 2 * guardLen, 0));
+                if (!raw)
+                    return m;
+                ::mprotect(raw, guardLen, PROT_NONE);
+                ::mprotect(raw + guardLen + m.size, guardLen, PROT_NONE);
+                m.base = raw + guardLen;
+                m.guard = guardLen;
+                return finish();
+            }
+#ifdef MAP_POPULATE
+            m.base = raw_map(m.size, populateAtMap ? MAP_POPULATE : 0);
+            m.populated = populateAtMap && m.base;
+#else
+            m.base = raw_map(m.size, 0);
+#endif
+            if (!m.base)
+                return m;
+            return finish();
+        }
+
+        const std::size_t len = round_up(bytes, kHugePageSize);
+
+#ifdef MAP_HUGETLB
+        // 1) explicit huge pages; fails fast when the hugetlbfs pool is empty
+        if (!guard)
+        {
+            int flags = MAP_HUGETLB;
+#ifdef MAP_POPULATE
+            if (populateAtMap)
+                flags |= MAP_POPULATE;
+#endif
+            if (void *p = raw_map(len, flags))
+            {
+                m.base = p;
+                m.size = len;
+                m.backing = PageBacking::HugeTlb;
+                m.populated = populateAtMap;
+                return finish();
+            }
+        }
+#endif
+
+        // 2) over-reserve, trim to a 2 MiB boundary so every huge page is fully inside
+        // the range (guards sit just outside it), then ask for THP
+        const std::size_t reserve = len + kHugePageSize + 2 * guardLen;
+        void *raw = raw_map(reserve, 0);
+        if (!raw)
+            return m;
+        const auto start = reinterpret_cast<std::uintptr_t>(raw);
+        const std::uintptr_t aligned = round_up(start + guardLen, kHugePageSize);
+        const std::size_t head = aligned - guardLen - start;
+        const std::size_t tail = reserve - head - len - 2 * guardLen;
+        if (head)
+            ::munmap(raw, head);
+        if (tail)
+            ::munmap(reinterpret_cast<void *>(aligned + len + guardLen), tail);
+        if (guardLen)
+        {
+            ::mprotect(reinterpret_cast<void *>(aligned - guardLen), guardLen, PROT_NONE);
+            ::mprotect(reinterpret_cast<void *>(aligned + len), guardLen, PROT_NONE);
+        }
+
+        m.base = reinterpret_cast<void *>(aligned);
+        m.size = len;
+        m.guard = guardLen;
+        m.backing = PageBacking::Small;
+#ifdef MADV_HUGEPAGE
+        if (::madvise(m.base, m.size, MADV_HUGEPAGE) == 0 && thp_enabled())
+            m.backing = PageBacking::TransparentHuge;
+#endif
+        return finish();
+    }
+
+    bool bindToNode(void *base, std::size_t len, int node, bool strict)
+    {
+#if defined(__linux__) && defined(SYS_mbind)
+        if (!base || node < 0 || node >= kMaxNumaNodes)
+            return false;
+        unsigned long mask[kMaxNumaNodes / (8 * sizeof(unsigned long))] = {};
+        mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+        const int mode = strict ? kMpolBind : kMpolPreferred;
+        // maxnode counts one past the last bit the kernel reads
+        return ::syscall(SYS_mbind, base, len, mode, mask, kMaxNumaNodes + 1, 0) == 0;
+#else
+        (void)base;
+        (void)len;
+        (void)node;
+        (void)strict;
+        return false;
+#endif
+    }
+
+    int nodeOfAddress(const void *p)
+    {
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+        int node = -1;
+        if (::syscall(SYS_get_mempolicy, &node, nullptr, 0, const_cast<void *>(p), kMpolFNode | kMpolFAddr) != 0)
+            return -1;
+        return node;
+#else
+        (void)p;
+        return -1;
+#endif
+    }
+
+    void unmap(OsMapping &m)
+    {
+        if (m.base)
+            ::munmap(static_cast<char *>(m.base) - m.guard, m.size + 2 * m.guard);
+        m = OsMapping{};
+    }
+
+    OsMapping reserve(std::size_t bytes, bool preferHuge, int node)
+    {
+        OsMapping m;
+        const std::size_t align = preferHuge ? kHugePageSize : pageSize();
+        const std::size_t len = round_up(bytes ? bytes : 1, align);
+        const std::size_t over = len + (preferHuge ? kHugePageSize : 0);
+        void *raw = ::mmap(nullptr, over, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (raw == MAP_FAILED)
+            return m;
+        const auto start = reinterpret_cast<std::uintptr_t>(raw);
+        const std::uintptr_t aligned = round_up(start, align);
+        const std::size_t head = aligned - start;
+        const std::size_t tail = over - head - len;
+        if (head)
+            ::munmap(raw, head);
+        if (tail)
+            ::munmap(reinterpret_cast<void *>(aligned + len), tail);
+
+        m.base = reinterpret_cast<void *>(aligned);
+        m.size = len;
+        m.backing = PageBacking::Small;
+#ifdef MADV_HUGEPAGE
+        if (preferHuge && ::madvise(m.base, m.size, MADV_HUGEPAGE) == 0 && thp_enabled())
+            m.backing = PageBacking::TransparentHuge;
+#endif
+        if (node >= 0 && bindToNode(m.base, m.size, node))
+            m.node = node;
+        return m;
+    }
+
+    bool commit(void *p, std::size_t len, bool populate)
+    {
+        const std::size_t page = pageSize();
+        const auto lo = reinterpret_cast<std::uintptr_t>(p) & ~(std::uintptr_t{page} - 1);
+        const auto hi = round_up(reinterpret_cast<std::uintptr_t>(p) + len, page);
+        if (hi <= lo)
+            return true;
+        if (::mprotect(reinterpret_cast<void *>(lo), hi - lo, PROT_READ | PROT_WRITE) != 0)
+            return false;
+        if (populate)
+            prefault(reinterpret_cast<void *>(lo), hi - lo);
+        return true;
+    }
+
+    std::size_t decommit(void *p, std::size_t len, bool lazy, std::size_t granule)
+    {
+        if (!granule)
+            granule = pageSize();
+        const auto lo = round_up(reinterpret_cast<std::uintptr_t>(p), granule);
+        const auto hi = (reinterpret_cast<std::uintptr_t>(p) + len) & ~(std::uintptr_t{granule} - 1);
+        if (hi <= lo)
+            return 0;
+        void *base = reinterpret_cast<void *>(lo);
+        const std::size_t n = hi - lo;
+#ifdef MADV_FREE
+        if (lazy && ::madvise(base, n, MADV_FREE) == 0)
+            return n;
+#endif
+        return ::madvise(base, n, MADV_DONTNEED) == 0 ? n : 0;
+    }
+
+    const char *backingName(PageBacking b)
+    {
+        switch (b)
+        {
+        case PageBacking::Heap:
+            return "heap";
+        case PageBacking::Small:
+            return "4k";
+        case PageBacking::TransparentHuge:
+            return "thp";
+        case PageBacking::HugeTlb:
+            return "hugetlb";
+        }
+        return "?";
+    }
+}
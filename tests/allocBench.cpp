@@ -1,29 +1,62 @@
 // tests/allocBench.cpp
 #include "allocators/poolAllocator.hpp"
 #include "allocators/arenaAllocator.hpp"
+#include "allocators/basicPool.hpp"
 #include "allocators/poolConfig.hpp"
+#include "utils/histogram.hpp"
+#include "utils/tscClock.hpp"
 
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <memory>
-#include <numeric>
-#include <random>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include <sys/resource.h>
+
 using Clock = std::chrono::steady_clock;
+using LatencyHist = LogLinearHistogram<>;
 
 struct Opts
 {
-    std::string allocator = "pool"; // pool | lockfree | arena | new
+    std::string allocator = "pool"; // pool | basic | lockfree | arena | new
     int threads = 8;
     int iters = 100000;
     std::size_t size = 64;
     std::size_t live = 0; // 0 = immediate free; >0 = live set (per process, divided per thread)
+    std::size_t magazine = 0; // lockfree only: per-thread magazine batch size (0 = off)
+    std::size_t batch = 0;    // pool/lockfree: >0 = allocateBulk/deallocateBulk in chains of N
+    std::string pattern = "churn"; // churn | producer-consumer
+    bool huge = false;     // 2 MiB pages (MAP_HUGETLB / THP) for pool slabs and arena chunks
+    bool populate = false; // pre-fault pool slabs / arena chunks
+    bool headerless = false; // arena: ArenaOptions::headerless (inline bump, no block headers)
+    std::string metrics = "sharded"; // pool/lockfree: PoolOptions::metrics (shared | sharded)
+    std::string prefetch = "off";    // pool/lockfree: off | next | write | next,write
+    int locality = 3;                // prefetch locality 0 (NTA) .. 3 (L1)
+    std::size_t align = 0;           // pool/lockfree: PoolOptions::alignment; arena: ArenaOptions::pad_to
+
+    // latency harness
+    std::string timer = "tsc"; // tsc | chrono (tsc falls back to chrono if not invariant)
+    int sample = 1;            // time every Nth op
+    double rate = 0.0;         // per-thread target ops/s; >0 = paced, CO-corrected response times
+
+    // output / suite
+    std::string format = "text"; // text | json | csv
+    std::string out;             // file path; empty = stdout
+    bool suite = false;
+    int reps = 3;   // suite: measured repetitions per scenario
+    int warmup = 1; // suite: discarded runs per scenario
+    std::vector<std::string> allocators{"pool", "lockfree", "arena", "new"};
+    std::vector<std::size_t> sizes{16, 64, 256, 1024, 4096};
+    std::vector<std::size_t> lives{0, 1024};
+    std::vector<int> threadList; // empty = 1, 2, 4, ... up to --threads
 };
 
 static bool starts_with(const char *s, const char *pref)
@@ -31,6 +64,21 @@ static bool starts_with(const char *s, const char *pref)
     return std::strncmp(s, pref, std::strlen(pref)) == 0;
 }
 
+// "a,b,c" -> {a, b, c}
+template <typename T, typename Conv>
+static std::vector<T> split_list(const char *s, Conv conv)
+{
+    std::vector<T> v;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        if (!item.empty())
+            v.push_back(conv(item));
+    }
+    return v;
+}
+
 static Opts parse(int argc, char **argv)
 {
     Opts o;
@@ -56,14 +104,141 @@ static Opts parse(int argc, char **argv)
         {
             o.live = static_cast<std::size_t>(std::stoul(argv[i] + std::strlen("--live=")));
         }
+        else if (starts_with(argv[i], "--magazine="))
+        {
+            o.magazine = static_cast<std::size_t>(std::stoul(argv[i] + std::strlen("--magazine=")));
+        }
+        else if (starts_with(argv[i], "--batch="))
+        {
+            o.batch = static_cast<std::size_t>(std::stoul(argv[i] + std::strlen("--batch=")));
+        }
+        else if (starts_with(argv[i], "--pattern="))
+        {
+            o.pattern = std::string(argv[i] + std::strlen("--pattern="));
+        }
+        else if (std::strcmp(argv[i], "--huge") == 0)
+        {
+            o.huge = true;
+        }
+        else if (std::strcmp(argv[i], "--populate") == 0)
+        {
+            o.populate = true;
+        }
+        else if (starts_with(argv[i], "--prefetch="))
+        {
+            o.prefetch = std::string(argv[i] + std::strlen("--prefetch="));
+        }
+        else if (starts_with(argv[i], "--locality="))
+        {
+            o.locality = std::clamp(std::stoi(argv[i] + std::strlen("--locality=")), 0, 3);
+        }
+        else if (starts_with(argv[i], "--align="))
+        {
+            o.align = std::stoull(argv[i] + std::strlen("--align="));
+        }
+        else if (starts_with(argv[i], "--metrics="))
+        {
+            o.metrics = std::string(argv[i] + std::strlen("--metrics="));
+        }
+        else if (std::strcmp(argv[i], "--headerless") == 0)
+        {
+            o.headerless = true;
+        }
+        else if (starts_with(argv[i], "--timer="))
+        {
+            o.timer = std::string(argv[i] + std::strlen("--timer="));
+        }
+        else if (starts_with(argv[i], "--sample="))
+        {
+            o.sample = std::stoi(argv[i] + std::strlen("--sample="));
+        }
+        else if (starts_with(argv[i], "--rate="))
+        {
+            o.rate = std::stod(argv[i] + std::strlen("--rate="));
+        }
+        else if (starts_with(argv[i], "--format="))
+        {
+            o.format = std::string(argv[i] + std::strlen("--format="));
+        }
+        else if (starts_with(argv[i], "--out="))
+        {
+            o.out = std::string(argv[i] + std::strlen("--out="));
+        }
+        else if (std::strcmp(argv[i], "--suite") == 0)
+        {
+            o.suite = true;
+        }
+        else if (starts_with(argv[i], "--reps="))
+        {
+            o.reps = std::stoi(argv[i] + std::strlen("--reps="));
+        }
+        else if (starts_with(argv[i], "--warmup="))
+        {
+            o.warmup = std::stoi(argv[i] + std::strlen("--warmup="));
+        }
+        else if (starts_with(argv[i], "--allocators="))
+        {
+            o.allocators = split_list<std::string>(argv[i] + std::strlen("--allocators="),
+                                                   [](const std::string &x)
+                                                   { return x; });
+        }
+        else if (starts_with(argv[i], "--sizes="))
+        {
+            o.sizes = split_list<std::size_t>(argv[i] + std::strlen("--sizes="),
+                                              [](const std::string &x)
+                                              { return static_cast<std::size_t>(std::stoul(x)); });
+        }
+        else if (starts_with(argv[i], "--lives="))
+        {
+            o.lives = split_list<std::size_t>(argv[i] + std::strlen("--lives="),
+                                              [](const std::string &x)
+                                              { return static_cast<std::size_t>(std::stoul(x)); });
+        }
+        else if (starts_with(argv[i], "--thread-list="))
+        {
+            o.threadList = split_list<int>(argv[i] + std::strlen("--thread-list="),
+                                           [](const std::string &x)
+                                           { return std::stoi(x); });
+        }
         else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0)
         {
             std::cout <<
-                R"(Usage: ./bin/allocBench [--allocator=pool|lockfree|arena|new]
+                R"(Usage: ./bin/allocBench [--allocator=pool|basic|lockfree|arena|new]
                          [--threads=N] [--iters=N]
-                         [--size=BYTES] [--live=LIVESET]
+                         [--size=BYTES] [--live=LIVESET] [--magazine=N]
+                         [--batch=N] [--pattern=churn|producer-consumer]
+                         [--huge] [--populate] [--headerless] [--metrics=shared|sharded]
+                         [--prefetch=off|next|write|next,write] [--locality=0..3] [--align=N]
+                         [--timer=tsc|chrono] [--sample=N] [--rate=OPS]
+  --allocator=basic  per-thread BasicPool<> (MinimalPool): no metrics, hooks or virtuals
   --live=0           immediate alloc/free (or reset for arena)
-  --live>0           maintain per-thread live set of ceil(LIVESET/threads))"
+  --live>0           maintain per-thread live set of ceil(LIVESET/threads)
+  --magazine=N       lockfree: per-thread magazine cache, batches of N (0 = off)
+  --batch=N          pool/lockfree: bulk alloc/free in chains of N; latency is per op
+  --pattern=producer-consumer
+                     threads/2 producer->consumer pairs; producers allocate, consumers
+                     free (pool = per-producer RemoteFreePoolAllocator, freed remotely)
+  --huge, --populate 2 MiB huge pages (MAP_HUGETLB, else THP) / pre-faulted memory for
+                     pool slabs and arena chunks
+  --headerless       arena: release mode, no block header/canaries/journal (inline bump)
+  --metrics=sharded  pool/lockfree: per-thread counter shards, approximate high watermark
+                     (default); shared = one set of atomics, exact high watermark
+  --prefetch=next    pool/lockfree: prefetch the next free block and its link on every pop;
+                     write = prefetch-for-write of the returned block; --locality=0..3
+                     picks the cache level (0 = non-temporal, 3 = L1, default)
+  --align=64         pool/lockfree: block alignment and stride (one object per line);
+                     arena: pad_to, every allocation rounded to whole lines
+  --timer=tsc        fenced rdtsc, calibrated against steady_clock (default)
+  --timer=chrono     steady_clock per timed op
+  --sample=N         time every Nth op only (default 1)
+  --rate=OPS         pace each thread at OPS ops/s and also report response time
+                     measured from each op's intended start (coordinated omission)
+  --format=text|json|csv  output format (json/csv: one record per run, incl. PoolStats,
+                     peak RSS and page faults); --out=PATH writes it to a file
+  --suite            sweep allocators x sizes x threads x live sets:
+                     [--allocators=pool,lockfree,arena,new] [--sizes=16,64,256,1024,4096]
+                     [--thread-list=1,2,4,8 (default: powers of two up to --threads)]
+                     [--lives=0,1024] [--reps=3] [--warmup=1]; defaults to --format=json)"
                       << "\n";
             std::exit(0);
         }
@@ -74,47 +249,483 @@ static Opts parse(int argc, char **argv)
         o.iters = 1;
     if (o.size == 0)
         o.size = 1;
+    if (o.sample <= 0)
+        o.sample = 1;
+    if (o.reps <= 0)
+        o.reps = 1;
+    if (o.warmup < 0)
+        o.warmup = 0;
+    if (o.suite && o.format == "text")
+        o.format = "json";
+    if (o.threadList.empty())
+    {
+        for (int t = 1; t < o.threads; t *= 2)
+            o.threadList.push_back(t);
+        o.threadList.push_back(o.threads);
+    }
+    if (o.timer == "tsc" && !TscClock::available())
+    {
+        std::cerr << "[allocBench] invariant TSC not available; using --timer=chrono\n";
+        o.timer = "chrono";
+    }
     return o;
 }
 
-static long long percentile(std::vector<long long> &v, int p)
+// ---------------- latency harness ----------------
+// Per-thread recorder: histograms instead of raw sample vectors, timestamps from
+// the TSC (or steady_clock), optional sampling and fixed-rate pacing.
+struct ThreadLatency
+{
+    LatencyHist service;  // time inside the allocator call
+    LatencyHist response; // paced runs: completion - intended start (CO-corrected)
+};
+
+class OpTimer
+{
+public:
+    OpTimer(const Opts &o, ThreadLatency &out)
+        : out_(out), tsc_(o.timer == "tsc"), sample_(static_cast<unsigned>(o.sample)),
+          ticksPerNs_(tsc_ ? 1.0 / TscClock::nsPerTick() : 1.0)
+    {
+        if (o.rate > 0.0)
+            interval_ = static_cast<std::uint64_t>(1e9 / o.rate * ticksPerNs_);
+    }
+
+    // call right after the start barrier so pacing starts from "now"
+    void start() { base_ = now(); }
+
+    // Runs f() (one op, or one batch of `perOp` ops) and records it when sampled.
+    template <typename F>
+    auto op(F &&f, std::uint64_t perOp = 1) -> decltype(f())
+    {
+        const std::uint64_t n = n_++;
+        std::uint64_t intended = 0;
+        if (interval_)
+        {
+            intended = base_ + n * interval_;
+            while (now() < intended)
+            {
+            }
+        }
+        if (n % sample_ != 0)
+            return f();
+
+        const std::uint64_t t0 = now();
+        auto r = f();
+        const std::uint64_t t1 = now();
+        out_.service.record((t1 - t0) / perOp);
+        if (interval_)
+            out_.response.record((t1 - intended) / perOp);
+        return r;
+    }
+
+private:
+    std::uint64_t now() const { return tsc_ ? TscClock::now() : TscClock::steadyNs(); }
+
+    ThreadLatency &out_;
+    bool tsc_;
+    unsigned sample_;
+    double ticksPerNs_;
+    std::uint64_t interval_ = 0; // ticks between intended op starts
+    std::uint64_t base_ = 0;
+    std::uint64_t n_ = 0;
+};
+
+// FIFO live set with O(1) push/pop (the old vector::erase(begin()) was O(live))
+class LiveRing
+{
+public:
+    explicit LiveRing(std::size_t cap) : slots_(cap ? cap : 1) {}
+    std::size_t size() const { return count_; }
+    bool full() const { return count_ == slots_.size(); }
+    void push(void *p)
+    {
+        slots_[(head_ + count_) % slots_.size()] = p;
+        ++count_;
+    }
+    void *pop()
+    {
+        void *p = slots_[head_];
+        head_ = (head_ + 1) % slots_.size();
+        --count_;
+        return p;
+    }
+
+private:
+    std::vector<void *> slots_;
+    std::size_t head_ = 0;
+    std::size_t count_ = 0;
+};
+
+// ---------------- results ----------------
+// One run of one scenario; printed as text or emitted as a JSON/CSV record.
+struct RunResult
+{
+    std::string name;
+    std::string allocator;
+    std::string pattern;
+    int threads = 0;
+    int iters = 0;
+    std::size_t size = 0;
+    std::size_t live = 0;
+    double secs = 0.0;
+    ThreadLatency lat; // merged over threads
+    bool hasPoolStats = false;
+    PoolStats pool; // summed over per-thread pools where there are several
+    long rssBaseKb = -1;
+    long rssPeakKb = -1;
+    bool rssPeakPerRun = false; // false: VmHWM could not be reset, peak is process-wide
+    long minorFaults = 0;
+    long majorFaults = 0;
+
+    double opsPerSec() const { return (threads * 1.0 * iters) / (secs + 1e-9); }
+};
+
+// Peak RSS and page faults for one run: VmHWM is reset through /proc/self/clear_refs
+// (Linux >= 4.0) and faults are a getrusage() delta.
+class ResourceProbe
+{
+public:
+    ResourceProbe()
+    {
+        std::ofstream clear("/proc/self/clear_refs");
+        if (clear)
+        {
+            clear << "5";
+            clear.flush();
+            resetOk_ = static_cast<bool>(clear);
+        }
+        rssBase_ = statusKb_("VmRSS:");
+        getrusage(RUSAGE_SELF, &start_);
+    }
+
+    void finish(RunResult &r) const
+    {
+        rusage end{};
+        getrusage(RUSAGE_SELF, &end);
+        r.minorFaults = end.ru_minflt - start_.ru_minflt;
+        r.majorFaults = end.ru_majflt - start_.ru_majflt;
+        r.rssBaseKb = rssBase_;
+        r.rssPeakKb = statusKb_("VmHWM:");
+        if (r.rssPeakKb < 0)
+            r.rssPeakKb = end.ru_maxrss; // kilobytes on Linux
+        r.rssPeakPerRun = resetOk_;
+    }
+
+private:
+    static long statusKb_(const char *key)
+    {
+        std::ifstream f("/proc/self/status");
+        std::string line;
+        const std::size_t n = std::strlen(key);
+        while (std::getline(f, line))
+        {
+            if (line.compare(0, n, key) == 0)
+                return std::stol(line.substr(n));
+        }
+        return -1;
+    }
+
+    rusage start_{};
+    long rssBase_ = -1;
+    bool resetOk_ = false;
+};
+
+static void accumulate(PoolStats &sum, const PoolStats &s)
 {
-    if (v.empty())
-        return 0;
-    return v[(v.size() * p) / 100];
+    sum.capacity += s.capacity;
+    sum.object_size = s.object_size;
+    sum.aligned_object_size = s.aligned_object_size;
+    sum.alloc_calls += s.alloc_calls;
+    sum.free_calls += s.free_calls;
+    sum.alloc_failures += s.alloc_failures;
+    sum.cas_failures += s.cas_failures;
+    sum.high_watermark += s.high_watermark;
+    sum.in_use += s.in_use;
+    sum.magazine_refills += s.magazine_refills;
+    sum.magazine_spills += s.magazine_spills;
+    sum.remote_frees += s.remote_frees;
+    sum.remote_drains += s.remote_drains;
 }
 
-static void print_summary(const char *name,
-                          const std::vector<std::vector<long long>> &allLat,
-                          Clock::time_point t0, Clock::time_point t1,
-                          int threads, int iters, std::size_t size)
+static RunResult make_result(const char *name, const Opts &o, const std::vector<ThreadLatency> &allLat,
+                             Clock::time_point t0, Clock::time_point t1, int threads)
 {
-    std::vector<long long> merged;
-    merged.reserve(static_cast<std::size_t>(threads) * static_cast<std::size_t>(iters));
+    RunResult r;
+    r.name = name;
+    r.allocator = o.allocator;
+    r.pattern = o.pattern;
+    r.threads = threads;
+    r.iters = o.iters;
+    r.size = o.size;
+    r.live = o.live;
+    r.secs = std::chrono::duration<double>(t1 - t0).count();
     for (auto const &row : allLat)
-        merged.insert(merged.end(), row.begin(), row.end());
-    std::sort(merged.begin(), merged.end());
-    double avg = merged.empty() ? 0.0
-                                : std::accumulate(merged.begin(), merged.end(), 0.0) / merged.size();
-
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
-    double ops = (threads * 1.0 * iters) / (ms / 1000.0 + 1e-9);
-    std::cout << "\nRunning: " << name << "\n";
-    std::cout << "Threads=" << threads << " Iters/Thread=" << iters << " Size=" << size << " bytes\n";
-    std::cout << "Time: " << ms << " ms  |  Throughput: " << static_cast<long long>(ops) << " ops/s\n";
-    std::cout << "p50: " << percentile(merged, 50) << " ns, "
-              << "p95: " << percentile(merged, 95) << " ns, "
-              << "p99: " << percentile(merged, 99) << " ns, "
-              << "avg: " << static_cast<long long>(avg) << " ns\n";
+    {
+        r.lat.service.merge(row.service);
+        r.lat.response.merge(row.response);
+    }
+    return r;
 }
 
-// ---------------- pool (per-thread) ----------------
-static void run_pool_per_thread(const Opts &o)
+static double ns_per_tick(const Opts &o) { return (o.timer == "tsc") ? TscClock::nsPerTick() : 1.0; }
+
+static long long to_ns(std::uint64_t ticks, double nsPerTick)
+{
+    return static_cast<long long>(static_cast<double>(ticks) * nsPerTick + 0.5);
+}
+
+static void print_hist_line(std::ostream &os, const char *label, const LatencyHist &h, double nsPerTick)
+{
+    os << label
+       << "p50: " << to_ns(h.percentile(0.50), nsPerTick) << " ns, "
+       << "p95: " << to_ns(h.percentile(0.95), nsPerTick) << " ns, "
+       << "p99: " << to_ns(h.percentile(0.99), nsPerTick) << " ns, "
+       << "p99.9: " << to_ns(h.percentile(0.999), nsPerTick) << " ns, "
+       << "p99.99: " << to_ns(h.percentile(0.9999), nsPerTick) << " ns, "
+       << "max: " << to_ns(h.max(), nsPerTick) << " ns, "
+       << "avg: " << static_cast<long long>(h.mean() * nsPerTick) << " ns\n";
+}
+
+static void print_summary(std::ostream &os, const RunResult &r, const Opts &o)
+{
+    const double nsPerTick = ns_per_tick(o);
+    os << "\nRunning: " << r.name << "\n";
+    os << "Threads=" << r.threads << " Iters/Thread=" << r.iters << " Size=" << r.size << " bytes\n";
+    os << "Time: " << static_cast<long long>(r.secs * 1000.0) << " ms  |  Throughput: "
+       << static_cast<long long>(r.opsPerSec()) << " ops/s\n";
+    os << "Timer=" << o.timer << " samples=" << r.lat.service.count()
+       << " (every " << o.sample << " op" << (o.sample > 1 ? "s" : "") << ")";
+    if (o.rate > 0.0)
+        os << " paced at " << static_cast<long long>(o.rate) << " ops/s/thread";
+    os << "\n";
+    print_hist_line(os, o.rate > 0.0 ? "service:  " : "", r.lat.service, nsPerTick);
+    if (o.rate > 0.0)
+        print_hist_line(os, "response: ", r.lat.response, nsPerTick);
+    os << "RSS peak=" << r.rssPeakKb << " KiB" << (r.rssPeakPerRun ? "" : " (process)")
+       << " base=" << r.rssBaseKb << " KiB  page faults: minor=" << r.minorFaults
+       << " major=" << r.majorFaults << "\n";
+    if (r.hasPoolStats)
+    {
+        const PoolStats &s = r.pool;
+        os << "alloc_calls=" << s.alloc_calls
+           << " free_calls=" << s.free_calls
+           << " high_watermark=" << s.high_watermark
+           << " cas_failures=" << s.cas_failures
+           << " alloc_failures=" << s.alloc_failures << "\n";
+        if (o.magazine)
+        {
+            os << "magazine=" << o.magazine
+               << " refills=" << s.magazine_refills
+               << " spills=" << s.magazine_spills << "\n";
+        }
+        if (s.remote_frees)
+            os << "remote_frees=" << s.remote_frees << " remote_drains=" << s.remote_drains << "\n";
+    }
+}
+
+// Record writer for --format=json (one array) and --format=csv (header + rows).
+class Reporter
+{
+public:
+    Reporter(std::ostream &os, const Opts &o) : os_(os), o_(o)
+    {
+        if (o_.format == "json")
+            os_ << "[";
+        else if (o_.format == "csv")
+            os_ << kCsvHeader << "\n";
+    }
+
+    ~Reporter()
+    {
+        if (o_.format == "json")
+            os_ << (first_ ? "]\n" : "\n]\n");
+        os_.flush();
+    }
+
+    void add(const RunResult &r, int rep)
+    {
+        if (o_.format == "text")
+        {
+            print_summary(os_, r, o_);
+            return;
+        }
+        const double nsPerTick = ns_per_tick(o_);
+        const LatencyHist &h = r.lat.service;
+        const LatencyHist &resp = r.lat.response;
+        const bool paced = o_.rate > 0.0;
+        const PoolStats &s = r.pool;
+
+        if (o_.format == "csv")
+        {
+            auto opt = [&](std::size_t v)
+            { return r.hasPoolStats ? std::to_string(v) : std::string(); };
+            os_ << r.allocator << ',' << r.pattern << ',' << r.size << ',' << r.threads << ','
+                << r.live << ',' << rep << ',' << r.iters << ',' << r.secs << ','
+                << static_cast<long long>(r.opsPerSec()) << ',' << o_.timer << ',' << h.count() << ','
+                << to_ns(h.percentile(0.50), nsPerTick) << ',' << to_ns(h.percentile(0.95), nsPerTick) << ','
+                << to_ns(h.percentile(0.99), nsPerTick) << ',' << to_ns(h.percentile(0.999), nsPerTick) << ','
+                << to_ns(h.percentile(0.9999), nsPerTick) << ',' << to_ns(h.max(), nsPerTick) << ','
+                << static_cast<long long>(h.mean() * nsPerTick) << ',';
+            if (paced)
+                os_ << to_ns(resp.percentile(0.99), nsPerTick) << ',' << to_ns(resp.percentile(0.9999), nsPerTick);
+            else
+                os_ << ',';
+            os_ << ',' << r.rssBaseKb << ',' << r.rssPeakKb << ',' << (r.rssPeakPerRun ? 1 : 0) << ','
+                << r.minorFaults << ',' << r.majorFaults << ','
+                << opt(s.alloc_calls) << ',' << opt(s.free_calls) << ',' << opt(s.alloc_failures) << ','
+                << opt(s.cas_failures) << ',' << opt(s.high_watermark) << ',' << opt(s.magazine_refills) << ','
+                << opt(s.magazine_spills) << ',' << opt(s.remote_frees) << "\n";
+            return;
+        }
+
+        // json
+        os_ << (first_ ? "\n  {" : ",\n  {");
+        first_ = false;
+        os_ << "\"name\": \"" << r.name << "\", \"allocator\": \"" << r.allocator
+            << "\", \"pattern\": \"" << r.pattern << "\", \"size\": " << r.size
+            << ", \"threads\": " << r.threads << ", \"live\": " << r.live << ", \"rep\": " << rep
+            << ", \"iters\": " << r.iters << ", \"secs\": " << r.secs
+            << ", \"ops_per_sec\": " << static_cast<long long>(r.opsPerSec())
+            << ", \"timer\": \"" << o_.timer << "\", \"sample\": " << o_.sample
+            << ", \"rate\": " << o_.rate << ", \"samples\": " << h.count() << ",\n   ";
+        writeLatency_("latency_ns", h, nsPerTick);
+        if (paced)
+        {
+            os_ << ", ";
+            writeLatency_("response_ns", resp, nsPerTick);
+        }
+        os_ << ",\n   \"rss_base_kb\": " << r.rssBaseKb << ", \"rss_peak_kb\": " << r.rssPeakKb
+            << ", \"rss_peak_per_run\": " << (r.rssPeakPerRun ? "true" : "false")
+            << ", \"minor_faults\": " << r.minorFaults << ", \"major_faults\": " << r.majorFaults
+            << ",\n   \"pool_stats\": ";
+        if (!r.hasPoolStats)
+        {
+            os_ << "null}";
+            return;
+        }
+        os_ << "{\"capacity\": " << s.capacity << ", \"alloc_calls\": " << s.alloc_calls
+            << ", \"free_calls\": " << s.free_calls << ", \"alloc_failures\": " << s.alloc_failures
+            << ", \"cas_failures\": " << s.cas_failures << ", \"high_watermark\": " << s.high_watermark
+            << ", \"magazine_refills\": " << s.magazine_refills << ", \"magazine_spills\": " << s.magazine_spills
+            << ", \"remote_frees\": " << s.remote_frees << ", \"remote_drains\": " << s.remote_drains << "}}";
+    }
+
+private:
+    void writeLatency_(const char *key, const LatencyHist &h, double nsPerTick)
+    {
+        os_ << "\"" << key << "\": {\"p50\": " << to_ns(h.percentile(0.50), nsPerTick)
+            << ", \"p95\": " << to_ns(h.percentile(0.95), nsPerTick)
+            << ", \"p99\": " << to_ns(h.percentile(0.99), nsPerTick)
+            << ", \"p99_9\": " << to_ns(h.percentile(0.999), nsPerTick)
+            << ", \"p99_99\": " << to_ns(h.percentile(0.9999), nsPerTick)
+            << ", \"max\": " << to_ns(h.max(), nsPerTick)
+            << ", \"avg\": " << static_cast<long long>(h.mean() * nsPerTick) << "}";
+    }
+
+    static constexpr const char *kCsvHeader =
+        "allocator,pattern,size,threads,live,rep,iters,secs,ops_per_sec,timer,samples,"
+        "p50_ns,p95_ns,p99_ns,p99_9_ns,p99_99_ns,max_ns,avg_ns,resp_p99_ns,resp_p99_99_ns,"
+        "rss_base_kb,rss_peak_kb,rss_peak_per_run,minor_faults,major_faults,"
+        "alloc_calls,free_calls,alloc_failures,cas_failures,high_watermark,"
+        "magazine_refills,magazine_spills,remote_frees";
+
+    std::ostream &os_;
+    const Opts &o_;
+    bool first_ = true;
+};
+
+static PoolOptions bench_pool_options(const Opts &o)
 {
     PoolOptions popts = PoolOptions::MinimalOverhead();
+    popts.magazine_size = o.magazine;
+    popts.backing = o.huge ? PoolBacking::HugePages : PoolBacking::Malloc;
+    popts.prefault = o.populate;
+    popts.metrics = o.metrics == "shared" ? PoolMetrics::Shared : PoolMetrics::Sharded;
+    popts.prefetch_next = o.prefetch.find("next") != std::string::npos;
+    popts.prefetch_write = o.prefetch.find("write") != std::string::npos;
+    popts.prefetch_locality = static_cast<prefetch::Locality>(o.locality);
+    popts.alignment = o.align;
+    return popts;
+}
+
+// ---------------- bulk alloc/free (--batch) ----------------
+// One latency sample per batch, normalized to per-op. With a live set the oldest
+// batches are released first, keeping at most live_pt objects outstanding.
+template <typename Pool>
+static void run_batched(Pool &pool, const Opts &o, std::size_t live_pt,
+                        OpTimer &timer, const char *tag)
+{
+    const std::size_t batch = o.batch;
+    std::vector<void *> buf(batch);
+    std::vector<void *> ring;
+    ring.reserve(live_pt + batch);
+
+    for (int i = 0; i < o.iters; i += static_cast<int>(batch))
+    {
+        while (live_pt && ring.size() >= batch && ring.size() + batch > live_pt)
+        {
+            pool.deallocateBulk(ring.data(), batch);
+            ring.erase(ring.begin(), ring.begin() + static_cast<std::ptrdiff_t>(batch));
+        }
+
+        std::size_t got = timer.op([&]
+                                   { return pool.allocateBulk(buf.data(), batch); },
+                                   batch);
+        if (got != batch)
+        {
+            std::cerr << "[" << tag << "] short bulk alloc (" << got << "/" << batch << ")\n";
+            std::abort();
+        }
+
+        if (live_pt == 0)
+            pool.deallocateBulk(buf.data(), batch);
+        else
+            ring.insert(ring.end(), buf.begin(), buf.end());
+    }
+    if (!ring.empty())
+        pool.deallocateBulk(ring.data(), ring.size());
+}
+
+// Shared churn loop for the pool allocators: free-before-alloc when the live set
+// is full, so the allocator never sees a +1 burst.
+template <typename Pool>
+static void run_churn(Pool &pool, const Opts &o, std::size_t live_pt,
+                      OpTimer &timer, const char *tag)
+{
+    LiveRing ring(live_pt);
+    for (int i = 0; i < o.iters; ++i)
+    {
+        if (live_pt && ring.full())
+            pool.deallocate(ring.pop());
+
+        void *p = timer.op([&]
+                           { return pool.allocate(); });
+        if (!p)
+        {
+            std::cerr << "[" << tag << "] nullptr alloc\n";
+            std::abort();
+        }
+
+        if (live_pt == 0)
+            pool.deallocate(p);
+        else
+            ring.push(p);
+    }
+    // drain live set
+    while (ring.size())
+        pool.deallocate(ring.pop());
+}
+
+// ---------------- pool (per-thread) ----------------
+static RunResult run_pool_per_thread(const Opts &o)
+{
+    ResourceProbe probe;
+    PoolOptions popts = bench_pool_options(o);
     std::atomic<bool> ready{false};
     std::vector<std::thread> threads;
-    std::vector<std::vector<long long>> lat(o.threads);
+    std::vector<ThreadLatency> lat(o.threads);
+    std::vector<PoolStats> stats(o.threads);
 
     const std::size_t live_pt = (o.live == 0) ? 0 : (o.live + o.threads - 1) / o.threads;
 
@@ -122,49 +733,63 @@ static void run_pool_per_thread(const Opts &o)
     {
         // capacity: enough for this thread's live set, or at least iters for immediate free
         std::size_t cap = live_pt ? live_pt : static_cast<std::size_t>(o.iters);
+        cap = std::max(cap, o.batch);
         PoolAllocator pool(o.size, cap, popts);
+        OpTimer timer(o, lat[tid]);
 
         while (!ready.load(std::memory_order_acquire))
             std::this_thread::yield();
-        auto &l = lat[tid];
-        l.reserve(o.iters);
+        timer.start();
 
-        std::vector<void *> ring;
-        ring.reserve(live_pt ? live_pt : 1);
+        if (o.batch)
+            run_batched(pool, o, live_pt, timer, "pool");
+        else
+            run_churn(pool, o, live_pt, timer, "pool");
+        stats[tid] = pool.getStats();
+    };
 
-        for (int i = 0; i < o.iters; ++i)
-        {
-            // FIX: free-before-alloc when ring full to avoid +1 burst
-            if (live_pt && ring.size() == live_pt)
-            {
-                pool.deallocate(ring.front());
-                ring.erase(ring.begin());
-            }
+    for (int i = 0; i < o.threads; ++i)
+        threads.emplace_back(worker, i);
+    auto t0 = Clock::now();
+    ready.store(true, std::memory_order_release);
+    for (auto &th : threads)
+        th.join();
+    auto t1 = Clock::now();
 
-            auto t0 = std::chrono::high_resolution_clock::now();
-            void *p = pool.allocate();
-            auto t1 = std::chrono::high_resolution_clock::now();
+    RunResult r = make_result("pool (per-thread)", o, lat, t0, t1, o.threads);
+    r.hasPoolStats = true;
+    for (auto const &s : stats)
+        accumulate(r.pool, s);
+    probe.finish(r);
+    return r;
+}
 
-            if (!p)
-            {
-                std::cerr << "[pool] nullptr alloc\n";
-                std::abort();
-            }
+// ---------------- BasicPool<> (per-thread, policies compiled out) ----------------
+static RunResult run_basic_per_thread(const Opts &o)
+{
+    ResourceProbe probe;
+    std::atomic<bool> ready{false};
+    std::vector<std::thread> threads;
+    std::vector<ThreadLatency> lat(o.threads);
+    std::vector<PoolStats> stats(o.threads);
+    const std::size_t live_pt = (o.live == 0) ? 0 : (o.live + o.threads - 1) / o.threads;
 
-            l.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    auto worker = [&](int tid)
+    {
+        std::size_t cap = live_pt ? live_pt : static_cast<std::size_t>(o.iters);
+        cap = std::max(cap, o.batch);
+        MinimalPool pool(o.size, cap, o.huge ? PoolBacking::HugePages : PoolBacking::Malloc);
+        OpTimer timer(o, lat[tid]);
 
-            if (live_pt == 0)
-            {
-                pool.deallocate(p);
-            }
-            else
-            {
-                ring.push_back(p);
-            }
-        }
-        // drain live set
-        for (void *p : ring)
-            pool.deallocate(p);
+        while (!ready.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        timer.start();
+
+        if (o.batch)
+            run_batched(pool, o, live_pt, timer, "basic");
+        else
+            run_churn(pool, o, live_pt, timer, "basic");
+        stats[tid] = pool.getStats();
     };
 
     for (int i = 0; i < o.threads; ++i)
@@ -175,66 +800,44 @@ static void run_pool_per_thread(const Opts &o)
         th.join();
     auto t1 = Clock::now();
 
-    print_summary("pool (per-thread)", lat, t0, t1, o.threads, o.iters, o.size);
+    RunResult r = make_result("BasicPool<> (per-thread)", o, lat, t0, t1, o.threads);
+    r.hasPoolStats = true;
+    for (auto const &s : stats)
+        accumulate(r.pool, s);
+    probe.finish(r);
+    return r;
 }
 
 // --------------- lockfree (shared) ----------------
-static void run_lockfree(const Opts &o)
+static RunResult run_lockfree(const Opts &o)
 {
-    PoolOptions popts = PoolOptions::MinimalOverhead();
+    ResourceProbe probe;
+    PoolOptions popts = bench_pool_options(o);
     const std::size_t live_pt = (o.live == 0) ? 0 : (o.live + o.threads - 1) / o.threads;
     // capacity: enough for all threads' live sets + a tiny safety margin
+    // (+ what each thread's magazine may park: up to 2 batches)
     const std::size_t cap = (live_pt
                                  ? (live_pt + 1) * static_cast<std::size_t>(o.threads) // +1 per thread safety
-                                 : static_cast<std::size_t>(o.threads) * 1024);
+                                 : static_cast<std::size_t>(o.threads) * 1024) +
+                            (2 * o.magazine + o.batch) * static_cast<std::size_t>(o.threads);
 
     LockFreePoolAllocator pool(o.size, cap, popts);
 
     std::atomic<bool> ready{false};
     std::vector<std::thread> threads;
-    std::vector<std::vector<long long>> lat(o.threads);
+    std::vector<ThreadLatency> lat(o.threads);
 
     auto worker = [&](int tid)
     {
+        OpTimer timer(o, lat[tid]);
         while (!ready.load(std::memory_order_acquire))
             std::this_thread::yield();
-        auto &l = lat[tid];
-        l.reserve(o.iters);
-
-        std::vector<void *> ring;
-        ring.reserve(live_pt ? live_pt : 1);
-
-        for (int i = 0; i < o.iters; ++i)
-        {
-            // FIX: free-before-alloc when ring full
-            if (live_pt && ring.size() == live_pt)
-            {
-                pool.deallocate(ring.front());
-                ring.erase(ring.begin());
-            }
-
-            auto t0 = std::chrono::high_resolution_clock::now();
-            void *p = pool.allocate();
-            auto t1 = std::chrono::high_resolution_clock::now();
-
-            if (!p)
-            {
-                std::cerr << "[lockfree] nullptr alloc\n";
-                std::abort();
-            }
-            l.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+        timer.start();
 
-            if (live_pt == 0)
-            {
-                pool.deallocate(p);
-            }
-            else
-            {
-                ring.push_back(p);
-            }
-        }
-        for (void *p : ring)
-            pool.deallocate(p);
+        if (o.batch)
+            run_batched(pool, o, live_pt, timer, "lockfree");
+        else
+            run_churn(pool, o, live_pt, timer, "lockfree");
     };
 
     for (int i = 0; i < o.threads; ++i)
@@ -245,34 +848,35 @@ static void run_lockfree(const Opts &o)
         th.join();
     auto t1 = Clock::now();
 
-    print_summary("lockfree (shared)", lat, t0, t1, o.threads, o.iters, o.size);
-
-    // quick stats snapshot
-    PoolStats s = pool.getStats();
-    std::cout << "alloc_calls=" << s.alloc_calls
-              << " free_calls=" << s.free_calls
-              << " high_watermark=" << s.high_watermark
-              << " cas_failures=" << s.cas_failures
-              << " alloc_failures=" << s.alloc_failures << "\n";
+    RunResult r = make_result("lockfree (shared)", o, lat, t0, t1, o.threads);
+    r.hasPoolStats = true;
+    r.pool = pool.getStats();
+    probe.finish(r);
+    return r;
 }
 
 // ---------------- arena (per-thread) ---------------
-static void run_arena(const Opts &o)
+static RunResult run_arena(const Opts &o)
 {
+    ResourceProbe probe;
     ArenaOptions aopts;
     aopts.use_canaries = false; // keep overhead low for perf
+    aopts.prefer_huge = o.huge;
+    aopts.populate = o.populate;
+    aopts.headerless = o.headerless;
+    aopts.pad_to = o.align;
     std::atomic<bool> ready{false};
     std::vector<std::thread> threads;
-    std::vector<std::vector<long long>> lat(o.threads);
+    std::vector<ThreadLatency> lat(o.threads);
     const std::size_t live_pt = (o.live == 0) ? 0 : (o.live + o.threads - 1) / o.threads;
 
     auto worker = [&](int tid)
     {
         ArenaAllocator arena(aopts);
+        OpTimer timer(o, lat[tid]);
         while (!ready.load(std::memory_order_acquire))
             std::this_thread::yield();
-        auto &l = lat[tid];
-        l.reserve(o.iters);
+        timer.start();
 
         std::size_t live_now = 0;
         for (int i = 0; i < o.iters; ++i)
@@ -284,16 +888,13 @@ static void run_arena(const Opts &o)
                 live_now = 0;
             }
 
-            auto t0 = std::chrono::high_resolution_clock::now();
-            void *p = arena.allocate(o.size, alignof(std::max_align_t));
-            auto t1 = std::chrono::high_resolution_clock::now();
-
+            void *p = timer.op([&]
+                               { return arena.allocate(o.size, alignof(std::max_align_t)); });
             if (!p)
             {
                 std::cerr << "[arena] nullptr alloc\n";
                 std::abort();
             }
-            l.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
 
             if (live_pt != 0)
                 ++live_now;
@@ -309,60 +910,50 @@ static void run_arena(const Opts &o)
         th.join();
     auto t1 = Clock::now();
 
-    print_summary("arena (per-thread)", lat, t0, t1, o.threads, o.iters, o.size);
+    RunResult r = make_result(o.headerless ? "arena (per-thread, headerless)" : "arena (per-thread)", o, lat, t0, t1, o.threads);
+    probe.finish(r);
+    return r;
 }
 
 // --------------- baseline new/delete ---------------
-static void run_newdelete(const Opts &o)
+static RunResult run_newdelete(const Opts &o)
 {
+    ResourceProbe probe;
     const std::size_t live_pt = (o.live == 0) ? 0 : (o.live + o.threads - 1) / o.threads;
 
     std::atomic<bool> ready{false};
     std::vector<std::thread> threads;
-    std::vector<std::vector<long long>> lat(o.threads);
+    std::vector<ThreadLatency> lat(o.threads);
 
     auto worker = [&](int tid)
     {
+        OpTimer timer(o, lat[tid]);
         while (!ready.load(std::memory_order_acquire))
             std::this_thread::yield();
-        auto &l = lat[tid];
-        l.reserve(o.iters);
-
-        std::vector<void *> ring;
-        ring.reserve(live_pt ? live_pt : 1);
+        timer.start();
 
+        LiveRing ring(live_pt);
         for (int i = 0; i < o.iters; ++i)
         {
-            // FIX: free-before-alloc to keep live set at target size
-            if (live_pt && ring.size() == live_pt)
-            {
-                ::operator delete(ring.front());
-                ring.erase(ring.begin());
-            }
-
-            auto t0 = std::chrono::high_resolution_clock::now();
-            void *p = ::operator new(o.size, std::nothrow);
-            auto t1 = std::chrono::high_resolution_clock::now();
+            // free-before-alloc to keep live set at target size
+            if (live_pt && ring.full())
+                ::operator delete(ring.pop());
 
+            void *p = timer.op([&]
+                               { return ::operator new(o.size, std::nothrow); });
             if (!p)
             {
                 std::cerr << "[new] nullptr alloc\n";
                 std::abort();
             }
 
-            l.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
-
             if (live_pt == 0)
-            {
                 ::operator delete(p);
-            }
             else
-            {
-                ring.push_back(p);
-            }
+                ring.push(p);
         }
-        for (void *p : ring)
-            ::operator delete(p);
+        while (ring.size())
+            ::operator delete(ring.pop());
     };
 
     for (int i = 0; i < o.threads; ++i)
@@ -373,34 +964,264 @@ static void run_newdelete(const Opts &o)
         th.join();
     auto t1 = Clock::now();
 
-    print_summary("baseline new/delete", lat, t0, t1, o.threads, o.iters, o.size);
+    RunResult r = make_result("baseline new/delete", o, lat, t0, t1, o.threads);
+    probe.finish(r);
+    return r;
 }
 
-int main(int argc, char **argv)
+// ------------- producer -> consumer (cross-thread free) -------------
+// Bounded SPSC handoff per pair; the producer's allocate() is what gets timed.
+class SpscRing
 {
-    Opts o = parse(argc, argv);
-
-    if (o.allocator == "pool")
+public:
+    explicit SpscRing(std::size_t cap) : slots_(cap) {}
+    bool push(void *p)
     {
-        run_pool_per_thread(o);
+        const std::size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_.load(std::memory_order_acquire) == slots_.size())
+            return false;
+        slots_[t % slots_.size()] = p;
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
     }
-    else if (o.allocator == "lockfree")
+    void *pop()
     {
-        run_lockfree(o);
+        const std::size_t h = head_.load(std::memory_order_relaxed);
+        if (h == tail_.load(std::memory_order_acquire))
+            return nullptr;
+        void *p = slots_[h % slots_.size()];
+        head_.store(h + 1, std::memory_order_release);
+        return p;
     }
-    else if (o.allocator == "arena")
+
+private:
+    std::vector<void *> slots_;
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+static RunResult run_producer_consumer(const Opts &o)
+{
+    ResourceProbe probe;
+    constexpr std::size_t kRing = 1024;
+    const int pairs = std::max(1, o.threads / 2);
+    PoolOptions popts = bench_pool_options(o);
+
+    // every block is either in a ring, in flight, or waiting in a remote queue
+    const std::size_t per_pair = kRing + 1;
+    std::unique_ptr<LockFreePoolAllocator> shared;
+    if (o.allocator == "lockfree")
+        shared = std::make_unique<LockFreePoolAllocator>(
+            o.size, (per_pair + 4 * o.magazine) * static_cast<std::size_t>(pairs), popts);
+
+    struct Pair
     {
-        run_arena(o);
-    }
-    else if (o.allocator == "new")
+        SpscRing ring{kRing};
+        std::atomic<bool> done{false};
+    };
+    std::vector<std::unique_ptr<Pair>> pp;
+    for (int i = 0; i < pairs; ++i)
+        pp.push_back(std::make_unique<Pair>());
+
+    std::atomic<bool> ready{false};
+    std::vector<std::thread> threads;
+    std::vector<ThreadLatency> lat(pairs);
+    std::vector<PoolStats> stats(pairs);
+
+    auto producer = [&](int pid)
+    {
+        std::unique_ptr<RemoteFreePoolAllocator> own;
+        if (o.allocator == "pool")
+            own = std::make_unique<RemoteFreePoolAllocator>(o.size, per_pair, popts);
+        OpTimer timer(o, lat[pid]);
+        while (!ready.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        timer.start();
+        Pair &pr = *pp[pid];
+
+        for (int i = 0; i < o.iters; ++i)
+        {
+            void *p = nullptr;
+            while (true)
+            {
+                p = timer.op([&]() -> void *
+                             {
+                    if (own)
+                        return own->allocate();
+                    if (shared)
+                        return shared->allocate();
+                    return ::operator new(o.size, std::nothrow); });
+                if (p)
+                    break;
+                std::this_thread::yield(); // every block is in flight; wait for the consumer
+            }
+            std::memset(p, i & 0xFF, std::min<std::size_t>(o.size, 64));
+            while (!pr.ring.push(p))
+                std::this_thread::yield();
+        }
+        pr.done.store(true, std::memory_order_release);
+        // keep the pool alive until the consumer has released everything
+        while (own && own->getStats().in_use != 0)
+            std::this_thread::yield();
+        if (own)
+            stats[pid] = own->getStats();
+    };
+
+    auto consumer = [&](int pid)
+    {
+        Pair &pr = *pp[pid];
+        while (!ready.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        while (true)
+        {
+            void *p = pr.ring.pop();
+            if (!p)
+            {
+                if (pr.done.load(std::memory_order_acquire) && !(p = pr.ring.pop()))
+                    break;
+                if (!p)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+            }
+            if (o.allocator == "pool")
+                RemoteFreePoolAllocator::release(p); // owner found from the pointer
+            else if (shared)
+                shared->deallocate(p);
+            else
+                ::operator delete(p);
+        }
+    };
+
+    for (int i = 0; i < pairs; ++i)
     {
-        run_newdelete(o);
+        threads.emplace_back(producer, i);
+        threads.emplace_back(consumer, i);
     }
+    auto t0 = Clock::now();
+    ready.store(true, std::memory_order_release);
+    for (auto &th : threads)
+        th.join();
+    auto t1 = Clock::now();
+
+    const std::string name = "producer-consumer " + o.allocator +
+                             (o.allocator == "pool" ? " (remote-free)" : "");
+    RunResult r = make_result(name.c_str(), o, lat, t0, t1, pairs);
+    r.hasPoolStats = o.allocator != "new";
+    if (shared)
+        r.pool = shared->getStats();
     else
+        for (auto const &s : stats)
+            accumulate(r.pool, s);
+    probe.finish(r);
+    return r;
+}
+
+// validates pattern/allocator; false with a message on stderr
+static bool check_scenario(const Opts &o)
+{
+    if (o.pattern == "producer-consumer")
+    {
+        if (o.allocator != "pool" && o.allocator != "lockfree" && o.allocator != "new")
+        {
+            std::cerr << "--pattern=producer-consumer supports pool | lockfree | new\n";
+            return false;
+        }
+        return true;
+    }
+    if (o.pattern != "churn")
+    {
+        std::cerr << "Unknown pattern: " << o.pattern << " (expected: churn | producer-consumer)\n";
+        return false;
+    }
+    if (o.allocator != "pool" && o.allocator != "basic" && o.allocator != "lockfree" && o.allocator != "arena" &&
+        o.allocator != "new")
     {
         std::cerr << "Unknown allocator: " << o.allocator
-                  << " (expected: pool | lockfree | arena | new)\n";
+                  << " (expected: pool | basic | lockfree | arena | new)\n";
+        return false;
+    }
+    return true;
+}
+
+static RunResult run_one(const Opts &o)
+{
+    if (o.pattern == "producer-consumer")
+        return run_producer_consumer(o);
+    if (o.allocator == "pool")
+        return run_pool_per_thread(o);
+    if (o.allocator == "basic")
+        return run_basic_per_thread(o);
+    if (o.allocator == "lockfree")
+        return run_lockfree(o);
+    if (o.allocator == "arena")
+        return run_arena(o);
+    return run_newdelete(o);
+}
+
+// allocator x size x threads x live, each scenario warmed up then repeated
+static int run_suite(const Opts &base, Reporter &rep)
+{
+    for (auto const &alloc : base.allocators)
+    {
+        Opts c = base;
+        c.allocator = alloc;
+        if (!check_scenario(c))
+            return 2;
+    }
+    for (auto const &alloc : base.allocators)
+        for (std::size_t size : base.sizes)
+            for (int threads : base.threadList)
+                for (std::size_t live : base.lives)
+                {
+                    Opts c = base;
+                    c.allocator = alloc;
+                    c.size = size ? size : 1;
+                    c.threads = threads > 0 ? threads : 1;
+                    c.live = live;
+                    for (int i = -c.warmup; i < c.reps; ++i)
+                    {
+                        RunResult r = run_one(c);
+                        if (i < 0)
+                            continue;
+                        rep.add(r, i);
+                        std::cerr << "[suite] " << alloc << " size=" << c.size << " threads=" << c.threads
+                                  << " live=" << live << " rep=" << i << ": "
+                                  << static_cast<long long>(r.opsPerSec()) << " ops/s\n";
+                    }
+                }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    Opts o = parse(argc, argv);
+    if (o.format != "text" && o.format != "json" && o.format != "csv")
+    {
+        std::cerr << "Unknown format: " << o.format << " (expected: text | json | csv)\n";
         return 2;
     }
+    if (o.timer == "tsc")
+        (void)TscClock::nsPerTick(); // calibrate before any thread starts
+
+    std::ofstream file;
+    if (!o.out.empty())
+    {
+        file.open(o.out);
+        if (!file)
+        {
+            std::cerr << "cannot open " << o.out << "\n";
+            return 2;
+        }
+    }
+    std::ostream &os = o.out.empty() ? std::cout : file;
+    Reporter rep(os, o);
+
+    if (o.suite)
+        return run_suite(o, rep);
+    if (!check_scenario(o))
+        return 2;
+    rep.add(run_one(o), 0);
     return 0;
 }
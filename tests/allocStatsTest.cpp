@@ -0,0 +1,207 @@
+#include "utils/allocStats.hpp"
+#include "allocators/arenaAllocator.hpp"
+#include "allocators/poolAllocator.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+static void require(bool cond, const char *msg)
+{
+    if (!cond)
+    {
+        std::cerr << "[TEST] " << msg << "\n";
+        std::abort();
+    }
+}
+
+static const alloc_stats::Sample *find(const std::vector<alloc_stats::Sample> &v, const char *name)
+{
+    for (const auto &s : v)
+        if (std::strcmp(s.name, name) == 0)
+            return &s;
+    return nullptr;
+}
+
+static void test_registry()
+{
+    std::cout << "[A] registry: pools, arenas and groups register and unregister\n";
+    const std::size_t before = alloc_stats::registered();
+    {
+        PoolOptions po;
+        po.stats_name = "orders";
+        PoolAllocator pool(48, 64, po);
+        void *a = pool.allocate();
+        void *b = pool.allocate();
+        pool.deallocate(a);
+
+        ArenaOptions ao;
+        ao.initial_chunk_size = 4096;
+        ao.stats_name = "scratch";
+        ArenaAllocator arena(ao);
+        arena.allocate(100);
+        arena.allocate(200);
+
+        ArenaOptions hl = ao;
+        hl.headerless = true;
+        hl.stats_name = "packed";
+        ArenaAllocator packed(hl);
+        for (int i = 0; i < 100; ++i)
+            packed.allocate(64, 8); // 6400 bytes: the second chunk publishes the first one's 4096
+
+        ArenaGroupOptions go;
+        go.stats_name = "recycler";
+        go.shards = 1;
+        ArenaGroup group(go);
+
+        PoolOptions quiet;
+        quiet.register_stats = false;
+        PoolAllocator hidden(16, 8, quiet);
+
+        require(alloc_stats::registered() == before + 4, "A: not every allocator registered");
+        const auto all = alloc_stats::sampleAll();
+        const auto *p = find(all, "orders");
+        require(p && p->kind == alloc_stats::Kind::Pool, "A: pool sample missing");
+        require(p->objects == 1 && p->alloc_calls == 2 && p->free_calls == 1, "A: pool counters");
+        require(p->capacity_bytes == 64 * 48 && p->used_bytes == 48 && p->high_watermark == 2, "A: pool bytes");
+        const auto *a1 = find(all, "scratch");
+        require(a1 && a1->kind == alloc_stats::Kind::Arena && a1->used_bytes == 300 && a1->alloc_calls == 2,
+                "A: header-mode arena sample");
+        require(a1->capacity_bytes >= 4096 && a1->objects == 1, "A: arena chunk bytes");
+        const auto *a2 = find(all, "packed");
+        require(a2 && a2->objects == 2 && a2->used_bytes >= 4096 && a2->used_bytes <= 6400, "A: headerless arena sample");
+        require(find(all, "recycler") && find(all, "recycler")->kind == alloc_stats::Kind::ArenaGroup, "A: group missing");
+
+        arena.reset();
+        const auto afterReset = alloc_stats::sampleAll();
+        const auto *r = find(afterReset, "scratch");
+        require(r && r->used_bytes == 0 && r->high_watermark == 300 && r->free_calls == 1, "A: reset not published");
+
+        ArenaAllocator moved(std::move(arena));
+        require(alloc_stats::registered() == before + 4, "A: move added or lost a registration");
+        moved.allocate(50);
+        const auto afterMove = alloc_stats::sampleAll();
+        require(find(afterMove, "scratch") && find(afterMove, "scratch")->used_bytes == 50, "A: moved arena not sampled");
+        pool.deallocate(b);
+    }
+    require(alloc_stats::registered() == before, "A: destructors left entries behind");
+}
+
+static void test_prometheus()
+{
+    std::cout << "[B] prometheus text exposition\n";
+    PoolOptions po;
+    po.stats_name = "quote\"book";
+    PoolAllocator pool(64, 16, po);
+    void *p = pool.allocate();
+    const std::string text = alloc_stats::prometheus();
+    require(text.find("# TYPE finalloc_used_bytes gauge") != std::string::npos, "B: missing TYPE line");
+    require(text.find("# TYPE finalloc_alloc_calls_total counter") != std::string::npos, "B: missing counter");
+    const std::string label = "kind=\"pool\",name=\"quote\\\"book\"}";
+    require(text.find("finalloc_used_bytes{id=") != std::string::npos, "B: no used_bytes series");
+    require(text.find(label + " 64\n") != std::string::npos, "B: used bytes / label escaping wrong");
+    require(text.find(label + " 1024\n") != std::string::npos, "B: capacity bytes wrong");
+    pool.deallocate(p);
+}
+
+static void test_sampler_ring()
+{
+    std::cout << "[C] sampler: background rounds, ring history, concurrent reader\n";
+    PoolOptions po;
+    po.stats_name = "ring";
+    po.metrics = PoolMetrics::Sharded;
+    PoolAllocator pool(32, 256, po);
+
+    alloc_stats::Sampler sampler(std::chrono::milliseconds(1), 64);
+    std::atomic<bool> done{false};
+    std::atomic<std::size_t> seen{0};
+    std::thread reader([&]
+                       {
+                           while (!done.load(std::memory_order_relaxed))
+                           {
+                               std::uint64_t last = 0;
+                               for (const auto &s : sampler.history())
+                               {
+                                   require(s.ns >= last, "C: history out of order");
+                                   require(s.id != 0, "C: torn row");
+                                   last = s.ns;
+                               }
+                               seen.fetch_add(1, std::memory_order_relaxed);
+                               std::this_thread::yield();
+                           } });
+    sampler.start();
+    std::vector<void *> live;
+    const auto stopAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    while (std::chrono::steady_clock::now() < stopAt || sampler.rounds() < 20)
+    {
+        for (int i = 0; i < 64; ++i)
+            if (void *p = pool.allocate())
+                live.push_back(p);
+        for (void *p : live)
+            pool.deallocate(p);
+        live.clear();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    sampler.stop();
+    done = true;
+    reader.join();
+    require(sampler.rounds() >= 20, "C: sampler did not run");
+    require(sampler.overwritten() > 0, "C: ring never wrapped");
+    const auto h = sampler.history();
+    require(h.size() == 64, "C: full ring not returned");
+    require(seen.load() > 0, "C: reader never ran");
+
+    sampler.sampleOnce();
+    const auto recent = sampler.history(sampler.history().back().ns);
+    require(!recent.empty() && find(recent, "ring") != nullptr, "C: sinceNs filter lost the last round");
+}
+
+static void test_stats_file()
+{
+    std::cout << "[D] mmap'd stats file\n";
+    const std::string path = "/tmp/finalloc-stats-" + std::to_string(::getpid());
+    PoolOptions po;
+    po.stats_name = "file";
+    PoolAllocator pool(128, 32, po);
+    void *a = pool.allocate();
+    void *b = pool.allocate();
+
+    alloc_stats::Sampler sampler(std::chrono::milliseconds(100), 16);
+    require(sampler.exportFile(path), "D: exportFile failed");
+    require(alloc_stats::readStatsFile(path).empty(), "D: rows before the first round");
+    sampler.sampleOnce();
+    auto rows = alloc_stats::readStatsFile(path);
+    const auto *r = find(rows, "file");
+    require(r && r->used_bytes == 256 && r->objects == 2, "D: file row wrong");
+    pool.deallocate(a);
+    sampler.sampleOnce();
+    rows = alloc_stats::readStatsFile(path);
+    require(find(rows, "file") && find(rows, "file")->used_bytes == 128, "D: file not updated");
+    require(alloc_stats::readStatsFile(path + ".missing").empty(), "D: missing file read");
+
+    // a capacity of one row keeps the first entry and counts it
+    require(sampler.exportFile(path, 1), "D: re-export failed");
+    sampler.sampleOnce();
+    require(alloc_stats::readStatsFile(path).size() == 1, "D: rows past capacity");
+    pool.deallocate(b);
+    std::remove(path.c_str());
+}
+
+int main()
+{
+    std::cout << "\n==== allocStatsTest ====\n";
+    test_registry();
+    test_prometheus();
+    test_sampler_ring();
+    test_stats_file();
+    std::cout << "[OK] allocStatsTest passed.\n";
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include "allocators/arenaAllocator.hpp"
+#include "allocators/poolAllocator.hpp"
+#include "utils/allocTrace.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+static void require(bool cond, const char *msg)
+{
+    if (!cond)
+    {
+        std::cerr << "[TEST] " << msg << "\n";
+        std::abort();
+    }
+}
+
+// call sites the trace must point into
+[[gnu::noinline]] void *arena_site(ArenaAllocator &a, std::size_t n)
+{
+    void *p = a.allocate(n);
+    asm volatile("" ::: "memory"); // keep the call out of tail position
+    return p;
+}
+[[gnu::noinline]] void *pool_site(PoolAllocator &p)
+{
+    void *b = p.allocate();
+    asm volatile("" ::: "memory");
+    return b;
+}
+
+static bool inside(const void *site, const void *fn)
+{
+    const auto s = reinterpret_cast<std::uintptr_t>(site);
+    const auto f = reinterpret_cast<std::uintptr_t>(fn);
+    return s > f && s < f + 4096;
+}
+
+static void test_arena_journal()
+{
+    std::cout << "[A] arena journaling: threshold, call sites, reset\n";
+    alloc_trace::drain();
+    ArenaOptions ao;
+    ao.initial_chunk_size = 1 << 16;
+    ao.journaling = true;
+    ao.journal_threshold_bytes = 1024;
+    ArenaAllocator arena(ao);
+
+    for (int i = 0; i < 10; ++i)
+        arena.allocate(64); // below the threshold
+    void *big = arena_site(arena, 2048);
+    void *huge = arena_site(arena, 1 << 17); // slow path, new chunk
+    arena.reset();
+
+    const auto ev = alloc_trace::drain();
+    require(ev.size() == 3, "A: expected two allocations and one reset");
+    require(ev[0].op == alloc_trace::Op::Alloc && ev[0].ptr == big && ev[0].size == 2048, "A: first event");
+    require(ev[1].ptr == huge && ev[1].size == (1u << 17), "A: slow-path event");
+    require(ev[2].op == alloc_trace::Op::Reset && ev[2].size == 640 + 2048 + (1u << 17), "A: reset event");
+    for (const auto &e : ev)
+        require(e.source == &arena, "A: source");
+    require(inside(ev[0].site, reinterpret_cast<const void *>(&arena_site)), "A: fast-path call site");
+    require(inside(ev[1].site, reinterpret_cast<const void *>(&arena_site)), "A: slow-path call site");
+    require(ev[0].tsc <= ev[1].tsc && ev[1].tsc <= ev[2].tsc, "A: events out of order");
+
+    const auto sym = alloc_trace::symbolize(ev[0].site);
+    require(sym.module.find("allocTraceTest") != std::string::npos && sym.offset != 0, "A: module+offset");
+    std::ostringstream os;
+    alloc_trace::dump(os, ev);
+    require(os.str().find("alloc 2048") != std::string::npos && os.str().find("reset") != std::string::npos,
+            "A: dump");
+    require(alloc_trace::drain().empty(), "A: drain must consume");
+
+    ArenaOptions hl = ao;
+    hl.headerless = true;
+    ArenaAllocator quiet(hl);
+    quiet.allocate(4096);
+    require(alloc_trace::drain().empty(), "A: headerless arenas do not journal");
+}
+
+static void test_pool_trace()
+{
+    std::cout << "[B] pool tracing: alloc/free, bulk, lock-free\n";
+    alloc_trace::drain(); // [A]'s arena logged its release on destruction
+    PoolOptions po;
+    po.trace = true;
+    PoolAllocator pool(48, 64, po);
+    void *a = pool_site(pool);
+    pool.deallocate(a);
+    void *blocks[8];
+    require(pool.allocateBulk(blocks, 8) == 8, "B: bulk");
+    pool.deallocateBulk(blocks, 8);
+
+    auto ev = alloc_trace::drain();
+    require(ev.size() == 18, "B: one event per block");
+    require(ev[0].op == alloc_trace::Op::Alloc && ev[0].ptr == a && ev[0].size == 48, "B: alloc event");
+    require(ev[1].op == alloc_trace::Op::Free && ev[1].ptr == a, "B: free event");
+    require(inside(ev[0].site, reinterpret_cast<const void *>(&pool_site)), "B: call site");
+
+    LockFreePoolAllocator lf(64, 64, po);
+    lf.deallocate(lf.allocate());
+    PoolAllocator off(64, 16);
+    off.deallocate(off.allocate());
+    ev = alloc_trace::drain();
+    require(ev.size() == 2 && ev[0].source == &lf && ev[1].op == alloc_trace::Op::Free, "B: lock-free pool events");
+}
+
+static void test_threads_and_wrap()
+{
+    std::cout << "[C] per-thread rings, wrap-around, exited threads\n";
+    PoolOptions po;
+    po.trace = true;
+    constexpr int THREADS = 4;
+    constexpr int OPS = 500;
+    std::vector<std::thread> ts;
+    for (int t = 0; t < THREADS; ++t)
+    {
+        ts.emplace_back([&]
+                        {
+                            PoolAllocator local(32, 16, po);
+                            for (int i = 0; i < OPS; ++i)
+                                local.deallocate(local.allocate()); });
+    }
+    for (auto &t : ts)
+        t.join();
+    auto ev = alloc_trace::drain(); // the threads are gone; their events are not
+    require(ev.size() == THREADS * OPS * 2, "C: events of exited threads");
+    std::set<std::uint16_t> rings;
+    for (const auto &e : ev)
+        rings.insert(e.thread);
+    require(rings.size() == THREADS, "C: one ring per thread");
+    for (std::size_t i = 1; i < ev.size(); ++i)
+        require(ev[i - 1].tsc <= ev[i].tsc, "C: drain not time ordered");
+
+    const std::uint64_t before = alloc_trace::dropped();
+    PoolAllocator pool(32, 16, po);
+    const std::size_t n = alloc_trace::kRingEvents + 100;
+    for (std::size_t i = 0; i < n; ++i)
+        pool.deallocate(pool.allocate()); // 2 events each
+    ev = alloc_trace::drain();
+    // a live ring never hands out the slot its owner could be rewriting
+    require(ev.size() == alloc_trace::kRingEvents - 1, "C: live ring keeps the newest kRingEvents - 1");
+    require(alloc_trace::dropped() - before == 2 * n - (alloc_trace::kRingEvents - 1), "C: dropped count");
+    require(ev.back().op == alloc_trace::Op::Free, "C: newest event kept");
+}
+
+int main()
+{
+    std::cout << "\n==== allocTraceTest ====\n";
+    test_arena_journal();
+    test_pool_trace();
+    test_threads_and_wrap();
+    std::cout << "[OK] allocTraceTest passed.\n";
+    return 0;
+}
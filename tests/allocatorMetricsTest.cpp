@@ -6,9 +6,29 @@
 #include <chrono>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <set>
 #include <thread>
 #include <vector>
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+// resident pages of [p, p + len) (mincore)
+static std::size_t residentPages(const void *p, std::size_t len)
+{
+    const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const auto lo = reinterpret_cast<std::uintptr_t>(p) & ~(page - 1);
+    const auto hi = (reinterpret_cast<std::uintptr_t>(p) + len + page - 1) & ~(page - 1);
+    std::vector<unsigned char> vec((hi - lo) / page);
+    if (::mincore(reinterpret_cast<void *>(lo), hi - lo, vec.data()) != 0)
+        return 0;
+    std::size_t n = 0;
+    for (unsigned char v : vec)
+        n += v & 1;
+    return n;
+}
+
 static std::size_t alignUp(std::size_t n, std::size_t alignment)
 {
     return (n + alignment - 1) & ~(alignment - 1);
@@ -169,6 +189,669 @@ int main()
                   << "\n";
     }
 
+    {
+        std::cout << "[D] tagged head ABA stress (MT, tiny pool)\n";
+        // A tiny pool shared by many threads recycles the same few blocks constantly,
+        // which is exactly the pop/push interleaving that breaks an untagged head.
+        constexpr int THREADS = 16;
+        constexpr int ITERS = 3000;
+        constexpr int HOLD = 2;
+
+        LockFreePoolAllocator pool(64, THREADS * HOLD, PoolOptions::MinimalOverhead());
+
+        std::atomic<bool> go{false};
+        std::vector<std::thread> ths;
+        ths.reserve(THREADS);
+
+        for (int t = 0; t < THREADS; ++t)
+        {
+            ths.emplace_back([&, t]
+                             {
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                void* held[HOLD];
+                for (int i = 0; i < ITERS; ++i) {
+                    const std::uint64_t stamp = (static_cast<std::uint64_t>(t) << 32) | static_cast<std::uint32_t>(i);
+                    for (int h = 0; h < HOLD; ++h) {
+                        held[h] = pool.allocate();
+                        require(held[h] != nullptr, "D: unexpected alloc failure");
+                        std::memcpy(held[h], &stamp, sizeof(stamp));
+                    }
+                    if ((i & 7) == 0) std::this_thread::yield();
+                    for (int h = 0; h < HOLD; ++h) {
+                        std::uint64_t seen = 0;
+                        std::memcpy(&seen, held[h], sizeof(seen));
+                        // a block handed to two threads at once would be overwritten here
+                        require(seen == stamp, "D: block owned by two threads at once");
+                        pool.deallocate(held[h]);
+                    }
+                } });
+        }
+        go.store(true, std::memory_order_release);
+        for (auto &th : ths)
+            th.join();
+
+        PoolStats s = pool.getStats();
+        require(s.in_use == 0, "D: in_use must be 0 after all thread joins");
+        require(s.alloc_failures == 0, "D: no allocation may fail with capacity == threads*hold");
+        require(s.high_watermark <= s.capacity, "D: high_watermark above capacity");
+
+        // every block must still be reachable exactly once from the free list
+        std::vector<void *> all;
+        for (std::size_t i = 0; i < s.capacity; ++i)
+        {
+            void *p = pool.allocate();
+            require(p != nullptr, "D: free list lost a block");
+            all.push_back(p);
+        }
+        require(pool.allocate() == nullptr, "D: free list holds more blocks than capacity");
+        for (void *p : all)
+            pool.deallocate(p);
+        std::cout << "   cas_failures=" << s.cas_failures << "\n";
+    }
+
+    {
+        std::cout << "[E] per-thread magazines\n";
+        constexpr int THREADS = 6;
+        constexpr int ITERS = 4000;
+        constexpr std::size_t MAG = 8;
+
+        PoolOptions o = PoolOptions::MinimalOverhead();
+        o.magazine_size = MAG;
+        const std::size_t cap = THREADS * (2 * MAG + 4);
+        LockFreePoolAllocator pool(64, cap, o);
+
+        std::atomic<bool> go{false};
+        std::vector<std::thread> ths;
+        for (int t = 0; t < THREADS; ++t)
+        {
+            ths.emplace_back([&]
+                             {
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                void* held[4];
+                for (int i = 0; i < ITERS; ++i) {
+                    // alternate short bursts so the magazine both refills and spills
+                    const int burst = 1 + (i % 4);
+                    for (int h = 0; h < burst; ++h) {
+                        held[h] = pool.allocate();
+                        require(held[h] != nullptr, "E: unexpected alloc failure");
+                    }
+                    for (int h = 0; h < burst; ++h) pool.deallocate(held[h]);
+                } });
+        }
+        go.store(true, std::memory_order_release);
+        for (auto &th : ths)
+            th.join();
+
+        PoolStats s = pool.getStats();
+        require(s.in_use == 0, "E: in_use must be 0 after all thread joins");
+        require(s.alloc_calls == s.free_calls, "E: alloc_calls must equal free_calls");
+        require(s.thread_caches.size() == THREADS, "E: expected one magazine per thread");
+        require(s.magazine_refills >= THREADS, "E: every thread should refill at least once");
+        require(s.magazine_cached == 0, "E: exited threads must flush their magazines");
+
+        // all blocks must be back on the shared list
+        std::vector<void *> all;
+        for (std::size_t i = 0; i < cap; ++i)
+        {
+            void *p = pool.allocate();
+            require(p != nullptr, "E: blocks lost in thread caches");
+            all.push_back(p);
+        }
+        for (void *p : all)
+            pool.deallocate(p);
+        s = pool.getStats();
+        require(s.magazine_spills > 0, "E: freeing a full pool from one thread must spill");
+        std::cout << "   refills=" << s.magazine_refills << " spills=" << s.magazine_spills
+                  << " cas_failures=" << s.cas_failures << "\n";
+
+        // pool destroyed while a thread still holds a magazine for it
+        std::thread late([&]
+                         {
+            {
+                LockFreePoolAllocator shortLived(64, 64, o);
+                void* p = shortLived.allocate();
+                require(p != nullptr, "E: short-lived pool alloc failed");
+                shortLived.deallocate(p);
+            }
+            // a second pool on the same thread must not reuse the dead magazine
+            LockFreePoolAllocator other(64, 64, o);
+            void* q = other.allocate();
+            require(q != nullptr, "E: second pool alloc failed");
+            other.deallocate(q); });
+        late.join();
+    }
+
+    {
+        std::cout << "[F] bulk allocate/deallocate\n";
+        constexpr std::size_t CAP = 100;
+        constexpr std::size_t BATCH = 64;
+
+        PoolAllocator base(64, CAP, PoolOptions::MinimalOverhead());
+        LockFreePoolAllocator lf(64, CAP, PoolOptions::DebugStrong(/*quarantine*/ 0));
+        for (PoolAllocator *pool : {&base, static_cast<PoolAllocator *>(&lf)})
+        {
+            void *a[BATCH];
+            void *b[BATCH];
+            require(pool->allocateBulk(a, BATCH) == BATCH, "F: first batch short");
+            // only CAP - BATCH remain: the second batch comes back short
+            const std::size_t got = pool->allocateBulk(b, BATCH);
+            require(got == CAP - BATCH, "F: second batch should be truncated to what is left");
+
+            for (std::size_t i = 0; i < BATCH; ++i)
+                for (std::size_t j = 0; j < got; ++j)
+                    require(a[i] != b[j], "F: block handed out twice");
+
+            PoolStats s = pool->getStats();
+            require(s.in_use == CAP, "F: in_use after bulk alloc");
+            require(s.high_watermark == CAP, "F: high_watermark after bulk alloc");
+            require(s.alloc_calls == 2 * BATCH, "F: alloc_calls counts objects");
+            require(s.alloc_failures == BATCH - got, "F: alloc_failures counts the short part");
+
+            pool->deallocateBulk(a, BATCH);
+            pool->deallocateBulk(b, got);
+            s = pool->getStats();
+            require(s.in_use == 0 && s.free_calls == CAP, "F: metrics after bulk free");
+
+            // everything must be allocatable again
+            std::vector<void *> all(CAP);
+            require(pool->allocateBulk(all.data(), CAP) == CAP, "F: blocks lost by bulk free");
+            pool->deallocateBulk(all.data(), CAP);
+        }
+    }
+
+    {
+        std::cout << "[G] remote-free pool (producer/consumer)\n";
+        constexpr std::size_t CAP = 16;
+        constexpr int MESSAGES = 20000;
+
+        PoolOptions o = PoolOptions::MinimalOverhead();
+        o.poison_on_free = true;
+        o.verify_poison_on_alloc = true;
+
+        std::atomic<void *> slot{nullptr}; // single-slot handoff
+        std::atomic<bool> done{false};
+        RemoteFreePoolAllocator *poolPtr = nullptr;
+        std::atomic<bool> poolReady{false};
+
+        std::thread producer([&]
+                             {
+            RemoteFreePoolAllocator pool(64, CAP, o);
+            poolPtr = &pool;
+            poolReady.store(true, std::memory_order_release);
+            for (int i = 0; i < MESSAGES; ++i) {
+                void* p = nullptr;
+                // the tiny pool only keeps up if consumer frees are drained back
+                while (!(p = pool.allocate())) std::this_thread::yield();
+                std::memcpy(p, &i, sizeof(i));
+                void* expected = nullptr;
+                while (!slot.compare_exchange_weak(expected, p, std::memory_order_release)) {
+                    expected = nullptr;
+                    std::this_thread::yield();
+                }
+            }
+            while (slot.load(std::memory_order_acquire)) std::this_thread::yield();
+            done.store(true, std::memory_order_release);
+
+            // wait for the last remote free to land, then everything must be reclaimable
+            PoolStats s = pool.getStats();
+            while (s.in_use != 0) { std::this_thread::yield(); s = pool.getStats(); }
+            require(s.remote_frees == static_cast<std::uint64_t>(MESSAGES), "G: every free was remote");
+            require(s.remote_drains > 0, "G: owner never drained the remote queue");
+            std::vector<void*> all(CAP);
+            require(pool.allocateBulk(all.data(), CAP) == CAP, "G: blocks lost in remote queue");
+            pool.deallocateBulk(all.data(), CAP);
+            poolReady.store(false, std::memory_order_release); });
+
+        while (!poolReady.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        int expect = 0;
+        void *seenBlock = nullptr;
+        while (!done.load(std::memory_order_acquire))
+        {
+            void *p = slot.exchange(nullptr, std::memory_order_acq_rel);
+            if (!p)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            int v = -1;
+            std::memcpy(&v, p, sizeof(v));
+            require(v == expect++, "G: message corrupted");
+            seenBlock = p;
+            require(RemoteFreePoolAllocator::ownerOf(p) == poolPtr, "G: registry lookup failed");
+            require(RemoteFreePoolAllocator::release(p), "G: release() did not find the pool");
+        }
+        require(expect == MESSAGES, "G: consumer missed messages");
+        producer.join();
+
+        int local = 0;
+        require(RemoteFreePoolAllocator::ownerOf(&local) == nullptr, "G: stack address has no owner");
+        require(RemoteFreePoolAllocator::ownerOf(seenBlock) == nullptr, "G: destroyed pool must unregister");
+    }
+
+    {
+        std::cout << "[H] slab backing + lazy free-list construction\n";
+        // large pools construct without touching their blocks; pages fault on first use
+        constexpr std::size_t BIG = 1u << 20;
+        PoolOptions mo;
+        mo.backing = PoolBacking::Mmap;
+        PoolAllocator big(64, BIG, mo);
+        PoolStats bs = big.getStats();
+        require(bs.backing == PageBacking::Small, "H: mmap backing not reported");
+        require(bs.untouched == BIG, "H: fresh pool should have every block untouched");
+        void *a = big.allocate();
+        void *b = big.allocate();
+        require(a == big.memory() && b == static_cast<char *>(a) + 64, "H: bump cursor hands out blocks in order");
+        big.deallocate(a);
+        require(big.allocate() == a, "H: recycled blocks are preferred over fresh ones");
+        require(big.getStats().untouched == BIG - 2, "H: untouched count off");
+
+        // huge pages: 2 MiB aligned slab whichever of hugetlb/THP/4k we got
+        PoolOptions ho;
+        ho.backing = PoolBacking::HugePages;
+        ho.prefault = true;
+        LockFreePoolAllocator huge(128, 1u << 16, ho);
+        require(reinterpret_cast<std::uintptr_t>(huge.memory()) % os_memory::kHugePageSize == 0,
+                "H: huge-page slab not 2 MiB aligned");
+
+        // lock-free pool: bump tail and recycled list together, with magazines
+        PoolOptions lo = PoolOptions::DebugStrong(0);
+        lo.magazine_size = 8;
+        constexpr std::size_t CAP = 100;
+        LockFreePoolAllocator lf(48, CAP, lo);
+        std::vector<void *> got;
+        for (std::size_t i = 0; i < CAP; ++i)
+        {
+            void *p = lf.allocate(); // poison verified on fresh blocks too
+            require(p != nullptr, "H: lock-free pool ran dry before capacity");
+            got.push_back(p);
+        }
+        require(lf.allocate() == nullptr, "H: lock-free pool handed out more than capacity");
+        require(lf.getStats().untouched == 0, "H: bump cursor should be exhausted");
+        for (void *p : got)
+            lf.deallocate(p);
+        // bulk calls bypass the magazine, which still parks some of the freed blocks
+        const std::size_t shared = CAP - lf.getStats().magazine_cached;
+        std::vector<void *> again(CAP);
+        require(lf.allocateBulk(again.data(), CAP) == shared, "H: bulk realloc after full cycle short");
+        lf.deallocateBulk(again.data(), shared);
+    }
+
+    {
+        std::cout << "[I] sharded metrics\n";
+        PoolOptions so;
+        so.metrics = PoolMetrics::Sharded;
+        so.magazine_size = 16;
+        constexpr std::size_t CAP = 4096;
+        LockFreePoolAllocator pool(64, CAP, so);
+
+        // single thread: same numbers as the shared counters, exact high watermark
+        std::vector<void *> held;
+        for (int i = 0; i < 300; ++i)
+            held.push_back(pool.allocate());
+        for (int i = 0; i < 100; ++i)
+        {
+            pool.deallocate(held.back());
+            held.pop_back();
+        }
+        PoolStats s = pool.getStats();
+        require(s.alloc_calls == 300 && s.free_calls == 100, "I: call counts");
+        require(s.in_use == 200 && pool.used() == 200 && s.high_watermark == 300, "I: in_use / high watermark");
+        for (void *p : held)
+            pool.deallocate(p);
+
+        // more threads than exclusive shards: counts stay exact
+        constexpr int THREADS = 80;
+        constexpr int ROUNDS = 200;
+        std::vector<std::thread> ts;
+        for (int t = 0; t < THREADS; ++t)
+        {
+            ts.emplace_back([&]
+                            {
+                                void *mine[4];
+                                for (int r = 0; r < ROUNDS; ++r)
+                                {
+                                    for (auto &p : mine)
+                                        p = pool.allocate();
+                                    for (auto *p : mine)
+                                        pool.deallocate(p);
+                                } });
+        }
+        for (auto &t : ts)
+            t.join();
+        s = pool.getStats();
+        require(s.alloc_calls == 300 + THREADS * ROUNDS * 4, "I: MT alloc_calls");
+        require(s.free_calls == s.alloc_calls && s.in_use == 0 && s.alloc_failures == 0, "I: MT free/in_use");
+        require(s.high_watermark >= 300 && s.high_watermark <= CAP, "I: approximate watermark out of bounds");
+
+        // allocated on one thread, freed on another: shards go negative, the sum does not
+        PoolOptions po;
+        po.metrics = PoolMetrics::Sharded;
+        PoolAllocator plain(64, 64, po);
+        std::vector<void *> blocks;
+        for (int i = 0; i < 32; ++i)
+            blocks.push_back(plain.allocate());
+        std::thread([&]
+                    { for (void *p : blocks) plain.deallocate(p); })
+            .join();
+        s = plain.getStats();
+        require(s.in_use == 0 && s.free_calls == 32 && s.high_watermark == 32, "I: cross-thread frees");
+        require(PoolOptions::MinimalOverhead().metrics == PoolMetrics::Sharded, "I: MinimalOverhead preset");
+    }
+
+    {
+        std::cout << "[J] quarantine rings: batches, min age, per-thread\n";
+        // single-thread pool: FIFO, the oldest block comes back first
+        PoolOptions o;
+        o.quarantine_size = 3;
+        PoolAllocator pool(32, 8, o);
+        void *b[8];
+        for (auto &p : b)
+            p = pool.allocate();
+        for (auto *p : b)
+            pool.deallocate(p);
+        require(pool.getStats().quarantined == 3, "J: ring should hold quarantine_size blocks");
+        require(pool.allocate() == b[4], "J: newest released block first (LIFO free list)");
+
+        // lock-free pool: evictions come in batches, one CAS each
+        PoolOptions lo;
+        lo.quarantine_size = 8;
+        lo.quarantine_batch = 4;
+        LockFreePoolAllocator lf(32, 64, lo);
+        std::vector<void *> live;
+        for (int i = 0; i < 12; ++i)
+            live.push_back(lf.allocate());
+        for (int i = 0; i < 11; ++i)
+            lf.deallocate(live[i]);
+        require(lf.getStats().quarantined == 11, "J: nothing evicted below size + batch - 1");
+        lf.deallocate(live[11]);
+        require(lf.getStats().quarantined == 8, "J: one batch evicted");
+        void *again[4];
+        require(lf.allocateBulk(again, 4) == 4, "J: bulk after eviction");
+        require(std::set<void *>(again, again + 4) == std::set<void *>(live.begin(), live.begin() + 4),
+                "J: the oldest batch should be back on the free list");
+
+        // minimum age: a full ring still evicts, but counts it
+        PoolOptions ao;
+        ao.quarantine_size = 2;
+        ao.quarantine_min_age_us = 200000;
+        LockFreePoolAllocator aged(32, 16, ao);
+        void *x[4];
+        for (auto &p : x)
+            p = aged.allocate();
+        for (auto *p : x)
+            aged.deallocate(p);
+        require(aged.getStats().quarantine_early == 2, "J: early evictions not counted");
+        ao.quarantine_min_age_us = 100;
+        LockFreePoolAllocator patient(32, 16, ao);
+        for (auto &p : x)
+            p = patient.allocate();
+        for (auto *p : x)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            patient.deallocate(p);
+        }
+        require(patient.getStats().quarantine_early == 0, "J: aged blocks counted as early");
+
+        // per-thread rings, no lock on free; exiting threads flush theirs
+        PoolOptions dso = PoolOptions::DebugStrong(64);
+        require(dso.quarantine_batch == 16, "J: DebugStrong batches evictions");
+        constexpr std::size_t CAP = 4096;
+        LockFreePoolAllocator debug(64, CAP, dso);
+        std::vector<std::thread> ts;
+        for (int t = 0; t < 4; ++t)
+        {
+            ts.emplace_back([&]
+                            {
+                                std::vector<void *> mine;
+                                for (int r = 0; r < 2000; ++r)
+                                {
+                                    void *p = debug.allocate();
+                                    require(p != nullptr, "J: debug pool ran dry");
+                                    std::memset(p, 0x5A, 64);
+                                    mine.push_back(p);
+                                    if (mine.size() == 8)
+                                    {
+                                        for (void *q : mine)
+                                            debug.deallocate(q);
+                                        mine.clear();
+                                    }
+                                }
+                                for (void *q : mine)
+                                    debug.deallocate(q); });
+        }
+        for (auto &t : ts)
+            t.join();
+        const PoolStats ds = debug.getStats();
+        require(ds.quarantined == 0 && ds.in_use == 0, "J: thread exit must flush its quarantine");
+        std::vector<void *> all(CAP);
+        require(debug.allocateBulk(all.data(), CAP) == CAP, "J: quarantined blocks lost");
+        debug.deallocateBulk(all.data(), CAP);
+    }
+
+    {
+        std::cout << "[K] prefetch hints do not change allocation order\n";
+        for (int lf = 0; lf < 2; ++lf)
+        {
+            PoolOptions plain;
+            plain.magazine_size = lf ? 4 : 0;
+            PoolOptions hinted = plain;
+            hinted.prefetch_next = true;
+            hinted.prefetch_write = true;
+            hinted.prefetch_locality = prefetch::Locality::Moderate;
+            std::unique_ptr<PoolAllocator> a, b;
+            if (lf)
+            {
+                a = std::make_unique<LockFreePoolAllocator>(64, 32, plain);
+                b = std::make_unique<LockFreePoolAllocator>(64, 32, hinted);
+            }
+            else
+            {
+                a = std::make_unique<PoolAllocator>(64, 32, plain);
+                b = std::make_unique<PoolAllocator>(64, 32, hinted);
+            }
+            auto offsets = [](PoolAllocator &p)
+            {
+                std::vector<std::ptrdiff_t> out;
+                std::vector<void *> live;
+                for (int round = 0; round < 3; ++round)
+                {
+                    while (void *q = p.allocate())
+                        live.push_back(q);
+                    for (std::size_t i = 0; i < live.size(); i += 2) // free every other block
+                        p.deallocate(live[i]);
+                    for (void *q : live)
+                        out.push_back(static_cast<char *>(q) - static_cast<char *>(p.memory()));
+                    std::vector<void *> keep;
+                    for (std::size_t i = 1; i < live.size(); i += 2)
+                        keep.push_back(live[i]);
+                    live.swap(keep);
+                }
+                for (void *q : live)
+                    p.deallocate(q);
+                return out;
+            };
+            require(offsets(*a) == offsets(*b), "K: prefetching changed the pool's behaviour");
+        }
+    }
+
+    {
+        std::cout << "[L] cache-line alignment, stride and slab color\n";
+        for (int lf = 0; lf < 2; ++lf)
+        {
+            for (std::size_t align : {std::size_t{64}, std::size_t{128}})
+            {
+                PoolOptions o;
+                o.alignment = align;
+                o.magazine_size = lf ? 4 : 0;
+                std::unique_ptr<PoolAllocator> p;
+                if (lf)
+                    p = std::make_unique<LockFreePoolAllocator>(24, 32, o);
+                else
+                    p = std::make_unique<PoolAllocator>(24, 32, o);
+                require(p->blockSize() == 32 * align, "L: stride not rounded to the alignment");
+                std::set<std::uintptr_t> lines;
+                std::vector<void *> live;
+                while (void *q = p->allocate())
+                {
+                    require(reinterpret_cast<std::uintptr_t>(q) % align == 0, "L: block not aligned");
+                    lines.insert(reinterpret_cast<std::uintptr_t>(q) / 64);
+                    live.push_back(q);
+                }
+                require(live.size() == 32 && lines.size() == 32, "L: two blocks share a cache line");
+                for (void *q : live)
+                    p->deallocate(q);
+            }
+        }
+
+        PoolOptions colored;
+        colored.backing = PoolBacking::Mmap; // page-aligned slab base
+        colored.color = 150;                 // rounds up to the 64-byte alignment
+        colored.alignment = 64;
+        PoolAllocator c(64, 16, colored);
+        require(reinterpret_cast<std::uintptr_t>(c.memory()) % 4096 == 192, "L: color offset");
+        void *first = c.allocate();
+        require(first == c.memory(), "L: first block must sit at the colored base");
+        std::memset(first, 0x11, 64);
+        c.deallocate(first);
+
+        PoolOptions heap = colored;
+        heap.backing = PoolBacking::Malloc;
+        {
+            PoolAllocator h(48, 8, heap); // aligned_alloc + color, freed through the raw base
+            require(reinterpret_cast<std::uintptr_t>(h.memory()) % 64 == 0, "L: colored heap slab misaligned");
+            h.deallocate(h.allocate());
+        }
+
+        bool threw = false;
+        try
+        {
+            PoolOptions bad;
+            bad.alignment = 48;
+            PoolAllocator x(16, 4, bad);
+        }
+        catch (const std::invalid_argument &)
+        {
+            threw = true;
+        }
+        require(threw, "L: non power-of-two alignment must be rejected");
+    }
+
+    {
+        std::cout << "[M] trim returns free pages to the OS\n";
+        constexpr std::size_t CAP = 4096; // 64 blocks per 4 KiB page
+        for (int kind = 0; kind < 3; ++kind)
+        {
+            PoolOptions o;
+            o.backing = PoolBacking::Mmap;
+            std::unique_ptr<PoolAllocator> p;
+            if (kind == 0)
+                p = std::make_unique<PoolAllocator>(64, CAP, o);
+            else if (kind == 1)
+                p = std::make_unique<LockFreePoolAllocator>(64, CAP, o);
+            else
+                p = std::make_unique<RemoteFreePoolAllocator>(64, CAP, o);
+            std::vector<void *> all(CAP);
+            require(p->allocateBulk(all.data(), CAP) == CAP, "M: fill");
+            for (void *b : all)
+                std::memset(b, 0x3C, 64);
+            const std::size_t before = residentPages(p->memory(), p->blockSize());
+            // keep one block per 16 pages alive; everything else is freed
+            std::set<void *> live;
+            for (std::size_t i = 0; i < CAP; ++i)
+            {
+                if (i % 1024 == 5)
+                    live.insert(all[i]);
+                else
+                    p->deallocate(all[i]);
+            }
+            const std::size_t bytes = p->trim();
+            const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            require(bytes == (CAP * 64 / page - live.size()) * page, "M: trimmed bytes");
+            require(residentPages(p->memory(), p->blockSize()) <= before - bytes / page, "M: pages still resident");
+            require(p->getStats().trimmed_bytes == bytes, "M: trimmed_bytes stat");
+            for (void *b : live)
+                require(static_cast<unsigned char *>(b)[10] == 0x3C, "M: live block lost its contents");
+
+            // every freed block comes back, exactly once
+            std::vector<void *> again;
+            while (void *b = p->allocate())
+            {
+                std::memset(b, 0x44, 64);
+                again.push_back(b);
+            }
+            require(again.size() == CAP - live.size(), "M: blocks lost across trim");
+            std::set<void *> uniq(again.begin(), again.end());
+            require(uniq.size() == again.size(), "M: block handed out twice");
+            for (void *b : live)
+                require(uniq.count(b) == 0, "M: live block handed out");
+            for (void *b : again)
+                p->deallocate(b);
+            for (void *b : live)
+                p->deallocate(b);
+            require(p->trim(true) > 0, "M: lazy trim");
+        }
+
+        PoolOptions strict = PoolOptions::DebugStrong(0);
+        strict.backing = PoolBacking::Mmap;
+        PoolAllocator d(64, 256, strict);
+        d.deallocate(d.allocate());
+        require(d.trim() == 0, "M: poison-verified pools keep their pages");
+    }
+
+    {
+        std::cout << "[N] growable pools: slabs on demand\n";
+        PoolOptions o;
+        o.max_capacity = 1000;
+        PoolAllocator g(64, 16, o);
+        require(g.capacity() == 16 && g.maxCapacity() == 1000, "N: initial capacity");
+        std::vector<void *> live;
+        while (void *b = g.allocate())
+        {
+            std::memset(b, 0x77, 64);
+            live.push_back(b);
+        }
+        PoolStats st = g.getStats();
+        require(live.size() == 1000 && st.capacity == 1000 && st.alloc_failures == 1, "N: grow up to max_capacity");
+        require(st.slabs == 7, "N: slabs double (16, 16, 32, ... clamped)");
+        require(std::set<void *>(live.begin(), live.end()).size() == live.size(), "N: duplicate block");
+        for (void *b : live)
+            g.deallocate(b);
+
+        // a big reservation costs nothing until used
+        PoolOptions big;
+        big.max_capacity = std::size_t{1} << 22; // 256 MiB of 64-byte blocks
+        LockFreePoolAllocator lf(64, 64, big);
+        require(lf.capacity() == 64 && residentPages(lf.memory(), lf.blockSize()) <= 2, "N: reservation backed");
+
+        constexpr int THREADS = 4;
+        constexpr int PER = 3000;
+        std::vector<std::vector<void *>> got(THREADS);
+        std::vector<std::thread> ts;
+        for (int t = 0; t < THREADS; ++t)
+            ts.emplace_back([&, t]
+                            {
+                                for (int i = 0; i < PER; ++i)
+                                {
+                                    void *b = lf.allocate();
+                                    require(b != nullptr, "N: concurrent growth failed");
+                                    std::memset(b, t, 64);
+                                    got[t].push_back(b);
+                                } });
+        for (auto &t : ts)
+            t.join();
+        std::set<void *> all;
+        for (auto &v : got)
+            all.insert(v.begin(), v.end());
+        require(all.size() == THREADS * PER, "N: block handed out twice while growing");
+        require(lf.capacity() >= THREADS * PER && lf.capacity() < 4 * THREADS * PER, "N: growth follows load");
+        for (auto &v : got)
+            for (void *b : v)
+                lf.deallocate(b);
+        require(lf.trim() > 0, "N: empty slabs trimmed");
+        require(lf.allocate() != nullptr, "N: allocate after trim");
+    }
+
     std::cout << "[OK] allocatorMetricsTest passed.\n";
     return 0;
 }
@@ -1,13 +1,22 @@
 #include "allocators/arenaAllocator.hpp"
+#include "allocators/arenaBalancer.hpp"
+#include "utils/memoryTrimmer.hpp"
 
 #include <atomic>
 #include <cassert>
 #include <chrono>
+#include <csignal>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <new>
 #include <thread>
 #include <vector>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 struct BenchObj
 {
     int x;
@@ -203,6 +212,747 @@ static void test_arena_group_recycler()
     }
 }
 
+static void test_huge_page_backing()
+{
+    std::cout << "[E] mmap / huge-page chunk backing\n";
+    ArenaOptions opts;
+    opts.initial_chunk_size = 3 * 1024 * 1024;
+    opts.prefer_huge = true;
+    opts.populate = true;
+    {
+        ArenaAllocator a(opts);
+        const auto &c = a.chunkAt(0);
+        if (!c.use_mmap || c.backing == PageBacking::Heap || !c.populated)
+        {
+            std::cerr << "prefer_huge chunk should be mmapped and populated\n";
+            std::abort();
+        }
+        // HugeTlb or a 2 MiB aligned THP candidate; size rounded to whole huge pages
+        if (reinterpret_cast<std::uintptr_t>(c.base) % os_memory::kHugePageSize != 0 ||
+            c.size % os_memory::kHugePageSize != 0 || c.size < opts.initial_chunk_size)
+        {
+            std::cerr << "huge chunk not 2 MiB aligned/rounded\n";
+            std::abort();
+        }
+        std::cout << "    backing=" << os_memory::backingName(c.backing) << "\n";
+
+        // the whole rounded mapping is usable, and growth keeps the backing
+        auto *p = static_cast<unsigned char *>(a.allocate(c.size - 4096, 64));
+        p[0] = 1;
+        p[c.size - 4097] = 2;
+        (void)a.allocate(1 << 20, 64);
+        if (a.chunkCount() < 2 || !a.chunkAt(1).use_mmap)
+        {
+            std::cerr << "grown chunk lost its mmap backing\n";
+            std::abort();
+        }
+    }
+
+    // default options stay on the heap
+    ArenaAllocator plain(ArenaOptions{});
+    if (plain.chunkAt(0).use_mmap || plain.chunkAt(0).backing != PageBacking::Heap)
+    {
+        std::cerr << "default arena should not mmap\n";
+        std::abort();
+    }
+}
+
+// Runs fn in a child; true if the child died touching a PROT_NONE page.
+template <typename F>
+static bool faults_in_child(F &&fn)
+{
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        struct sigaction sa{};
+        sa.sa_handler = [](int)
+        { _exit(42); };
+        sigaction(SIGSEGV, &sa, nullptr);
+        sigaction(SIGBUS, &sa, nullptr);
+        fn();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 42) ||
+           (WIFSIGNALED(status) && (WTERMSIG(status) == SIGSEGV || WTERMSIG(status) == SIGBUS));
+}
+
+// Runs fn in a child; true if the child aborted.
+template <typename F>
+static bool aborts_in_child(F &&fn)
+{
+    std::cout.flush(); // the child must not repeat buffered output
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        std::freopen("/dev/null", "w", stderr); // keep the expected [Arena] message out of the log
+        fn();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+static void test_guards_and_canaries()
+{
+    std::cout << "[F] guard pages + canary verification\n";
+    ArenaOptions opts;
+    opts.initial_chunk_size = 64 * 1024;
+    opts.use_canaries = true;
+    opts.canary_size = 16;
+    opts.guard_pages = true;
+
+    ArenaAllocator a(opts);
+    std::vector<unsigned char *> blocks;
+    for (int i = 0; i < 200; ++i)
+    {
+        auto *p = static_cast<unsigned char *>(a.allocate(24 + (i % 5) * 40, (i % 3) ? 16 : 64));
+        std::memset(p, 0x11, 24 + (i % 5) * 40);
+        blocks.push_back(p);
+    }
+    if (a.verify())
+    {
+        std::cerr << "clean arena reported corrupted\n";
+        std::abort();
+    }
+
+    // one-byte overrun into block 57's post canary is pinned to that block
+    unsigned char *victim = blocks[57];
+    const std::size_t sz = 24 + (57 % 5) * 40;
+    const unsigned char saved = victim[sz];
+    victim[sz] = 0x00;
+    auto bad = a.verify();
+    if (!bad || bad.block != victim || bad.payload_size != sz || std::strcmp(bad.what, "post-canary") != 0)
+    {
+        std::cerr << "overrun not attributed to the right block\n";
+        std::abort();
+    }
+    victim[sz] = saved;
+
+    // underrun hits the pre canary
+    blocks[3][-1] = 0x00;
+    bad = a.verify();
+    if (!bad || bad.block != blocks[3] || std::strcmp(bad.what, "pre-canary") != 0)
+    {
+        std::cerr << "underrun not detected\n";
+        std::abort();
+    }
+    blocks[3][-1] = opts.canary_byte;
+    if (a.verify())
+    {
+        std::cerr << "restored arena still reported corrupted\n";
+        std::abort();
+    }
+
+    // guard pages: running off either end of a chunk faults
+    const auto &c = a.chunkAt(0);
+    if (!c.guard_pages || !c.use_mmap)
+    {
+        std::cerr << "guard_pages chunk not mmapped with guards\n";
+        std::abort();
+    }
+    auto *lo = static_cast<volatile unsigned char *>(c.base);
+    volatile unsigned char *hi = lo + c.size;
+    if (!faults_in_child([&]
+                         { hi[0] = 1; }) ||
+        !faults_in_child([&]
+                         { lo[-1] = 1; }))
+    {
+        std::cerr << "guard page access did not fault\n";
+        std::abort();
+    }
+
+    opts.verify_on_reset = true;
+    ArenaAllocator checked(opts);
+    (void)checked.allocate(100);
+    checked.reset(); // clean: must not abort
+}
+
+static void test_balancer()
+{
+    std::cout << "[G] balancer: prefill hot group, trim cold group\n";
+    constexpr std::size_t SLAB = 64 * 1024;
+    ArenaGroup hot;
+    ArenaGroup cold;
+
+    std::vector<ArenaGroup::Chunk> held;
+    for (int i = 0; i < 4; ++i)
+        held.push_back(cold.acquire(SLAB, false, false));
+    for (auto &c : held)
+        cold.release(std::move(c));
+    held.clear();
+
+    ArenaBalancerOptions o;
+    o.reserve_slabs = 2;
+    o.cold_ticks = 3;
+    o.populate = false;
+    ArenaBalancer bal({&hot, &cold}, o);
+
+    for (int i = 0; i < 3; ++i)
+        held.push_back(hot.acquire(SLAB, false, false));
+    const std::uint64_t coldMisses = hot.stats().os_allocs;
+    bal.tick();
+    if (hot.stats().cached_slabs < o.reserve_slabs + 3)
+    {
+        std::cerr << "hot group not prefilled\n";
+        std::abort();
+    }
+
+    // steady demand on the hot group is served from the bins; the cold one goes quiet
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 2; ++i)
+            held.push_back(hot.acquire(SLAB, false, false));
+        bal.tick();
+    }
+    if (hot.stats().os_allocs != coldMisses)
+    {
+        std::cerr << "hot group took the OS slow path after prefill\n";
+        std::abort();
+    }
+    const ArenaGroup::Stats cs = cold.stats();
+    if (cs.cached_slabs != 0 || cs.trimmed_bytes < 4 * SLAB)
+    {
+        std::cerr << "cold group idle slabs not returned to the OS\n";
+        std::abort();
+    }
+    for (auto &c : held)
+        hot.release(std::move(c));
+    held.clear();
+
+    // hard cap, then the same through the background thread
+    ArenaBalancerOptions capped = o;
+    capped.max_idle_bytes = 2 * SLAB;
+    capped.interval = std::chrono::milliseconds(1);
+    ArenaBalancer bg({&hot}, capped);
+    bg.start();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (hot.stats().cached_bytes > capped.max_idle_bytes && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    bg.stop();
+    if (hot.stats().cached_bytes > capped.max_idle_bytes || bg.stats().ticks == 0 || bg.running())
+    {
+        std::cerr << "background balancer did not enforce the idle cap\n";
+        std::abort();
+    }
+}
+
+static void test_headerless()
+{
+    std::cout << "[H] headerless bump mode\n";
+    ArenaOptions opts;
+    opts.initial_chunk_size = 4096;
+    opts.max_chunk_size = 1 << 20;
+    opts.headerless = true;
+    opts.use_canaries = true; // ignored in headerless mode
+    opts.canary_size = 16;
+    opts.verify_on_reset = true;
+    ArenaAllocator arena(opts);
+
+    // 64-byte objects at 16-byte alignment pack back to back
+    auto *a = static_cast<unsigned char *>(arena.allocate(64, 16));
+    auto *b = static_cast<unsigned char *>(arena.allocate(64, 16));
+    if (b != a + 64)
+    {
+        std::cerr << "headerless blocks not contiguous\n";
+        std::abort();
+    }
+    for (std::size_t align : {1ull, 8ull, 24ull, 64ull, 4096ull})
+    {
+        void *p = arena.allocate(3, align);
+        const std::size_t want = (align & (align - 1)) ? 32 : align; // 24 rounds up to 32
+        if (reinterpret_cast<std::uintptr_t>(p) & (want - 1))
+        {
+            std::cerr << "headerless misaligned pointer for align " << align << "\n";
+            std::abort();
+        }
+    }
+
+    // alignment 0 means max_align_t, on the inline bump and when it spills to a new chunk
+    for (int round = 0; round < 2; ++round)
+    {
+        if (round == 1)
+            arena.allocate(arena.bytesRemaining() - 48, 1); // room for p0 only: p1 takes a new chunk
+        auto *p0 = static_cast<unsigned char *>(arena.allocate(32));
+        auto *p1 = static_cast<unsigned char *>(arena.allocate(32, 0));
+        auto *p2 = static_cast<unsigned char *>(arena.allocate(32));
+        const auto &cur = arena.chunkAt(arena.chunkCount() - 1);
+        const auto *lo = static_cast<unsigned char *>(cur.base);
+        if (!p0 || !p1 || !p2 || p1 < lo || p2 < p1 + 32 || p2 + 32 > lo + cur.size ||
+            reinterpret_cast<std::uintptr_t>(p1) % alignof(std::max_align_t) != 0)
+        {
+            std::cerr << "headerless allocate(n, 0) corrupted the bump cursor\n";
+            std::abort();
+        }
+    }
+
+    // a size that can never fit is rejected, not wrapped around the chunk end
+    {
+        auto *before = static_cast<unsigned char *>(arena.allocate(16));
+        bool threw = false;
+        try
+        {
+            arena.allocate(SIZE_MAX - 8);
+        }
+        catch (const std::bad_alloc &)
+        {
+            threw = true;
+        }
+        auto *x = static_cast<unsigned char *>(arena.allocate(16));
+        auto *y = static_cast<unsigned char *>(arena.allocate(16));
+        if (!threw || x < before + 16 || y < x + 16)
+        {
+            std::cerr << "headerless oversized allocation moved the bump cursor\n";
+            std::abort();
+        }
+    }
+
+    // growth across chunks keeps every block intact
+    std::vector<std::uint32_t *> blocks;
+    for (std::uint32_t i = 0; i < 20000; ++i)
+    {
+        auto *p = static_cast<std::uint32_t *>(arena.allocate(sizeof(std::uint32_t), alignof(std::uint32_t)));
+        *p = i;
+        blocks.push_back(p);
+    }
+    for (std::uint32_t i = 0; i < blocks.size(); ++i)
+    {
+        if (*blocks[i] != i)
+        {
+            std::cerr << "headerless block overwritten\n";
+            std::abort();
+        }
+    }
+    if (arena.chunkCount() < 2 || arena.verify())
+    {
+        std::cerr << "headerless growth/verify\n";
+        std::abort();
+    }
+
+    // reset rewinds the current chunk; moved arenas keep their bump window
+    arena.reset();
+    const ArenaAllocator::ArenaChunk &last = arena.chunkAt(arena.chunkCount() - 1);
+    auto *first = static_cast<unsigned char *>(arena.allocate(64, 16));
+    if (first != last.base)
+    {
+        std::cerr << "headerless reset did not rewind\n";
+        std::abort();
+    }
+    ArenaAllocator moved(std::move(arena));
+    auto *c = static_cast<unsigned char *>(moved.allocate(64, 16));
+    if (c != first + 64 || moved.bytesRemaining() != moved.chunkAt(moved.chunkCount() - 1).size - 128)
+    {
+        std::cerr << "headerless move lost the bump cursor\n";
+        std::abort();
+    }
+    moved.release();
+    if (!moved.allocate(8))
+    {
+        std::cerr << "headerless allocate after release\n";
+        std::abort();
+    }
+}
+
+static void test_sharded_group()
+{
+    std::cout << "[I] sharded ArenaGroup: bins, caps, oversize, idle trim, concurrency\n";
+    constexpr std::size_t K = 1024;
+    ArenaGroupOptions go;
+    go.bin_sizes = {256 * K, 64 * K}; // unsorted on purpose
+    go.max_slabs_per_bin = 2;
+    go.shards = 4;
+    ArenaGroup grp(go);
+    if (grp.options().bin_sizes != std::vector<std::size_t>({64 * K, 256 * K}))
+    {
+        std::cerr << "bin sizes not normalized\n";
+        std::abort();
+    }
+
+    // a 100K chunk is floored into the 64K bin: it must not serve a 200K request
+    ArenaGroup::Chunk odd = ArenaAllocator::osAllocChunk_(100 * K, false, false);
+    grp.release(std::move(odd));
+    ArenaGroup::Chunk big = grp.acquire(200 * K, false, false);
+    if (big.size < 200 * K || grp.stats().os_allocs != 1)
+    {
+        std::cerr << "undersized cached slab handed out\n";
+        std::abort();
+    }
+    grp.release(std::move(big));
+
+    // oversize chunks are never cached
+    ArenaGroup::Chunk huge = grp.acquire(1024 * K, false, false);
+    grp.release(std::move(huge));
+    ArenaGroup::Stats s = grp.stats();
+    if (s.cached_slabs != 2 || s.overflow_frees != 1)
+    {
+        std::cerr << "oversize chunk cached\n";
+        std::abort();
+    }
+
+    // per-bin cap: the third release of a class goes back to the OS
+    std::vector<ArenaGroup::Chunk> held;
+    for (int i = 0; i < 3; ++i)
+        held.push_back(grp.acquire(64 * K, false, false));
+    for (auto &c : held)
+        grp.release(std::move(c));
+    held.clear();
+    s = grp.stats();
+    if (s.bins[0].cached > go.max_slabs_per_bin * go.shards || s.overflow_frees < 2)
+    {
+        std::cerr << "per-bin cap not enforced\n";
+        std::abort();
+    }
+
+    // idle trim
+    if (grp.trimIdle(std::chrono::milliseconds(0)) == 0 || grp.stats().cached_slabs != 0)
+    {
+        std::cerr << "trimIdle left slabs behind\n";
+        std::abort();
+    }
+    ArenaGroupOptions ttl = go;
+    ttl.trim_after = std::chrono::milliseconds(1);
+    ArenaGroup aging(ttl);
+    aging.release(aging.acquire(64 * K, false, false));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    aging.release(ArenaAllocator::osAllocChunk_(64 * K, false, false)); // sweeps the stale one
+    if (aging.stats().bins[0].cached != 1 || aging.stats().trimmed_bytes < 64 * K)
+    {
+        std::cerr << "trim_after did not free the cold slab\n";
+        std::abort();
+    }
+
+    // all threads release then re-acquire together (session roll)
+    ArenaGroupOptions wide;
+    wide.max_slabs_per_bin = 0;
+    ArenaGroup shared(wide);
+    constexpr int THREADS = 8;
+    constexpr int ROUNDS = 200;
+    std::vector<std::thread> ths;
+    for (int t = 0; t < THREADS; ++t)
+    {
+        ths.emplace_back([&, t]
+                         {
+            ArenaGroup::Chunk c = shared.acquire(64 * K, false, false);
+            for (int r = 0; r < ROUNDS; ++r) {
+                static_cast<unsigned char *>(c.base)[0] = static_cast<unsigned char>(t);
+                shared.release(std::move(c));
+                c = shared.acquire(64 * K, false, false);
+                if (!c.base || c.size < 64 * K) { std::cerr << "concurrent acquire failed\n"; std::abort(); }
+            }
+            shared.release(std::move(c)); });
+    }
+    for (auto &th : ths)
+        th.join();
+    s = shared.stats();
+    if (s.checked_out_bytes != 0 || s.reuse_hits + s.os_allocs != static_cast<std::uint64_t>(THREADS) * (ROUNDS + 1) ||
+        s.cached_slabs != s.os_allocs)
+    {
+        std::cerr << "sharded recycler lost track of slabs\n";
+        std::abort();
+    }
+}
+
+static void test_mark_rewind()
+{
+    std::cout << "[J] mark/rewind + ArenaScope\n";
+    for (bool headerless : {false, true})
+    {
+        ArenaOptions opts;
+        opts.initial_chunk_size = 4096;
+        opts.max_chunk_size = 64 * 1024;
+        opts.headerless = headerless;
+        ArenaAllocator arena(opts);
+
+        auto *keep = static_cast<std::uint64_t *>(arena.allocate(sizeof(std::uint64_t) * 16));
+        for (int i = 0; i < 16; ++i)
+            keep[i] = 0xC0FFEEu + i;
+
+        const ArenaAllocator::Marker m = arena.mark();
+        void *firstTemp = arena.allocate(128);
+        arena.rewind(m);
+        if (arena.allocate(128) != firstTemp)
+        {
+            std::cerr << "rewind did not restore the offset\n";
+            std::abort();
+        }
+        arena.rewind(m);
+
+        // temporaries spill into new chunks; the scope hands them back as spares
+        const std::size_t chunksBefore = arena.chunkCount();
+        {
+            ArenaScope scope(arena);
+            for (int i = 0; i < 200; ++i)
+                std::memset(scope.arena().allocate(512), 0xEE, 512);
+            if (arena.chunkCount() <= chunksBefore)
+            {
+                std::cerr << "scope never grew the arena\n";
+                std::abort();
+            }
+        }
+        const std::size_t spares = arena.spareChunkCount();
+        if (arena.chunkCount() != chunksBefore || spares == 0)
+        {
+            std::cerr << "ArenaScope did not rewind the chunk index\n";
+            std::abort();
+        }
+        for (int i = 0; i < 16; ++i)
+        {
+            if (keep[i] != 0xC0FFEEu + static_cast<std::uint64_t>(i))
+            {
+                std::cerr << "rewind clobbered data from before the mark\n";
+                std::abort();
+            }
+        }
+
+        // the same workload again reuses the spares instead of growing
+        {
+            ArenaScope scope(arena);
+            for (int i = 0; i < 200; ++i)
+                (void)arena.allocate(512);
+            if (arena.spareChunkCount() >= spares)
+            {
+                std::cerr << "spare chunks not reused\n";
+                std::abort();
+            }
+        }
+        {
+            ArenaScope scope(arena, /*keepChunks=*/false);
+            for (int i = 0; i < 400; ++i)
+                (void)arena.allocate(512);
+        }
+        if (arena.chunkCount() != chunksBefore)
+        {
+            std::cerr << "rewind without keep left chunks active\n";
+            std::abort();
+        }
+
+        // nested scopes unwind innermost first
+        {
+            ArenaScope outer(arena);
+            void *a = arena.allocate(64);
+            {
+                ArenaScope inner(arena);
+                (void)arena.allocate(64);
+            }
+            if (static_cast<char *>(arena.allocate(64)) <= static_cast<char *>(a))
+            {
+                std::cerr << "inner scope rewound past the outer allocation\n";
+                std::abort();
+            }
+        }
+        if (arena.verify())
+        {
+            std::cerr << "verify failed after rewinds\n";
+            std::abort();
+        }
+
+        // markers outlived by reset()/release(), or by a rewind to before them
+        const ArenaAllocator::Marker gone = arena.mark();
+        const bool afterReset = aborts_in_child([&]
+                                                { arena.reset(); arena.rewind(gone); });
+        const bool afterRelease = aborts_in_child([&]
+                                                  { arena.release(); arena.rewind(gone); });
+        const bool afterOuter = aborts_in_child([&]
+                                                {
+            const ArenaAllocator::Marker outer = arena.mark();
+            (void)arena.allocate(64);
+            const ArenaAllocator::Marker inner = arena.mark();
+            (void)arena.allocate(64);
+            arena.rewind(outer);
+            (void)arena.allocate(256); // reuses what inner pointed past
+            arena.rewind(inner); });
+        if (!afterReset || !afterRelease || !afterOuter)
+        {
+            std::cerr << "rewind accepted an invalidated marker\n";
+            std::abort();
+        }
+        {
+            // marks at the same spot survive each other's rewinds
+            const ArenaAllocator::Marker a = arena.mark();
+            const ArenaAllocator::Marker b = arena.mark();
+            (void)arena.allocate(64);
+            arena.rewind(a);
+            arena.rewind(b);
+            arena.rewind(a);
+        }
+        arena.release();
+    }
+}
+
+static void test_pad_to()
+{
+    std::cout << "[K] pad_to: one cache line per object\n";
+    for (bool headerless : {false, true})
+    {
+        ArenaOptions opts;
+        opts.initial_chunk_size = 4096;
+        opts.headerless = headerless;
+        opts.pad_to = 48; // rounds to 64
+        ArenaAllocator arena(opts);
+        std::uintptr_t prevLine = 0;
+        for (int i = 0; i < 200; ++i) // crosses into new chunks
+        {
+            auto *p = static_cast<char *>(arena.allocate(1 + i % 40, 8));
+            const auto a = reinterpret_cast<std::uintptr_t>(p);
+            if (a % 64 != 0)
+            {
+                std::cerr << "pad_to allocation not line aligned\n";
+                std::abort();
+            }
+            if (a / 64 == prevLine)
+            {
+                std::cerr << "two padded allocations share a cache line\n";
+                std::abort();
+            }
+            std::memset(p, i, 64); // the padding belongs to the object
+            prevLine = a / 64;
+        }
+        if (!headerless && arena.verify())
+        {
+            std::cerr << "verify failed with pad_to\n";
+            std::abort();
+        }
+        // rounding SIZE_MAX - 10 up to 64 would wrap to 0 bytes
+        bool threw = false;
+        try
+        {
+            arena.allocate(SIZE_MAX - 10);
+        }
+        catch (const std::bad_alloc &)
+        {
+            threw = true;
+        }
+        if (!threw)
+        {
+            std::cerr << "pad_to rounding wrapped an oversized request\n";
+            std::abort();
+        }
+    }
+}
+
+static void test_trim()
+{
+    std::cout << "[L] trim: arena tail chunks, group byte cap and decay, background trimmer\n";
+    constexpr std::size_t K = 1024;
+    for (bool headerless : {false, true})
+    {
+        ArenaOptions opts;
+        opts.initial_chunk_size = 16 * K;
+        opts.max_chunk_size = 256 * K;
+        opts.headerless = headerless;
+        ArenaAllocator arena(opts);
+        for (int i = 0; i < 64; ++i) // market-open spike: several chunks
+            std::memset(arena.allocate(8 * K), i, 8 * K);
+        const std::size_t peakChunks = arena.chunkCount();
+        std::size_t largest = 0;
+        for (std::size_t i = 0; i < peakChunks; ++i)
+            largest = std::max(largest, arena.chunkAt(i).size);
+        if (peakChunks < 3 || arena.trim() != 0 || arena.chunkCount() != peakChunks)
+        {
+            std::cerr << "trim dropped chunks that hold live data\n";
+            std::abort();
+        }
+        arena.reset();
+        if (arena.trim() == 0 || arena.chunkCount() != 1 || arena.chunkAt(0).size != largest)
+        {
+            std::cerr << "trim after reset should keep only the largest chunk\n";
+            std::abort();
+        }
+        void *p = arena.allocate(8 * K);
+        if (!p || arena.chunkCount() != 1)
+        {
+            std::cerr << "the kept chunk is not the current one\n";
+            std::abort();
+        }
+    }
+
+    // trim_on_reset hands the tail to the group
+    ArenaGroupOptions go;
+    go.max_slabs_per_bin = 0;
+    ArenaGroup grp(go);
+    ArenaOptions opts;
+    opts.initial_chunk_size = 64 * K;
+    opts.max_chunk_size = 256 * K;
+    opts.trim_on_reset = true;
+    {
+        ArenaAllocator arena(opts, &grp);
+        for (int i = 0; i < 40; ++i)
+            arena.allocate(16 * K);
+        const std::size_t chunks = arena.chunkCount();
+        arena.reset();
+        if (arena.chunkCount() != 1 || grp.stats().cached_slabs != chunks - 1)
+        {
+            std::cerr << "trim_on_reset did not return the tail chunks to the group\n";
+            std::abort();
+        }
+    }
+
+    // byte cap across all bins: releases past it go straight back to the OS
+    ArenaGroupOptions capped;
+    capped.max_slabs_per_bin = 0;
+    capped.max_cached_bytes = 256 * K;
+    ArenaGroup small(capped);
+    std::vector<ArenaGroup::Chunk> held;
+    for (int i = 0; i < 8; ++i)
+        held.push_back(small.acquire(64 * K, false, false));
+    for (auto &c : held)
+        small.release(std::move(c));
+    held.clear();
+    ArenaGroup::Stats s = small.stats();
+    if (s.cached_bytes > capped.max_cached_bytes || s.cached_slabs != 4 || s.overflow_frees != 4)
+    {
+        std::cerr << "max_cached_bytes not enforced\n";
+        std::abort();
+    }
+    held.push_back(small.acquire(64 * K, false, false)); // out of the cache and back in
+    small.release(std::move(held.back()));
+    held.clear();
+    if (small.stats().cached_slabs != 4)
+    {
+        std::cerr << "cap accounting drifted across acquire/release\n";
+        std::abort();
+    }
+
+    // trim_after also decays on acquire, without any release
+    ArenaGroupOptions ttl;
+    ttl.trim_after = std::chrono::milliseconds(1);
+    ArenaGroup aging(ttl);
+    aging.release(aging.acquire(64 * K, false, false));
+    aging.release(aging.acquire(1024 * K, false, false));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ArenaGroup::Chunk c = aging.acquire(256 * K, false, false);
+    if (aging.stats().cached_slabs != 0 || aging.stats().trimmed_bytes < (64 + 1024) * K)
+    {
+        std::cerr << "acquire did not expire idle slabs\n";
+        std::abort();
+    }
+    aging.release(std::move(c));
+
+    // background decay
+    ArenaGroup bg;
+    bg.release(bg.acquire(64 * K, false, false));
+    MemoryTrimmer trimmer(std::chrono::milliseconds(1));
+    trimmer.add("arena-group", [&]
+                { return bg.trimIdle(std::chrono::milliseconds(0)); });
+    trimmer.start();
+    for (int i = 0; i < 2000 && bg.stats().cached_slabs != 0; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    trimmer.stop();
+    if (bg.stats().cached_slabs != 0 || trimmer.trimmedBytes() < 64 * K || trimmer.stats()[0].runs == 0 ||
+        trimmer.running())
+    {
+        std::cerr << "background trimmer did not decay the group\n";
+        std::abort();
+    }
+    if (trimmer.runOnce() != 0)
+    {
+        std::cerr << "nothing left to trim\n";
+        std::abort();
+    }
+}
+
 int main()
 {
     std::cout << "\n==== arenaAllocatorTest ====\n";
@@ -210,6 +960,14 @@ int main()
     test_growth_and_reset();
     test_thread_local_arena();
     test_arena_group_recycler();
+    test_huge_page_backing();
+    test_guards_and_canaries();
+    test_balancer();
+    test_headerless();
+    test_sharded_group();
+    test_mark_rewind();
+    test_pad_to();
+    test_trim();
     std::cout << "[OK] arenaAllocatorTest passed.\n";
     return 0;
 }
@@ -0,0 +1,159 @@
+#include "allocators/basicArena.hpp"
+#include "allocators/basicPool.hpp"
+
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <type_traits>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+static void require(bool cond, const char *msg)
+{
+    if (!cond)
+    {
+        std::cerr << "[TEST] " << msg << "\n";
+        std::abort();
+    }
+}
+
+static void test_minimal()
+{
+    std::cout << "[A] MinimalPool: pop/push, no per-object state\n";
+    static_assert(sizeof(MinimalPool) == sizeof(BasicPool<alloc_policy::Zero>),
+                  "empty policies must not add storage");
+    MinimalPool pool(24, 128);
+    require(pool.objectSize() == 32, "A: block size rounds to max_align_t");
+
+    std::vector<void *> live;
+    for (int i = 0; i < 128; ++i)
+    {
+        void *p = pool.allocate();
+        require(p && pool.owns(p), "A: allocate failed");
+        require(reinterpret_cast<std::uintptr_t>(p) % alignof(std::max_align_t) == 0, "A: misaligned block");
+        live.push_back(p);
+    }
+    require(pool.allocate() == nullptr, "A: allocated past capacity");
+    require(std::set<void *>(live.begin(), live.end()).size() == live.size(), "A: duplicate blocks");
+    require(pool.getStats().untouched == 0, "A: bump cursor not exhausted");
+
+    void *last = live.back();
+    pool.deallocate(last);
+    require(pool.allocate() == last, "A: LIFO reuse");
+    for (void *p : live)
+        pool.deallocate(p);
+
+    void *bulk[200];
+    require(pool.allocateBulk(bulk, 200) == 128, "A: bulk returns what is available");
+    pool.deallocateBulk(bulk, 128);
+    require(pool.getStats().alloc_calls == 0, "A: minimal pool keeps no counters");
+}
+
+static void test_counters_and_hooks()
+{
+    std::cout << "[B] Counters + FunctionHooks + OccupancyHistogram\n";
+    using Pool = BasicPool<alloc_policy::Counters, alloc_policy::FunctionHooks, alloc_policy::OccupancyHistogram<8>>;
+    Pool pool(64, 16);
+    int allocs = 0;
+    int frees = 0;
+    pool.policy<alloc_policy::FunctionHooks>().on_alloc = [&](void *, std::size_t sz)
+    {
+        require(sz == 64, "B: hook block size");
+        ++allocs;
+    };
+    pool.policy<alloc_policy::FunctionHooks>().on_free = [&](void *, std::size_t)
+    { ++frees; };
+
+    std::vector<void *> live;
+    for (int i = 0; i < 20; ++i)
+        live.push_back(pool.allocate());
+    for (void *p : live)
+        pool.deallocate(p); // trailing nullptrs are ignored
+
+    const PoolStats s = pool.getStats();
+    require(s.alloc_calls == 20 && s.alloc_failures == 4, "B: alloc counters");
+    require(s.free_calls == 16 && s.in_use == 0 && s.high_watermark == 16, "B: free counters");
+    require(allocs == 16 && frees == 16, "B: hooks");
+
+    const Histogram *h = pool.policy<alloc_policy::OccupancyHistogram<8>>().histogram();
+    require(h != nullptr, "B: histogram attached");
+    std::uint64_t samples = 0;
+    for (auto c : h->snapshot().counts)
+        samples += c;
+    require(samples == 32, "B: one occupancy sample per alloc/free");
+}
+
+static void test_debug_strong()
+{
+    std::cout << "[C] DebugStrongPool: poison, zero, quarantine\n";
+    DebugStrongPool pool(64, 256);
+    auto *p = static_cast<unsigned char *>(pool.allocate());
+    for (int i = 0; i < 64; ++i)
+        require(p[i] == 0, "C: block not zeroed");
+    std::memset(p, 0x11, 64);
+    pool.deallocate(p);
+    for (int i = sizeof(void *); i < 64; ++i)
+        require(p[i] == 0xA5, "C: freed block not poisoned");
+
+    // quarantined: the next 64 frees must not hand p back
+    std::vector<void *> live;
+    for (int i = 0; i < 64; ++i)
+    {
+        void *q = pool.allocate();
+        require(q != p, "C: quarantined block reused");
+        live.push_back(q);
+    }
+    for (void *q : live)
+        pool.deallocate(q);
+
+    // write after free is caught when the block comes back
+    int status = 0;
+    std::cout.flush();
+    const pid_t bad = ::fork();
+    if (bad == 0)
+    {
+        BasicPool<alloc_policy::Poison<>> child(64, 4);
+        auto *b = static_cast<unsigned char *>(child.allocate());
+        child.deallocate(b);
+        b[40] = 0; // use after free
+        (void)child.allocate();
+        _exit(0);
+    }
+    ::waitpid(bad, &status, 0);
+    require(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT, "C: poison violation not detected");
+}
+
+static void test_basic_arena()
+{
+    std::cout << "[D] BasicArena: headerless bump + policies\n";
+    ArenaOptions ao;
+    ao.initial_chunk_size = 4096;
+    MinimalArena raw(ao);
+    require(raw.arena().options().headerless, "D: BasicArena must force headerless");
+    auto *a = static_cast<char *>(raw.allocate(16, 16));
+    auto *b = static_cast<char *>(raw.allocate(16, 16));
+    require(b == a + 16, "D: blocks not packed");
+
+    BasicArena<alloc_policy::Counters> counted(ao);
+    for (int i = 0; i < 1000; ++i)
+        *counted.construct<std::uint64_t>(static_cast<std::uint64_t>(i)) += 1;
+    require(counted.policy<alloc_policy::Counters>().alloc_calls == 1000, "D: arena counters");
+    require(counted.chunkCount() > 1, "D: arena did not grow");
+    counted.reset();
+    require(counted.policy<alloc_policy::Counters>().in_use == 0, "D: reset hook");
+}
+
+int main()
+{
+    std::cout << "\n==== basicPoolTest ====\n";
+    test_minimal();
+    test_counters_and_hooks();
+    test_debug_strong();
+    test_basic_arena();
+    std::cout << "[OK] basicPoolTest passed.\n";
+    return 0;
+}
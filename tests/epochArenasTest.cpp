@@ -0,0 +1,163 @@
+#include "allocators/epochArenas.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static void require(bool cond, const char *msg)
+{
+    if (!cond)
+    {
+        std::cerr << "[TEST] " << msg << "\n";
+        std::abort();
+    }
+}
+
+static EpochArenasOptions smallArenas()
+{
+    EpochArenasOptions o;
+    o.arena.initial_chunk_size = 16 << 10;
+    o.arena.headerless = true;
+    o.arena.register_stats = false;
+    o.max_readers = 8;
+    return o;
+}
+
+static void test_recycle()
+{
+    std::cout << "[A] no readers: a retired arena is reset and handed out again\n";
+    ArenaGroup group;
+    EpochArenasOptions o = smallArenas();
+    o.max_cached_arenas = 1;
+    EpochArenas epochs(group, o);
+
+    auto a = epochs.acquire();
+    ArenaAllocator *first = a.get();
+    require(a->allocate(1000) != nullptr, "A: allocate");
+    const std::uint64_t e0 = epochs.epoch();
+    epochs.retire(std::move(a));
+    require(epochs.epoch() == e0 + 1, "A: retire did not advance the epoch");
+    auto s = epochs.stats();
+    require(s.pending == 0 && s.reclaimed == 1 && s.cached == 1, "A: unpinned retire not reclaimed");
+
+    auto b = epochs.acquire();
+    require(b.get() == first && b->allocate(16) == b->chunkAt(0).base, "A: cached arena not reused / not reset");
+    auto c = epochs.acquire(); // cache empty: a fresh arena
+    epochs.retire(std::move(b));
+    epochs.retire(std::move(c)); // over max_cached_arenas: released to the group
+    s = epochs.stats();
+    require(s.created == 2 && s.reused == 1 && s.cached == 1 && s.released == 1, "A: cache cap");
+    require(group.stats().cached_slabs >= 1, "A: released arena's chunk not back in the group");
+}
+
+static void test_pinned_reader()
+{
+    std::cout << "[B] a pinned reader holds back arenas retired at or after its epoch\n";
+    ArenaGroup group;
+    EpochArenas epochs(group, smallArenas());
+
+    auto old = epochs.acquire();
+    auto pin = epochs.pin();
+    require(pin && pin.epoch() == epochs.epoch() && epochs.stats().pinned == 1, "B: pin");
+    epochs.retire(std::move(old));
+    require(epochs.stats().pending == 1 && epochs.reclaim() == 0, "B: reclaimed under a pinned reader");
+
+    {
+        auto late = epochs.pin(); // pinned after the retire: cannot see the old arena
+        require(late.epoch() > pin.epoch() && epochs.stats().pinned == 2, "B: nested pin");
+        EpochArenas::Guard moved = std::move(late);
+        require(!late && moved, "B: guard move");
+    }
+    require(epochs.stats().pinned == 1 && epochs.reclaim() == 0, "B: late reader changed the outcome");
+
+    auto second = epochs.acquire();
+    pin.unpin();
+    auto late = epochs.pin();
+    epochs.retire(std::move(second)); // stamped with the epoch `late` pinned
+    require(epochs.stats().pending == 1, "B: first arena should be reclaimed, second held");
+    late.unpin();
+    epochs.drain();
+    const auto s = epochs.stats();
+    require(s.pending == 0 && s.reclaimed == 2 && s.pinned == 0, "B: drain");
+}
+
+struct Book
+{
+    std::uint64_t seq = 0;
+    std::uint32_t levels = 0;
+    std::uint64_t *px = nullptr; // second allocation in the same arena
+};
+
+static void test_snapshots()
+{
+    std::cout << "[C] snapshots published to readers, arenas recycled under them\n";
+    ArenaGroup group;
+    EpochArenas epochs(group, smallArenas());
+    constexpr std::uint32_t kLevels = 256;
+    constexpr int kReaders = 3;
+    constexpr std::uint64_t kPublishes = 5000;
+
+    auto build = [&](ArenaAllocator &arena, std::uint64_t seq)
+    {
+        auto *b = arena.construct<Book>();
+        require(b != nullptr, "C: arena allocate");
+        b->seq = seq;
+        b->levels = kLevels;
+        b->px = static_cast<std::uint64_t *>(arena.allocate(kLevels * sizeof(std::uint64_t), alignof(std::uint64_t)));
+        for (std::uint32_t i = 0; i < kLevels; ++i)
+            b->px[i] = seq * 1000 + i;
+        return b;
+    };
+
+    auto arena = epochs.acquire();
+    std::atomic<Book *> current{build(*arena, 1)};
+    std::atomic<bool> done{false};
+    std::atomic<std::uint64_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < kReaders; ++r)
+        readers.emplace_back([&]
+                             {
+                                 std::uint64_t last = 0;
+                                 while (!done.load(std::memory_order_relaxed))
+                                 {
+                                     auto pin = epochs.pin();
+                                     const Book *b = current.load(std::memory_order_acquire);
+                                     require(b->seq >= last && b->levels == kLevels, "C: snapshot went backwards");
+                                     for (std::uint32_t i = 0; i < kLevels; ++i)
+                                         require(b->px[i] == b->seq * 1000 + i, "C: snapshot recycled under a reader");
+                                     last = b->seq;
+                                     reads.fetch_add(1, std::memory_order_relaxed);
+                                 } });
+
+    for (std::uint64_t seq = 2; seq <= kPublishes; ++seq)
+    {
+        auto next = epochs.acquire();
+        current.store(build(*next, seq), std::memory_order_release);
+        epochs.retire(std::move(arena));
+        arena = std::move(next);
+        if (seq % 64 == 0)
+            std::this_thread::yield();
+    }
+    done = true;
+    for (auto &t : readers)
+        t.join();
+    epochs.drain();
+
+    const auto s = epochs.stats();
+    require(reads.load() > 0, "C: readers never ran");
+    require(s.retired == kPublishes - 1 && s.reclaimed == s.retired, "C: retired arenas not all reclaimed");
+    require(s.reused > 0 && s.created + s.reused == kPublishes, "C: arenas were not recycled");
+}
+
+int main()
+{
+    std::cout << "\n==== epochArenasTest ====\n";
+    test_recycle();
+    test_pinned_reader();
+    test_snapshots();
+    std::cout << "[OK] epochArenasTest passed.\n";
+    return 0;
+}
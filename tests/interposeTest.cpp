@@ -0,0 +1,319 @@
+// Runs unmodified programs with libfinalloc_malloc.so preloaded (a sanitized
+// build of this binary could not load the interposer itself) and checks their
+// output and the interposer's exit-time stats.
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+static void require(bool cond, const char *msg)
+{
+    if (!cond)
+    {
+        std::cerr << "[TEST] " << msg << "\n";
+        std::abort();
+    }
+}
+
+// `make tests` points FINALLOC_MALLOC_SO at the profile's interposer
+static const char *kLib = std::getenv("FINALLOC_MALLOC_SO") ? std::getenv("FINALLOC_MALLOC_SO")
+                                                            : "lib/release/libfinalloc_malloc.so";
+
+// absolute, so children that change directory still find it
+static std::string libPath()
+{
+    if (kLib[0] == '/')
+        return kLib;
+    char cwd[4096];
+    return std::string(::getcwd(cwd, sizeof(cwd)) ? cwd : ".") + "/" + kLib;
+}
+
+static std::string tmpPath(const char *tag)
+{
+    return "/tmp/finalloc-interpose-" + std::string(tag) + "-" + std::to_string(::getpid());
+}
+
+static std::string slurp(const std::string &path)
+{
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// exit status of `cmd` run with the interposer preloaded and its stats sent to statsPath
+static int runPreloaded(const std::string &cmd, const std::string &statsPath)
+{
+    const std::string full = "LD_PRELOAD=" + libPath() + " FINALLOC_STATS=" + statsPath + " " + cmd;
+    const int rc = std::system(full.c_str());
+    return WIFEXITED(rc) ? WEXITSTATUS(rc) : 128;
+}
+
+// sum of one metric over the interposer's pools in a stats dump
+static std::uint64_t metricSum(const std::string &stats, const std::string &metric)
+{
+    std::uint64_t total = 0;
+    std::istringstream in(stats);
+    std::string line;
+    const std::string prefix = "finalloc_" + metric + "{";
+    while (std::getline(in, line))
+    {
+        if (line.rfind(prefix, 0) != 0 || line.find("name=\"malloc\"") == std::string::npos)
+            continue;
+        total += std::stoull(line.substr(line.rfind(' ') + 1));
+    }
+    return total;
+}
+
+// compiles `source` (unsanitized, so it can run with the interposer preloaded)
+// to a temporary binary and returns its path
+static std::string buildHelper(const char *tag, const std::string &source)
+{
+    const std::string src = tmpPath((std::string(tag) + ".cpp").c_str());
+    const std::string bin = tmpPath(tag);
+    std::ofstream(src) << source;
+    const std::string build = "g++ -x c++ -std=c++20 -O2 -pthread " + src + " -o " + bin;
+    const bool ok = std::system(build.c_str()) == 0;
+    std::remove(src.c_str());
+    require(ok, "could not build a test helper");
+    return bin;
+}
+
+static void test_sort()
+{
+    std::cout << "[A] sort(1): C allocation API, output identical\n";
+    const std::string in = tmpPath("in");
+    const std::string out = tmpPath("out");
+    const std::string stats = tmpPath("stats");
+    std::vector<std::string> lines;
+    std::mt19937_64 rng(42);
+    {
+        std::ofstream f(in);
+        for (int i = 0; i < 200000; ++i)
+        {
+            // mixed lengths: small pool classes, the largest ones and mmap'd lines
+            std::string s = std::to_string(rng()) + std::string(rng() % 64 == 0 ? 9000 : rng() % 300, 'x');
+            lines.push_back(s);
+            f << s << '\n';
+        }
+    }
+    std::sort(lines.begin(), lines.end());
+    require(runPreloaded("LC_ALL=C sort --parallel=4 -S 4M " + in + " > " + out, stats) == 0, "A: sort failed");
+    std::string expect;
+    for (const auto &s : lines)
+        expect += s + '\n';
+    require(slurp(out) == expect, "A: sorted output differs");
+    const std::string dump = slurp(stats);
+    require(dump.find("# finalloc malloc:") != std::string::npos, "A: interposer did not run");
+    require(metricSum(dump, "alloc_calls_total") > 0, "A: no allocation went through the pools");
+    std::remove(in.c_str());
+    std::remove(out.c_str());
+    std::remove(stats.c_str());
+}
+
+static void test_compiler()
+{
+    std::cout << "[B] g++ -fsyntax-only: a large C++ program on the interposer\n";
+    const std::string stats = tmpPath("stats-cxx");
+    // -wrapper preloads cc1plus only: the driver would overwrite its stats file at exit
+    const std::string cmd = "g++ -wrapper env,LD_PRELOAD=" + libPath() + ",FINALLOC_STATS=" + stats +
+                            " -std=c++20 -fsyntax-only -Iinclude tests/allocStatsTest.cpp";
+    require(std::system(cmd.c_str()) == 0, "B: compiler failed under the interposer");
+    const std::string dump = slurp(stats);
+    require(metricSum(dump, "alloc_calls_total") > 1000, "B: compiler allocations bypassed the pools");
+    require(metricSum(dump, "alloc_failures_total") == 0, "B: pool allocation failures");
+    std::remove(stats.c_str());
+}
+
+static void test_python()
+{
+    std::cout << "[C] python3 threads: cross-thread frees and realloc\n";
+    if (std::system("command -v python3 > /dev/null 2>&1") != 0)
+    {
+        std::cout << "    python3 not found, skipped\n";
+        return;
+    }
+    const std::string stats = tmpPath("stats-py");
+    const std::string script =
+        "import json, threading, queue\n"
+        "q = queue.Queue()\n"
+        "def make():\n"
+        "    for i in range(20000):\n"
+        "        q.put(bytearray(i % 20000))\n"
+        "    q.put(None)\n"
+        "def eat():\n"
+        "    while q.get() is not None:\n"
+        "        pass\n"
+        "ts = [threading.Thread(target=f) for f in (make, eat)]\n"
+        "[t.start() for t in ts]\n"
+        "[t.join() for t in ts]\n"
+        "d = [{'k': i, 'v': str(i) * (i % 50)} for i in range(100000)]\n"
+        "s = ''\n"
+        "for i in range(2000):\n"
+        "    s += 'y' * 37\n"
+        "assert json.loads(json.dumps(d)) == d and len(s) == 74000\n";
+    const std::string path = tmpPath("script.py");
+    std::ofstream(path) << script;
+    require(runPreloaded("python3 " + path, stats) == 0, "C: python failed under the interposer");
+    const std::string dump = slurp(stats);
+    require(metricSum(dump, "free_calls_total") > 0, "C: no frees reached the pools");
+    std::remove(path.c_str());
+    std::remove(stats.c_str());
+}
+
+static void test_fork()
+{
+    std::cout << "[D] fork() while other threads allocate: the child can still allocate\n";
+    const std::string stats = tmpPath("stats-fork");
+    // workers keep growing size classes and registering new threads' magazines,
+    // the main thread forks; a child that inherited a held lock hangs until SIGALRM
+    const std::string bin = buildHelper("fork", R"(#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static std::atomic<bool> g_stop{false};
+
+static void churn(unsigned seed)
+{
+    std::vector<void *> held;
+    for (unsigned round = 0; !g_stop.load(std::memory_order_relaxed); ++round)
+    {
+        const std::size_t size = 8 + (seed * 131 + round * 977) % 9000;
+        for (int i = 0; i < 2000; ++i)
+            held.push_back(std::malloc(size));
+        for (void *p : held)
+            std::free(p);
+        held.clear();
+        std::thread([size] { std::free(std::malloc(size)); }).join(); // fresh thread: new magazines
+    }
+}
+
+int main()
+{
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < 3; ++t)
+        workers.emplace_back(churn, t);
+    int bad = 0;
+    for (int i = 0; i < 200; ++i)
+    {
+        const pid_t pid = fork();
+        if (pid == 0)
+        {
+            alarm(10);
+            std::vector<void *> v;
+            for (std::size_t size = 8; size <= 20000; size += 40)
+                v.push_back(std::malloc(size));
+            std::thread([] { std::free(std::malloc(4096)); }).join();
+            for (void *p : v)
+                std::free(p);
+            if (i % 2)
+                _exit(0);
+            std::exit(0); // runs the interposer's exit-time stats dump too
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        bad += !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+    g_stop = true;
+    for (auto &w : workers)
+        w.join();
+    return bad == 0 ? 0 : 1;
+}
+)");
+    require(runPreloaded(bin, stats) == 0, "D: a child deadlocked or failed after fork()");
+    require(metricSum(slurp(stats), "alloc_calls_total") > 0, "D: interposer did not run");
+    std::remove(bin.c_str());
+    std::remove(stats.c_str());
+}
+
+static void test_foreign()
+{
+    std::cout << "[E] pointers from another allocator go back to it; large blocks realloc in place or move\n";
+    const std::string stats = tmpPath("stats-foreign");
+    const std::string bin = buildHelper("foreign", R"(#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+
+extern "C" void *__libc_malloc(std::size_t); // glibc's own malloc, behind the interposer
+
+static bool filled(const char *p, std::size_t n, char c)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        if (p[i] != c)
+            return false;
+    return true;
+}
+
+int main()
+{
+    // foreign: usable size, realloc past the interposer's largest class, free
+    for (std::size_t n : {24, 4000, 300000})
+    {
+        char *p = static_cast<char *>(__libc_malloc(n));
+        std::memset(p, 'f', n);
+        if (malloc_usable_size(p) < n)
+            return 1;
+        p = static_cast<char *>(std::realloc(p, 100000));
+        if (!p || !filled(p, std::min<std::size_t>(n, 100000), 'f'))
+            return 2;
+        std::free(p);
+    }
+    // ours: grow inside the reservation, past it, shrink, then back into a pool
+    char *p = static_cast<char *>(std::malloc(20000));
+    std::memset(p, 'o', 20000);
+    if (malloc_usable_size(p) < 20000)
+        return 3;
+    for (std::size_t n : {std::size_t{60000}, std::size_t{5} << 20, std::size_t{50} << 20})
+    {
+        p = static_cast<char *>(std::realloc(p, n));
+        if (!p || malloc_usable_size(p) < n || !filled(p, 20000, 'o'))
+            return 4;
+        std::memset(p + 20000, 'o', n - 20000);
+    }
+    p = static_cast<char *>(std::realloc(p, 30000));
+    if (!p || !filled(p, 30000, 'o'))
+        return 5;
+    p = static_cast<char *>(std::realloc(p, 100));
+    if (!p || !filled(p, 100, 'o'))
+        return 6;
+    std::free(p);
+    return 0;
+}
+)");
+    require(runPreloaded(bin, stats) == 0, "E: foreign or large block mishandled");
+    const std::string dump = slurp(stats);
+    // the foreign blocks stayed with libc: the only large block freed here is ours
+    require(dump.find(" large_frees 1 ") != std::string::npos, "E: large block not tracked");
+    std::remove(bin.c_str());
+    std::remove(stats.c_str());
+}
+
+int main()
+{
+    std::cout << "\n==== interposeTest ====\n";
+    if (::access(kLib, R_OK) != 0)
+    {
+        std::cout << "[SKIP] " << kLib << " not built (make interpose); interposeTest skipped.\n";
+        return 0;
+    }
+    test_sort();
+    test_compiler();
+    test_python();
+    test_fork();
+    test_foreign();
+    std::cout << "[OK] interposeTest passed.\n";
+    return 0;
+}
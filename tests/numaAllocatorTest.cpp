@@ -0,0 +1,243 @@
+#include "allocators/numaAllocator.hpp"
+#include "utils/osMemory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+static void require(bool cond, const char *msg)
+{
+    if (!cond)
+    {
+        std::cerr << "[TEST] " << msg << "\n";
+        std::abort();
+    }
+}
+
+static void test_topology()
+{
+    std::cout << "[A] topology + affinity registry\n";
+    const auto list = NumaTopology::parseList("0-3,8,10-11\n");
+    require(list == std::vector<int>({0, 1, 2, 3, 8, 10, 11}), "A: cpulist parse");
+
+    const NumaTopology &topo = NumaTopology::instance();
+    require(topo.nodeCount() >= 1, "A: at least one node");
+    for (int node : topo.nodes())
+    {
+        for (int cpu : topo.cpusOf(node))
+            require(topo.nodeOfCpu(cpu) == node, "A: cpu -> node mapping inconsistent");
+    }
+
+    const int node = ThreadAffinityRegistry::refreshCurrent();
+    require(std::find(topo.nodes().begin(), topo.nodes().end(), node) != topo.nodes().end(),
+            "A: current node is not an online node");
+    require(ThreadAffinityRegistry::currentNode() == node, "A: cached node differs from fresh lookup");
+    require(ThreadAffinityRegistry::pinCurrentThread(topo.nodes().front()), "A: pin to first node failed");
+    require(ThreadAffinityRegistry::currentNode() == topo.nodes().front(), "A: pinned thread on wrong node");
+}
+
+static void test_local_placement()
+{
+    std::cout << "[B] pool blocks come from (and are bound to) the local node\n";
+    NumaOptions o;
+    o.object_size = 64;
+    o.objects_per_node = 4096;
+    NumaAllocator numa(o);
+    require(numa.nodeCount() == NumaTopology::instance().nodeCount(), "B: one pool per node");
+
+    const int local = ThreadAffinityRegistry::currentNode();
+    std::vector<void *> live;
+    for (int i = 0; i < 1000; ++i)
+    {
+        void *p = numa.allocate();
+        require(p != nullptr, "B: allocate failed");
+        std::memset(p, 0x5C, 64); // first touch
+        require(numa.nodeOf(p) == local, "B: block not from the local node");
+        live.push_back(p);
+    }
+    // the kernel agrees when it exposes the page's node
+    const int actual = os_memory::nodeOfAddress(live.front());
+    require(actual < 0 || actual == local, "B: page resident on a remote node");
+
+    int stack = 0;
+    require(numa.nodeOf(&stack) == -1, "B: foreign pointer has no node");
+    for (void *p : live)
+        numa.deallocate(p);
+    require(numa.pool(local).getStats().in_use == 0, "B: frees not routed back");
+}
+
+static void test_spill_to_other_nodes()
+{
+    std::cout << "[C] exhausted local node spills to the others\n";
+    NumaOptions o;
+    o.object_size = 32;
+    o.objects_per_node = 64;
+    NumaAllocator numa(o);
+    const std::size_t total = numa.nodeCount() * o.objects_per_node;
+    const int here = ThreadAffinityRegistry::currentNode();
+    std::vector<void *> live;
+    for (std::size_t i = 0; i < total; ++i)
+    {
+        void *p = numa.allocate();
+        require(p != nullptr, "C: spill allocation failed");
+        live.push_back(p);
+    }
+
+    // probing a dry node on the way to a spill is neither a failure nor a local alloc
+    NumaStats st = numa.getStats();
+    std::uint64_t failures = 0;
+    for (const auto &ns : st.nodes)
+    {
+        failures += ns.pool.alloc_failures;
+        const std::uint64_t local = ns.node == here ? o.objects_per_node : 0;
+        require(ns.local_allocs == local, "C: local_allocs after a spill");
+        require(ns.remote_allocs == o.objects_per_node - local, "C: remote_allocs after a spill");
+    }
+    require(failures == 0, "C: spill probes counted as failures");
+    require(st.remote_allocs == total - o.objects_per_node, "C: total remote allocs");
+
+    require(numa.allocate() == nullptr, "C: allocator handed out more than total capacity");
+    st = numa.getStats();
+    failures = 0;
+    for (const auto &ns : st.nodes)
+        failures += ns.pool.alloc_failures;
+    require(failures == 1, "C: a real miss is counted once");
+    require(numa.allocateOnNode(NumaTopology::instance().nodes().front()) == nullptr,
+            "C: allocateOnNode must not spill");
+    require(std::set<void *>(live.begin(), live.end()).size() == total, "C: duplicate blocks");
+    for (void *p : live)
+        numa.deallocate(p);
+}
+
+static void test_threads_and_arenas()
+{
+    std::cout << "[D] concurrent routing + per-node arenas\n";
+    constexpr int THREADS = 4;
+    NumaOptions o;
+    o.object_size = 128;
+    o.objects_per_node = 1 << 14;
+    o.arena.initial_chunk_size = 64 * 1024;
+    NumaAllocator numa(o);
+
+    std::atomic<bool> go{false};
+    std::vector<std::thread> ths;
+    for (int t = 0; t < THREADS; ++t)
+    {
+        ths.emplace_back([&, t]
+                         {
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            std::vector<void*> mine;
+            for (int i = 0; i < 2000; ++i) {
+                void* p = numa.allocate();
+                require(p != nullptr, "D: concurrent allocate failed");
+                std::memset(p, t, 128);
+                mine.push_back(p);
+                if (mine.size() > 64) { numa.deallocate(mine.front()); mine.erase(mine.begin()); }
+            }
+            for (void* p : mine) numa.deallocate(p);
+
+            ArenaAllocator arena = numa.makeArena();
+            for (int i = 0; i < 500; ++i)
+                std::memset(arena.allocate(256), t, 256);
+            const auto& c = arena.chunkAt(0);
+            require(c.use_mmap, "D: node arena chunk should be mmapped");
+            require(c.node < 0 || c.node == numa.arenaGroup().node(), "D: arena chunk bound to another node");
+            arena.release(); });
+    }
+    go.store(true, std::memory_order_release);
+    for (auto &th : ths)
+        th.join();
+
+    for (int node : NumaTopology::instance().nodes())
+        require(numa.pool(node).getStats().in_use == 0, "D: blocks leaked");
+    require(!ThreadAffinityRegistry::snapshot().empty(), "D: registry should list this thread");
+}
+
+static void test_locality_stats()
+{
+    std::cout << "[E] cross-node counters + per-node memory profile\n";
+    const NumaTopology &topo = NumaTopology::instance();
+    const int local = ThreadAffinityRegistry::currentNode();
+
+    std::atomic<int> hookCalls{0};
+    NumaOptions o;
+    o.object_size = 64;
+    o.objects_per_node = 256;
+    o.arena.initial_chunk_size = 64 * 1024;
+    o.on_remote = [&](int threadNode, int memoryNode, bool)
+    {
+        require(threadNode != memoryNode, "E: hook fired for a local event");
+        hookCalls.fetch_add(1, std::memory_order_relaxed);
+    };
+    NumaAllocator numa(o);
+
+    std::vector<void *> live;
+    for (int i = 0; i < 100; ++i)
+        live.push_back(numa.allocate());
+    for (int i = 0; i < 40; ++i)
+        numa.deallocate(live[i]);
+
+    NumaStats s = numa.getStats();
+    require(s.nodes.size() == numa.nodeCount(), "E: one entry per node");
+    require(s.remote_allocs == 0 && s.remote_frees == 0, "E: local traffic counted as remote");
+    require(hookCalls.load() == 0, "E: hook fired without remote traffic");
+    const NumaNodeStats *mine = nullptr;
+    for (const auto &ns : s.nodes)
+    {
+        if (ns.node == local)
+            mine = &ns;
+    }
+    require(mine != nullptr, "E: local node missing");
+    require(mine->local_allocs == 100, "E: local allocs");
+    const std::size_t block = mine->pool.aligned_object_size;
+    require(mine->in_use_bytes == 60 * block, "E: in-use bytes");
+    require(mine->fragmented_bytes == 40 * block, "E: fragmented bytes (touched, free)");
+    require(mine->untouched_bytes == (256 - 100) * block, "E: untouched bytes");
+
+    // arena chunks: checked out while the arena lives, idle once it is released
+    {
+        ArenaAllocator arena = numa.makeArena();
+        arena.allocate(1024);
+        require(numa.arenaGroup().stats().checked_out_bytes > 0, "E: arena chunk not accounted");
+        arena.release();
+    }
+    const ArenaGroup::Stats gs = numa.arenaGroup().stats();
+    require(gs.checked_out_bytes == 0 && gs.cached_slabs >= 1, "E: released chunk should be idle");
+    s = numa.getStats();
+    for (const auto &ns : s.nodes)
+    {
+        if (ns.node == local)
+            require(ns.idle_bytes == gs.cached_bytes, "E: idle bytes");
+    }
+
+    if (topo.nodeCount() > 1)
+    {
+        // block from a remote node, freed from here: one remote alloc + one remote free
+        const int other = topo.nodes().front() == local ? topo.nodes().back() : topo.nodes().front();
+        void *p = numa.allocateOnNode(other);
+        require(p != nullptr, "E: remote allocateOnNode failed");
+        numa.deallocate(p);
+        s = numa.getStats();
+        require(s.remote_allocs == 1 && s.remote_frees == 1, "E: remote traffic not counted");
+        require(hookCalls.load() == 2, "E: hook not called for remote traffic");
+    }
+    for (std::size_t i = 40; i < live.size(); ++i)
+        numa.deallocate(live[i]);
+    require(!s.threads.empty(), "E: thread snapshot empty");
+}
+
+int main()
+{
+    std::cout << "\n==== numaAllocatorTest ====\n";
+    test_topology();
+    test_local_placement();
+    test_spill_to_other_nodes();
+    test_threads_and_arenas();
+    test_locality_stats();
+    std::cout << "[OK] numaAllocatorTest passed.\n";
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include "allocators/pmrAdapters.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static void require(bool cond, const char *msg)
+{
+    if (!cond)
+    {
+        std::cerr << "[TEST] " << msg << "\n";
+        std::abort();
+    }
+}
+
+// counts what reaches the upstream resource
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    int allocs = 0;
+    int frees = 0;
+
+protected:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocs;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        ++frees;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+static bool aligned(const void *p, std::size_t a)
+{
+    return reinterpret_cast<std::uintptr_t>(p) % a == 0;
+}
+
+static void test_arena_resource()
+{
+    std::cout << "[A] ArenaResource: monotonic pmr containers\n";
+    ArenaOptions ao;
+    ao.initial_chunk_size = 4096;
+    ArenaAllocator arena(ao);
+    ArenaResource res(arena);
+    {
+        std::pmr::vector<std::uint64_t> v(&res);
+        for (std::uint64_t i = 0; i < 10000; ++i)
+            v.push_back(i);
+        for (std::uint64_t i = 0; i < 10000; ++i)
+            require(v[i] == i, "A: vector contents");
+
+        std::pmr::unordered_map<int, std::pmr::string> m(&res);
+        for (int i = 0; i < 1000; ++i)
+            m.emplace(i, std::pmr::string("order-with-a-long-client-id-" + std::to_string(i), &res));
+        require(m.size() == 1000 && m.at(517).ends_with("517"), "A: map contents");
+        require(m.at(3).get_allocator().resource() == &res, "A: allocator not propagated to values");
+    }
+    require(arena.chunkCount() > 1, "A: arena did not grow");
+
+    void *p = res.allocate(100, 256);
+    require(aligned(p, 256), "A: over-aligned request");
+    res.deallocate(p, 100, 256); // no-op
+
+    ArenaResource same(arena);
+    ArenaAllocator other(ao);
+    ArenaResource diff(other);
+    require(res == same && !(res == diff), "A: is_equal by arena identity");
+    arena.reset();
+}
+
+static void test_tls_resource()
+{
+    std::cout << "[B] ThreadLocalArenaResource\n";
+    auto *res = ThreadLocalArenaResource::instance();
+    std::pmr::list<int> l(res);
+    for (int i = 0; i < 1000; ++i)
+        l.push_back(i);
+    int expect = 0;
+    for (int x : l)
+        require(x == expect++, "B: list contents");
+    ThreadLocalArenaResource local;
+    require(*res == local, "B: all thread-local arena resources compare equal");
+    require(!(*res == *std::pmr::new_delete_resource()), "B: not equal to new_delete");
+}
+
+static void test_pool_resource()
+{
+    std::cout << "[C] PoolResource: node containers + upstream fallback\n";
+    PoolAllocator pool(64, 16);
+    CountingResource up;
+    PoolResource<> res(pool, &up);
+
+    std::vector<void *> live;
+    for (int i = 0; i < 16; ++i)
+    {
+        void *p = res.allocate(48, alignof(std::max_align_t));
+        require(p >= pool.memory() && p < static_cast<char *>(pool.memory()) + pool.blockSize(), "C: not from pool");
+        live.push_back(p);
+    }
+    require(up.allocs == 0, "C: upstream used while pool had room");
+    void *spill = res.allocate(48, 8); // pool exhausted
+    void *big = res.allocate(4096, 8); // larger than a block
+    void *over = res.allocate(32, 128); // over-aligned
+    require(up.allocs == 3 && aligned(over, 128), "C: fallback requests");
+    res.deallocate(spill, 48, 8);
+    res.deallocate(big, 4096, 8);
+    res.deallocate(over, 32, 128);
+    require(up.frees == 3, "C: fallback frees routed upstream");
+    for (void *p : live)
+        res.deallocate(p, 48, alignof(std::max_align_t));
+    require(pool.getStats().in_use == 0, "C: pool blocks not returned");
+
+    PoolAllocator nodes(64, 4096);
+    PoolResource<> nres(nodes, &up);
+    {
+        std::pmr::list<std::uint64_t> l(&nres);
+        for (std::uint64_t i = 0; i < 2000; ++i)
+            l.push_back(i);
+        require(nodes.getStats().in_use == 2000, "C: list nodes not pooled");
+    }
+    require(nodes.getStats().in_use == 0, "C: list nodes leaked");
+}
+
+static void test_size_class_resource()
+{
+    std::cout << "[D] SizeClassResource: sized deallocation\n";
+    SizeClassPool<> pool(1024, 256);
+    CountingResource up;
+    SizeClassResource<> res(pool, &up);
+    {
+        std::pmr::unordered_map<std::uint64_t, std::uint64_t> book(&res);
+        for (std::uint64_t i = 0; i < 5000; ++i)
+            book[i] = i * 3;
+        for (std::uint64_t i = 0; i < 5000; i += 2)
+            book.erase(i);
+        require(book.size() == 2500 && book.at(4999) == 4999 * 3, "D: map contents");
+        // the bucket array outgrows maxSize and goes upstream
+        require(up.allocs > 0, "D: large bucket array not sent upstream");
+    }
+    require(up.allocs == up.frees, "D: upstream leak");
+
+    for (std::size_t sz : {1, 8, 24, 100, 640, 1024})
+    {
+        void *p = res.allocate(sz, alignof(std::max_align_t));
+        require(aligned(p, alignof(std::max_align_t)), "D: misaligned");
+        res.deallocate(p, sz, alignof(std::max_align_t));
+    }
+    const int before = up.allocs;
+    void *p = res.allocate(0, 1);
+    res.deallocate(p, 0, 1);
+    void *q = res.allocate(64, 64);
+    require(up.allocs == before + 1 && aligned(q, 64), "D: over-aligned request goes upstream");
+    res.deallocate(q, 64, 64);
+    require(up.allocs == up.frees, "D: upstream leak after over-aligned free");
+
+    SizeClassResource<> same(pool);
+    require(res == same, "D: is_equal by pool identity");
+}
+
+int main()
+{
+    std::cout << "\n==== pmrAdaptersTest ====\n";
+    test_arena_resource();
+    test_tls_resource();
+    test_pool_resource();
+    test_size_class_resource();
+    std::cout << "[OK] pmrAdaptersTest passed.\n";
+    return 0;
+}
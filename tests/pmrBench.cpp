@@ -0,0 +1,226 @@
+// tests/pmrBench.cpp
+// pmr containers on FinAlloc resources vs the standard library's own resources.
+//
+//   ./bin/pmrBench --iters=200000 --reps=5
+//   ./bin/pmrBench --workload=book --resources=pool,sizeclass,unsync
+#include "allocators/pmrAdapters.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Opts
+{
+    int iters = 100000;
+    int reps = 3; // best of N
+    std::vector<std::string> workloads{"vector", "book", "list"};
+    std::vector<std::string> resources{"new", "monotonic", "unsync", "arena", "tls", "pool", "sizeclass"};
+};
+
+static bool starts_with(const char *s, const char *pref)
+{
+    return std::strncmp(s, pref, std::strlen(pref)) == 0;
+}
+
+static std::vector<std::string> split_list(const char *s)
+{
+    std::vector<std::string> v;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        if (!item.empty())
+            v.push_back(item);
+    }
+    return v;
+}
+
+static Opts parse(int argc, char **argv)
+{
+    Opts o;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (starts_with(argv[i], "--iters="))
+            o.iters = std::stoi(argv[i] + std::strlen("--iters="));
+        else if (starts_with(argv[i], "--reps="))
+            o.reps = std::max(1, std::stoi(argv[i] + std::strlen("--reps=")));
+        else if (starts_with(argv[i], "--workload="))
+            o.workloads = split_list(argv[i] + std::strlen("--workload="));
+        else if (starts_with(argv[i], "--resources="))
+            o.resources = split_list(argv[i] + std::strlen("--resources="));
+        else
+            std::fprintf(stderr, "ignoring unknown option %s\n", argv[i]);
+    }
+    return o;
+}
+
+struct Order
+{
+    std::uint64_t id;
+    std::int64_t price;
+    std::uint32_t qty;
+    std::uint32_t side;
+};
+
+// --- workloads: each returns a checksum so nothing is optimized away ---
+
+static std::uint64_t run_vector(std::pmr::memory_resource *r, int iters)
+{
+    std::pmr::vector<Order> v(r);
+    for (int i = 0; i < iters; ++i)
+        v.push_back(Order{static_cast<std::uint64_t>(i), i, 1, 0});
+    return v.size() + v.back().id;
+}
+
+// order book churn: insert, then cancel the oldest once the book holds 1024 orders
+static std::uint64_t run_book(std::pmr::memory_resource *r, int iters)
+{
+    std::pmr::unordered_map<std::uint64_t, Order> book(r);
+    book.reserve(2048);
+    std::uint64_t sum = 0;
+    for (int i = 0; i < iters; ++i)
+    {
+        const auto id = static_cast<std::uint64_t>(i);
+        book.emplace(id, Order{id, i, 1, static_cast<std::uint32_t>(i & 1)});
+        if (i >= 1024)
+        {
+            auto it = book.find(id - 1024);
+            sum += it->second.qty;
+            book.erase(it);
+        }
+    }
+    return sum + book.size();
+}
+
+static std::uint64_t run_list(std::pmr::memory_resource *r, int iters)
+{
+    std::pmr::list<Order> l(r);
+    std::uint64_t sum = 0;
+    for (int i = 0; i < iters; ++i)
+    {
+        l.push_back(Order{static_cast<std::uint64_t>(i), i, 1, 0});
+        if (l.size() > 256)
+        {
+            sum += l.front().id;
+            l.pop_front();
+        }
+    }
+    return sum;
+}
+
+// --- resources: built fresh per repetition so every run starts cold ---
+
+struct Resource
+{
+    std::unique_ptr<ArenaAllocator> arena;
+    std::unique_ptr<PoolAllocator> pool;
+    std::unique_ptr<SizeClassPool<>> classes;
+    std::unique_ptr<std::pmr::memory_resource> res;
+    std::pmr::memory_resource *ptr = nullptr;
+};
+
+static bool make_resource(const std::string &name, int iters, Resource &out)
+{
+    if (name == "new")
+    {
+        out.ptr = std::pmr::new_delete_resource();
+    }
+    else if (name == "monotonic")
+    {
+        out.res = std::make_unique<std::pmr::monotonic_buffer_resource>(1 << 20);
+        out.ptr = out.res.get();
+    }
+    else if (name == "unsync")
+    {
+        out.res = std::make_unique<std::pmr::unsynchronized_pool_resource>();
+        out.ptr = out.res.get();
+    }
+    else if (name == "arena")
+    {
+        ArenaOptions ao;
+        ao.initial_chunk_size = 1 << 20;
+        ao.headerless = true;
+        out.arena = std::make_unique<ArenaAllocator>(ao);
+        out.res = std::make_unique<ArenaResource>(*out.arena);
+        out.ptr = out.res.get();
+    }
+    else if (name == "tls")
+    {
+        ThreadLocalArena::instance().reset();
+        out.ptr = ThreadLocalArenaResource::instance();
+    }
+    else if (name == "pool")
+    {
+        // node containers: one block per node, the rest (vector storage, buckets) upstream
+        out.pool = std::make_unique<PoolAllocator>(64, static_cast<std::size_t>(iters) + 1024);
+        out.res = std::make_unique<PoolResource<>>(*out.pool);
+        out.ptr = out.res.get();
+    }
+    else if (name == "sizeclass")
+    {
+        out.classes = std::make_unique<SizeClassPool<>>(1024, 4096);
+        out.res = std::make_unique<SizeClassResource<>>(*out.classes);
+        out.ptr = out.res.get();
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const Opts o = parse(argc, argv);
+    std::printf("%-8s %-10s %12s %10s\n", "workload", "resource", "best_ns", "ns/op");
+    std::uint64_t sink = 0;
+    for (const auto &w : o.workloads)
+    {
+        std::function<std::uint64_t(std::pmr::memory_resource *, int)> body;
+        if (w == "vector")
+            body = run_vector;
+        else if (w == "book")
+            body = run_book;
+        else if (w == "list")
+            body = run_list;
+        else
+        {
+            std::fprintf(stderr, "unknown workload %s\n", w.c_str());
+            return 1;
+        }
+
+        for (const auto &name : o.resources)
+        {
+            std::int64_t best = INT64_MAX;
+            for (int rep = 0; rep < o.reps; ++rep)
+            {
+                Resource r;
+                if (!make_resource(name, o.iters, r))
+                {
+                    std::fprintf(stderr, "unknown resource %s\n", name.c_str());
+                    return 1;
+                }
+                const auto t0 = Clock::now();
+                sink += body(r.ptr, o.iters);
+                const auto t1 = Clock::now();
+                best = std::min<std::int64_t>(best, std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+            }
+            std::printf("%-8s %-10s %12lld %10.2f\n", w.c_str(), name.c_str(), static_cast<long long>(best),
+                        static_cast<double>(best) / o.iters);
+        }
+    }
+    std::fprintf(stderr, "checksum %llu\n", static_cast<unsigned long long>(sink));
+    return 0;
+}
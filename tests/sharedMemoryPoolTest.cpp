@@ -0,0 +1,224 @@
+#include "allocators/sharedMemoryPool.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+static void require(bool cond, const char *msg)
+{
+    if (!cond)
+    {
+        std::cerr << "[TEST] " << msg << "\n";
+        std::abort();
+    }
+}
+
+struct Msg
+{
+    std::uint64_t seq;
+    char text[48];
+};
+
+static std::string uniqueName(const char *tag)
+{
+    return std::string("/finalloc-test-") + tag + "-" + std::to_string(::getpid());
+}
+
+static void test_named_region()
+{
+    std::cout << "[A] named region: two mappings, handles, shared counters\n";
+    const std::string name = uniqueName("named");
+    SharedMemoryPool::unlink(name);
+    {
+        SharedMemoryPool a = SharedMemoryPool::create(name, sizeof(Msg), 64);
+        SharedMemoryPool b = SharedMemoryPool::open(name); // second mapping, other address
+        require(a.region() != b.region(), "A: expected two distinct mappings");
+        require(b.capacity() == 64 && b.objectSize() == sizeof(Msg) && b.stride() % 64 == 0, "A: layout");
+
+        auto *m = static_cast<Msg *>(a.allocate());
+        m->seq = 42;
+        std::strcpy(m->text, "fill 100@99.5");
+        const auto h = a.handleOf(m);
+        auto *seen = static_cast<Msg *>(b.at(h)); // zero copy
+        require(seen != m && seen->seq == 42 && std::strcmp(seen->text, "fill 100@99.5") == 0, "A: payload");
+        b.deallocate(seen);
+        require(a.used() == 0 && a.getStats().free_calls == 1, "A: counters are shared");
+        require(a.allocateHandle() == h, "A: freed slot reused");
+
+        std::vector<SharedMemoryPool::Handle> all;
+        while (true)
+        {
+            const auto x = b.allocateHandle();
+            if (x == SharedMemoryPool::kNullHandle)
+                break;
+            all.push_back(x);
+        }
+        require(all.size() == 63 && a.getStats().alloc_failures == 1, "A: exhaustion");
+        require(std::set<SharedMemoryPool::Handle>(all.begin(), all.end()).size() == all.size(), "A: duplicates");
+        require(!a.owns(reinterpret_cast<char *>(a.at(0)) + 1) && a.at(64) == nullptr, "A: bounds");
+
+        bool threw = false;
+        try
+        {
+            SharedMemoryPool::create(name, 8, 8);
+        }
+        catch (const std::system_error &)
+        {
+            threw = true;
+        }
+        require(threw, "A: create must not clobber an existing region");
+    }
+    require(SharedMemoryPool::unlink(name), "A: unlink");
+    bool threw = false;
+    try
+    {
+        SharedMemoryPool::open(name);
+    }
+    catch (const std::system_error &)
+    {
+        threw = true;
+    }
+    require(threw, "A: open of a missing region");
+}
+
+static void test_fork()
+{
+    std::cout << "[B] across fork(): producer child, consumer parent, concurrent churn\n";
+    SharedMemoryPool pool = SharedMemoryPool::anonymous(sizeof(Msg), 256);
+    constexpr int N = 2000;
+    int fds[2];
+    require(::pipe(fds) == 0, "B: pipe");
+    const pid_t pid = ::fork();
+    require(pid >= 0, "B: fork");
+    if (pid == 0)
+    {
+        ::close(fds[0]);
+        for (int i = 0; i < N; ++i)
+        {
+            SharedMemoryPool::Handle h;
+            while ((h = pool.allocateHandle()) == SharedMemoryPool::kNullHandle)
+                std::this_thread::yield(); // consumer is behind
+            auto *m = static_cast<Msg *>(pool.at(h));
+            m->seq = static_cast<std::uint64_t>(i);
+            std::snprintf(m->text, sizeof(m->text), "msg %d", i);
+            if (::write(fds[1], &h, sizeof(h)) != sizeof(h)) // only the handle crosses
+                ::_exit(2);
+        }
+        ::close(fds[1]);
+        ::_exit(0);
+    }
+    ::close(fds[1]);
+    int got = 0;
+    SharedMemoryPool::Handle h;
+    char expect[48];
+    while (::read(fds[0], &h, sizeof(h)) == sizeof(h))
+    {
+        auto *m = static_cast<Msg *>(pool.at(h));
+        std::snprintf(expect, sizeof(expect), "msg %d", got);
+        require(m && m->seq == static_cast<std::uint64_t>(got) && std::strcmp(m->text, expect) == 0, "B: message");
+        pool.deallocateHandle(h);
+        ++got;
+    }
+    ::close(fds[0]);
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    require(WIFEXITED(status) && WEXITSTATUS(status) == 0 && got == N, "B: producer");
+    require(pool.used() == 0 && pool.getStats().alloc_calls >= N, "B: counters across processes");
+
+    // both processes hammer the same free list; a slot is never owned twice
+    std::vector<SharedMemoryPool::Handle> all;
+    for (auto x = pool.allocateHandle(); x != SharedMemoryPool::kNullHandle; x = pool.allocateHandle())
+    {
+        static_cast<Msg *>(pool.at(x))->seq = 0; // owner tag, 0 = free
+        all.push_back(x);
+    }
+    for (auto x : all)
+        pool.deallocateHandle(x);
+    SharedMemoryPool flags = SharedMemoryPool::anonymous(sizeof(std::uint32_t), 1);
+    auto *bad = static_cast<std::atomic<std::uint32_t> *>(flags.allocate());
+    bad->store(0);
+    const pid_t churn = ::fork();
+    require(churn >= 0, "B: fork 2");
+    const std::uint32_t me = churn == 0 ? 2 : 1;
+    for (int i = 0; i < 20000; ++i)
+    {
+        const auto x = pool.allocateHandle();
+        if (x == SharedMemoryPool::kNullHandle)
+            continue;
+        auto *m = static_cast<Msg *>(pool.at(x));
+        auto *tag = reinterpret_cast<std::atomic<std::uint64_t> *>(&m->seq);
+        if (tag->exchange(me) != 0)
+            bad->fetch_add(1);
+        tag->store(0);
+        pool.deallocateHandle(x);
+    }
+    if (churn == 0)
+        ::_exit(0);
+    ::waitpid(churn, &status, 0);
+    require(WIFEXITED(status) && bad->load() == 0, "B: a block was handed to both processes");
+    require(pool.used() == 0, "B: churn leaked blocks");
+}
+
+static void test_snapshot()
+{
+    std::cout << "[C] snapshot to a file and map it back\n";
+    char path[] = "/tmp/finalloc-shm-snapXXXXXX";
+    const int fd = ::mkstemp(path);
+    require(fd >= 0, "C: mkstemp");
+    ::close(fd);
+
+    SharedMemoryPool pool = SharedMemoryPool::anonymous(sizeof(Msg), 32);
+    std::vector<SharedMemoryPool::Handle> live;
+    for (int i = 0; i < 10; ++i)
+    {
+        const auto h = pool.allocateHandle();
+        static_cast<Msg *>(pool.at(h))->seq = 1000 + static_cast<std::uint64_t>(i);
+        live.push_back(h);
+    }
+    pool.deallocateHandle(live[3]);
+    require(pool.snapshot(path), "C: snapshot");
+
+    SharedMemoryPool back = SharedMemoryPool::openFile(path);
+    require(back.capacity() == 32 && back.used() == 9, "C: state restored");
+    for (int i = 0; i < 10; ++i)
+        if (i != 3)
+            require(static_cast<Msg *>(back.at(live[i]))->seq == 1000 + static_cast<std::uint64_t>(i), "C: payload");
+    require(back.allocateHandle() == live[3], "C: free list restored");
+
+    // a file that is not a pool is rejected
+    std::FILE *f = std::fopen(path, "w");
+    std::fputs(std::string(4096, 'x').c_str(), f);
+    std::fclose(f);
+    bool threw = false;
+    try
+    {
+        SharedMemoryPool::openFile(path);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    require(threw, "C: garbage accepted as a pool");
+    std::remove(path);
+}
+
+int main()
+{
+    std::cout << "\n==== sharedMemoryPoolTest ====\n";
+    test_named_region();
+    test_fork();
+    test_snapshot();
+    std::cout << "[OK] sharedMemoryPoolTest passed.\n";
+    return 0;
+}
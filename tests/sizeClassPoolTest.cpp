@@ -0,0 +1,240 @@
+#include "allocators/sizeClassPool.hpp"
+#include "allocators/poolAllocator.hpp"
+#include "utils/allocStats.hpp"
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static void require(bool cond, const char *msg)
+{
+    if (!cond)
+    {
+        std::cerr << "[TEST] " << msg << "\n";
+        std::abort();
+    }
+}
+
+static void test_class_table()
+{
+    std::cout << "[A] size-class table lookup\n";
+    // the O(1) table must agree with a linear "first class that fits" scan
+    for (std::size_t size = 0; size <= size_class::kMaxSize; ++size)
+    {
+        std::size_t expect = 0;
+        while (size_class::kSizes[expect] < size)
+            ++expect;
+        require(size_class::indexFor(size) == expect, "A: table lookup disagrees with linear scan");
+    }
+    for (std::size_t i = 1; i < size_class::kCount; ++i)
+        require(size_class::kSizes[i] > size_class::kSizes[i - 1], "A: classes must be increasing");
+
+    // finer than power-of-two rounding
+    require(SizeClassPool<>::classSize(65) == 80, "A: 65 should round to 80, not 128");
+    require(SizeClassPool<>::classSize(520) == 640, "A: 520 should round to 640, not 1024");
+}
+
+static void test_growth()
+{
+    std::cout << "[B] buckets grow instead of failing\n";
+    SizeClassPool<> pool(/*maxSize*/ 512, /*objectsPerClass*/ 16);
+    std::vector<void *> live;
+    for (int i = 0; i < 1000; ++i)
+    {
+        void *p = pool.allocate(40);
+        require(p != nullptr, "B: allocation failed past the first slab");
+        std::memset(p, 0x5A, 40);
+        live.push_back(p);
+    }
+    require(pool.slabCount(40) > 1, "B: expected more than one slab");
+    require(pool.slabCount(40) < 10, "B: slab growth should be geometric");
+    require(std::set<void *>(live.begin(), live.end()).size() == live.size(), "B: duplicate pointers");
+
+    // frees are routed to the owning slab; the space is reused without growing
+    const std::size_t slabs = pool.slabCount(40);
+    for (void *p : live)
+        pool.deallocate(p, 40);
+    for (int i = 0; i < 1000; ++i)
+        live[i] = pool.allocate(40);
+    require(pool.slabCount(40) == slabs, "B: reuse after free must not grow");
+    for (void *p : live)
+        pool.deallocate(p, 40);
+
+    require(pool.allocate(513) == nullptr, "B: sizes above maxSize are rejected");
+}
+
+static void test_bulk()
+{
+    std::cout << "[C] bulk across slabs\n";
+    SizeClassPool<> pool(1024, 32);
+    std::vector<void *> out(200);
+    require(pool.allocateBulk(100, out.data(), out.size()) == out.size(), "C: bulk alloc short");
+    require(pool.slabCount(100) > 1, "C: bulk alloc should have grown the bucket");
+    require(std::set<void *>(out.begin(), out.end()).size() == out.size(), "C: duplicate pointers");
+    pool.deallocateBulk(out.data(), out.size(), 100);
+    require(pool.allocateBulk(100, out.data(), out.size()) == out.size(), "C: bulk realloc short");
+    pool.deallocateBulk(out.data(), out.size(), 100);
+}
+
+static void test_concurrent()
+{
+    std::cout << "[D] concurrent init + growth (LockFreePoolAllocator buckets)\n";
+    constexpr int THREADS = 8;
+    constexpr int PER_THREAD = 600;
+    SizeClassPool<LockFreePoolAllocator> pool(4096, 64);
+
+    std::atomic<bool> go{false};
+    std::atomic<int> allocated{0};
+    std::vector<std::vector<void *>> got(THREADS);
+    std::vector<std::thread> ths;
+    for (int t = 0; t < THREADS; ++t)
+    {
+        ths.emplace_back([&, t]
+                         {
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int i = 0; i < PER_THREAD; ++i) {
+                const std::size_t size = 16 + (i % 8) * 100;
+                void* p = pool.allocate(size);
+                require(p != nullptr, "D: concurrent alloc failed");
+                std::memset(p, t, size);
+                got[t].push_back(p);
+            }
+            // hold everything until all threads are done so duplicates are detectable
+            allocated.fetch_add(1, std::memory_order_acq_rel);
+            while (allocated.load(std::memory_order_acquire) < THREADS) std::this_thread::yield();
+            for (int i = 0; i < PER_THREAD; ++i)
+                pool.deallocate(got[t][i], 16 + (i % 8) * 100); });
+    }
+    go.store(true, std::memory_order_release);
+    for (auto &th : ths)
+        th.join();
+
+    std::set<void *> all; // threads stored their pointers before freeing them
+    for (auto &v : got)
+        all.insert(v.begin(), v.end());
+    require(all.size() == static_cast<std::size_t>(THREADS * PER_THREAD), "D: pointer handed out twice");
+}
+
+static void test_slab_color()
+{
+    std::cout << "[E] per-slab coloring\n";
+    PoolOptions o;
+    o.backing = PoolBacking::Mmap; // page-aligned slabs, so the color is the page offset
+    o.color_step = 64;
+    SizeClassPool<> pool(256, 16, o);
+    std::vector<void *> live;
+    for (int i = 0; i < 16 + 32 + 64; ++i) // fill the first three slabs (16, 32, 64 objects)
+        live.push_back(pool.allocate(64));
+    require(pool.slabCount(64) == 3, "E: expected three slabs");
+    auto pageOffset = [](void *p)
+    { return reinterpret_cast<std::uintptr_t>(p) % 4096; };
+    // each slab's first block is handed out right after the slab is created
+    require(pageOffset(live[0]) == 0 && pageOffset(live[16]) == 64 && pageOffset(live[48]) == 128,
+            "E: slabs should start at page offsets 0, 64, 128");
+    for (void *p : live)
+        pool.deallocate(p, 64);
+    for (void *&p : live)
+        p = pool.allocate(64);
+    require(pool.slabCount(64) == 3, "E: coloring broke free routing");
+    for (void *p : live)
+        pool.deallocate(p, 64);
+}
+
+// alloc_calls / alloc_failures summed over every slab registered under name
+static void slabCounters(const char *name, std::uint64_t &calls, std::uint64_t &failures)
+{
+    calls = failures = 0;
+    for (const auto &s : alloc_stats::sampleAll())
+        if (std::string(s.name) == name)
+        {
+            calls += s.alloc_calls;
+            failures += s.alloc_failures;
+        }
+}
+
+template <class Pool>
+static void countAcrossSlabs(const char *name)
+{
+    PoolOptions o;
+    o.stats_name = name;
+    Pool pool(256, 8, o);
+    std::vector<void *> live;
+    for (int i = 0; i < 8 + 16 + 32 + 64; ++i) // every slab runs dry before the next one is made
+        live.push_back(pool.allocate(48));
+    require(pool.slabCount(48) == 4, "F: expected four slabs");
+    for (std::size_t i = 0; i < live.size(); i += 2) // holes in every slab, the oldest ones first
+        pool.deallocate(live[i], 48);
+    for (std::size_t i = 0; i < live.size(); i += 2)
+        live[i] = pool.allocate(48);
+    std::uint64_t calls = 0, failures = 0;
+    slabCounters(name, calls, failures);
+    require(failures == 0, "F: a dry slab counted an alloc_failure the caller never saw");
+    require(calls == live.size() + live.size() / 2, "F: alloc_calls should match the caller's allocations");
+    for (void *p : live)
+        pool.deallocate(p, 48);
+}
+
+// Runs fn in a child; true if the child aborted.
+template <typename F>
+static bool aborts_in_child(F &&fn)
+{
+    std::cout.flush(); // the child must not repeat buffered output
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        std::freopen("/dev/null", "w", stderr); // keep the expected [ERROR] out of the log
+        fn();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+static void test_counters_and_misuse()
+{
+    std::cout << "[F] slab-chain misses are not failures; foreign frees abort\n";
+    countAcrossSlabs<SizeClassPool<>>("scp-F-pool");
+    countAcrossSlabs<SizeClassPool<LockFreePoolAllocator>>("scp-F-lockfree");
+
+    require(aborts_in_child([]
+                     {
+                         SizeClassPool<> pool(256, 8);
+                         alignas(16) static char foreign[64];
+                         pool.deallocate(foreign, 48); }),
+            "F: foreign pointer was dropped");
+    require(aborts_in_child([]
+                     {
+                         SizeClassPool<> pool(256, 8);
+                         void *p = pool.allocate(48);
+                         pool.deallocate(p, 200); }),
+            "F: pointer freed with the wrong size class was dropped");
+    require(aborts_in_child([]
+                     {
+                         SizeClassPool<> pool(256, 8);
+                         void *p = pool.allocate(48);
+                         pool.deallocate(p, 4096); }),
+            "F: pointer freed with a size above maxSize was dropped");
+}
+
+int main()
+{
+    std::cout << "\n==== sizeClassPoolTest ====\n";
+    test_class_table();
+    test_growth();
+    test_bulk();
+    test_concurrent();
+    test_slab_color();
+    test_counters_and_misuse();
+    std::cout << "[OK] sizeClassPoolTest passed.\n";
+    return 0;
+}